@@ -0,0 +1,322 @@
+#include <string.h>
+#include <collect/chashmap.h>
+#include <dbg.h>
+
+#define LOAD(P) __atomic_load_n((P), __ATOMIC_RELAXED)
+#define STORE(P, V) __atomic_store_n((P), (V), __ATOMIC_RELAXED)
+
+#if defined(__x86_64__) || defined(__i386__)
+#define cpu_relax() __builtin_ia32_pause()
+#else
+#define cpu_relax() do {} while(0)
+#endif
+
+
+static int default_compare(void *a, void *b)
+{
+    return strcmp((char *)a, (char *)b);
+}
+
+/// hash 0 marks an empty slot, so real hashes never use it
+static inline uint64_t CHashmap_hash_key(CHashmap *map, void *key)
+{
+    uint64_t hash = map->hash(key);
+    return hash != 0 ? hash : 1;
+}
+
+static inline CHashmapStripe *CHashmap_stripe(CHashmap *map, uint64_t hash)
+{
+    // low bits pick the slot within a stripe.  Multiplying first spreads
+    // every bit of the hash into the ones picking the stripe, so hashes
+    // that only fill their low 32 bits still use every stripe.
+    hash *= 0x9e3779b97f4a7c15ull;
+    return &map->stripes[(hash >> 32) & (map->stripe_count - 1)];
+}
+
+static CHashmapTable *CHashmapTable_create(size_t capacity)
+{
+    CHashmapTable *table = calloc(1, sizeof(CHashmapTable) +
+            capacity * sizeof(CHashmapSlot));
+    check_mem(table);
+    table->capacity = capacity;
+    return table;
+error:
+    return NULL;
+}
+
+static inline void CHashmapStripe_write_begin(CHashmapStripe *stripe)
+{
+    STORE(&stripe->seq, stripe->seq + 1);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void CHashmapStripe_write_end(CHashmapStripe *stripe)
+{
+    __atomic_store_n(&stripe->seq, stripe->seq + 1, __ATOMIC_RELEASE);
+}
+
+static inline void CHashmapSlot_copy(CHashmapSlot *to, CHashmapSlot *from)
+{
+    STORE(&to->key, from->key);
+    STORE(&to->data, from->data);
+    STORE(&to->hash, from->hash);
+}
+
+
+CHashmap *CHashmap_create(Hashmap_compare compare, Hashmap_hash hash,
+        int stripes)
+{
+    int i = 0;
+    int count = 1;
+    void *mem = NULL;
+    CHashmap *map = calloc(1, sizeof(CHashmap));
+    check_mem(map);
+
+    if(stripes < 1) {
+        stripes = CHASHMAP_DEFAULT_STRIPES;
+    }
+    while(count < stripes) {
+        count *= 2;
+    }
+
+    map->compare = compare == NULL ? default_compare : compare;
+    map->hash = hash == NULL ? Hashmap_default_hash : hash;
+
+    // stripes are cache line aligned so neighbouring locks don't false share
+    check(posix_memalign(&mem, sizeof(CHashmapStripe),
+                count * sizeof(CHashmapStripe)) == 0,
+            "Failed to allocate CHashmap stripes.");
+    memset(mem, 0, count * sizeof(CHashmapStripe));
+    map->stripes = mem;
+
+    for(i = 0; i < count; i++) {
+        CHashmapStripe *stripe = &map->stripes[i];
+        check(pthread_mutex_init(&stripe->lock, NULL) == 0,
+                "Failed to initialize stripe lock.");
+        stripe->table = CHashmapTable_create(CHASHMAP_MIN_STRIPE_SLOTS);
+        check_mem(stripe->table);
+        map->stripe_count = i + 1;
+    }
+
+    return map;
+
+error:
+    if(map) {
+        CHashmap_destroy(map);
+    }
+    return NULL;
+}
+
+void CHashmap_destroy(CHashmap *map)
+{
+    int i = 0;
+    if(map == NULL) {
+        return;
+    }
+
+    for(i = 0; i < map->stripe_count; i++) {
+        CHashmapStripe *stripe = &map->stripes[i];
+        CHashmapTable *table = stripe->table;
+        while(table != NULL) {
+            CHashmapTable *retired = table->retired;
+            free(table);
+            table = retired;
+        }
+        pthread_mutex_destroy(&stripe->lock);
+    }
+
+    free(map->stripes);
+    free(map);
+}
+
+
+/// slot holding key in table, or -1.  Caller holds the stripe lock.
+static long CHashmapTable_find(CHashmap *map, CHashmapTable *table,
+        void *key, uint64_t hash)
+{
+    size_t mask = table->capacity - 1;
+    size_t i = hash & mask;
+
+    while(table->slots[i].hash != 0) {
+        if(table->slots[i].hash == hash &&
+                map->compare(table->slots[i].key, key) == 0) {
+            return (long)i;
+        }
+        i = (i + 1) & mask;
+    }
+    return -1;
+}
+
+/// move every entry into a table twice the size.  Caller holds the stripe
+/// lock and has begun a write.
+static int CHashmapStripe_grow(CHashmapStripe *stripe)
+{
+    CHashmapTable *old = stripe->table;
+    CHashmapTable *table = CHashmapTable_create(old->capacity * 2);
+    check_mem(table);
+
+    size_t mask = table->capacity - 1;
+    size_t i = 0;
+    for(i = 0; i < old->capacity; i++) {
+        if(old->slots[i].hash != 0) {
+            size_t j = old->slots[i].hash & mask;
+            while(table->slots[j].hash != 0) {
+                j = (j + 1) & mask;
+            }
+            table->slots[j] = old->slots[i];
+        }
+    }
+
+    table->retired = old;
+    __atomic_store_n(&stripe->table, table, __ATOMIC_RELEASE);
+    return 0;
+error:
+    return -1;
+}
+
+
+int CHashmap_set(CHashmap *map, void *key, void *data)
+{
+    uint64_t hash = CHashmap_hash_key(map, key);
+    CHashmapStripe *stripe = CHashmap_stripe(map, hash);
+    int rc = -1;
+
+    pthread_mutex_lock(&stripe->lock);
+    CHashmapStripe_write_begin(stripe);
+
+    long found = CHashmapTable_find(map, stripe->table, key, hash);
+    if(found >= 0) {
+        STORE(&stripe->table->slots[found].data, data);
+        rc = 0;
+        goto done;
+    }
+
+    // keep at least a quarter of the slots empty so probes stay short
+    if((stripe->count + 1) * 4 > stripe->table->capacity * 3) {
+        check(CHashmapStripe_grow(stripe) == 0, "Failed to grow stripe.");
+    }
+
+    CHashmapTable *table = stripe->table;
+    size_t mask = table->capacity - 1;
+    size_t i = hash & mask;
+    while(table->slots[i].hash != 0) {
+        i = (i + 1) & mask;
+    }
+    STORE(&table->slots[i].key, key);
+    STORE(&table->slots[i].data, data);
+    STORE(&table->slots[i].hash, hash);
+    __atomic_add_fetch(&stripe->count, 1, __ATOMIC_RELAXED);
+    rc = 0;
+
+done:
+error:
+    CHashmapStripe_write_end(stripe);
+    pthread_mutex_unlock(&stripe->lock);
+    return rc;
+}
+
+
+void *CHashmap_get(CHashmap *map, void *key)
+{
+    uint64_t hash = CHashmap_hash_key(map, key);
+    CHashmapStripe *stripe = CHashmap_stripe(map, hash);
+
+    while(1) {
+        unsigned int seq = __atomic_load_n(&stripe->seq, __ATOMIC_ACQUIRE);
+        if(seq & 1) {
+            // a writer is mid-update
+            cpu_relax();
+            continue;
+        }
+
+        CHashmapTable *table = __atomic_load_n(&stripe->table,
+                __ATOMIC_ACQUIRE);
+        size_t mask = table->capacity - 1;
+        size_t i = hash & mask;
+        size_t probes = 0;
+        void *result = NULL;
+
+        // the probe limit only matters if a racing writer tore the view
+        for(probes = 0; probes < table->capacity; probes++) {
+            uint64_t slot_hash = LOAD(&table->slots[i].hash);
+            if(slot_hash == 0) {
+                break;
+            }
+            if(slot_hash == hash) {
+                void *slot_key = LOAD(&table->slots[i].key);
+                if(slot_key != NULL && map->compare(slot_key, key) == 0) {
+                    result = LOAD(&table->slots[i].data);
+                    break;
+                }
+            }
+            i = (i + 1) & mask;
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if(LOAD(&stripe->seq) == seq) {
+            return result;
+        }
+    }
+}
+
+
+void *CHashmap_delete(CHashmap *map, void *key)
+{
+    uint64_t hash = CHashmap_hash_key(map, key);
+    CHashmapStripe *stripe = CHashmap_stripe(map, hash);
+    void *data = NULL;
+
+    pthread_mutex_lock(&stripe->lock);
+
+    CHashmapTable *table = stripe->table;
+    long found = CHashmapTable_find(map, table, key, hash);
+    if(found < 0) {
+        pthread_mutex_unlock(&stripe->lock);
+        return NULL;
+    }
+
+    CHashmapStripe_write_begin(stripe);
+    data = table->slots[found].data;
+
+    // backward shift deletion: pull later entries of the cluster into the
+    // hole unless that would move them before their home slot
+    size_t mask = table->capacity - 1;
+    size_t i = (size_t)found;
+    size_t j = i;
+    while(1) {
+        STORE(&table->slots[i].hash, 0);
+        while(1) {
+            j = (j + 1) & mask;
+            if(table->slots[j].hash == 0) {
+                goto done;
+            }
+            size_t home = table->slots[j].hash & mask;
+            int stays = i <= j ? (i < home && home <= j) :
+                (i < home || home <= j);
+            if(!stays) {
+                break;
+            }
+        }
+        CHashmapSlot_copy(&table->slots[i], &table->slots[j]);
+        i = j;
+    }
+
+done:
+    STORE(&table->slots[i].key, NULL);
+    STORE(&table->slots[i].data, NULL);
+    __atomic_sub_fetch(&stripe->count, 1, __ATOMIC_RELAXED);
+    CHashmapStripe_write_end(stripe);
+    pthread_mutex_unlock(&stripe->lock);
+    return data;
+}
+
+
+size_t CHashmap_count(CHashmap *map)
+{
+    size_t count = 0;
+    int i = 0;
+    for(i = 0; i < map->stripe_count; i++) {
+        count += LOAD(&map->stripes[i].count);
+    }
+    return count;
+}
@@ -0,0 +1,72 @@
+#ifndef _CHashmap_h
+#define _CHashmap_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <collect/hashmap.h>
+
+#define CHASHMAP_DEFAULT_STRIPES 64
+#define CHASHMAP_MIN_STRIPE_SLOTS 16
+
+typedef struct CHashmapSlot {
+    uint64_t hash;
+    void *key;
+    void *data;
+} CHashmapSlot;
+
+/// One generation of a stripe's slots.  Replaced tables are kept on the
+/// retired chain until the map is destroyed, since a reader may still be
+/// probing them.
+typedef struct CHashmapTable {
+    struct CHashmapTable *retired;
+    size_t capacity;
+    CHashmapSlot slots[];
+} CHashmapTable;
+
+/// A linear probing table guarded by its own lock and sequence counter.
+typedef struct CHashmapStripe {
+    pthread_mutex_t lock;
+    unsigned int seq;
+    size_t count;
+    CHashmapTable *table;
+} __attribute__((aligned(64))) CHashmapStripe;
+
+/// A hash map for many threads with striped writes and lock-free reads.
+/**
+ * Keys are spread over a power of two number of stripes by their hash.
+ * Writers take the stripe's mutex and bump its sequence counter to odd
+ * while they modify it.  Readers never lock: they read the counter, probe,
+ * and retry if the counter was odd or changed underneath them (a seqlock).
+ * Writers to different stripes never contend, and readers never block
+ * writers.
+ *
+ * A reader may briefly see a key that is being deleted and pass it to the
+ * compare callback, so keys must stay valid until no CHashmap_get that
+ * could have seen them is still running.
+ */
+typedef struct CHashmap {
+    CHashmapStripe *stripes;
+    int stripe_count;
+    Hashmap_compare compare;
+    Hashmap_hash hash;
+} CHashmap;
+
+/// Allocate a map.  NULL compare or hash select the Hashmap defaults, and
+/// stripes below 1 select CHASHMAP_DEFAULT_STRIPES.  stripes is rounded up
+/// to a power of two.
+CHashmap *CHashmap_create(Hashmap_compare compare, Hashmap_hash hash,
+        int stripes);
+void CHashmap_destroy(CHashmap *map);
+
+/// Insert or replace the data stored under key, which must not be NULL.
+int CHashmap_set(CHashmap *map, void *key, void *data);
+void *CHashmap_get(CHashmap *map, void *key);
+
+/// Remove key, returning the data that was stored under it.
+void *CHashmap_delete(CHashmap *map, void *key);
+
+/// Number of keys, summed over the stripes without locking them.
+size_t CHashmap_count(CHashmap *map);
+
+#endif
@@ -0,0 +1,245 @@
+/*
+ * Index linked list in a single node array.
+ * Copyright (C) 2014 Axel Magnuson <axelmagn@gmail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <collect/compact_list.h>
+#include <dbg.h>
+
+
+/// Allocate a new list with room for capacity nodes before it grows.
+CompactList *CompactList_create(uint32_t capacity)
+{
+	CompactList *list = calloc(1, sizeof(CompactList));
+	check_mem(list);
+	list->first = COMPACT_LIST_NIL;
+	list->last = COMPACT_LIST_NIL;
+	list->free_nodes = COMPACT_LIST_NIL;
+
+	if(capacity < COMPACT_LIST_MIN_CAPACITY) {
+		capacity = COMPACT_LIST_MIN_CAPACITY;
+	}
+	check(CompactList_reserve(list, capacity) == 0,
+			"Failed to allocate CompactList nodes.");
+	return list;
+
+error:
+	if(list) { free(list); }
+	return NULL;
+}
+
+
+/// Free a list and its node array, but not its values.
+void CompactList_destroy(CompactList *list)
+{
+	free(list->nodes);
+	free(list);
+}
+
+
+/// Free all values contained by the list.
+void CompactList_clear(CompactList *list)
+{
+	COMPACT_LIST_FOREACH(list, first, next, cur) {
+		free(list->nodes[cur].value);
+	}
+}
+
+
+/// Free a list, its node array, and any values it contains.
+void CompactList_clear_destroy(CompactList *list)
+{
+	CompactList_clear(list);
+	CompactList_destroy(list);
+}
+
+
+/// Grow the node array to hold at least capacity nodes.
+int CompactList_reserve(CompactList *list, uint32_t capacity)
+{
+	check(capacity <= COMPACT_LIST_MAX_NODES,
+			"CompactList can't hold %u nodes.", capacity);
+	if(capacity <= list->capacity) {
+		return 0;
+	}
+
+	CompactNode *nodes = realloc(list->nodes, capacity * sizeof(CompactNode));
+	check_mem(nodes);
+	list->nodes = nodes;
+	list->capacity = capacity;
+	return 0;
+
+error:
+	return -1;
+}
+
+
+/// take a node off the free list, or from the unused tail of the array.
+static uint32_t CompactList_alloc(CompactList *list, void *value)
+{
+	uint32_t node = list->free_nodes;
+
+	if(node != COMPACT_LIST_NIL) {
+		list->free_nodes = list->nodes[node].next;
+	} else {
+		if(list->used == list->capacity) {
+			// double, stopping where count would overflow
+			uint32_t capacity = list->capacity < COMPACT_LIST_MAX_NODES / 2 ?
+				list->capacity * 2 : COMPACT_LIST_MAX_NODES;
+			check(capacity > list->capacity, "CompactList is full.");
+			check(CompactList_reserve(list, capacity) == 0,
+					"Failed to grow CompactList.");
+		}
+		node = list->used++;
+	}
+
+	list->nodes[node].value = value;
+	list->nodes[node].next = COMPACT_LIST_NIL;
+	list->nodes[node].prev = COMPACT_LIST_NIL;
+	return node;
+
+error:
+	return COMPACT_LIST_NIL;
+}
+
+
+/// index of the node at a position, or COMPACT_LIST_NIL if out of bounds.
+uint32_t CompactList_get_node(CompactList *list, int position)
+{
+	uint32_t node = COMPACT_LIST_NIL;
+	int i;
+
+	check(position >= 0 && position < list->count,
+			"CompactList size is %d.  Index %d out of bounds.",
+			list->count, position);
+
+	// seek from whichever side is closest
+	if(position <= list->count / 2) {
+		node = list->first;
+		for(i = 0; i < position; i++) {
+			node = list->nodes[node].next;
+		}
+	} else {
+		node = list->last;
+		for(i = list->count - 1; i > position; i--) {
+			node = list->nodes[node].prev;
+		}
+	}
+
+error:
+	return node;
+}
+
+
+/// retrieve the value stored at a position.
+void *CompactList_get(CompactList *list, int position)
+{
+	uint32_t node = CompactList_get_node(list, position);
+	return node != COMPACT_LIST_NIL ? list->nodes[node].value : NULL;
+}
+
+
+/// push a new value onto the end of the list, returning its node.
+uint32_t CompactList_push(CompactList *list, void *value)
+{
+	uint32_t node = CompactList_alloc(list, value);
+	check(node != COMPACT_LIST_NIL, "Failed to allocate CompactList node.");
+
+	list->nodes[node].prev = list->last;
+	if(list->last == COMPACT_LIST_NIL) {
+		list->first = node;
+	} else {
+		list->nodes[list->last].next = node;
+	}
+	list->last = node;
+	list->count++;
+
+error:
+	return node;
+}
+
+
+/// remove and return the end of the list.
+void *CompactList_pop(CompactList *list)
+{
+	return list->last != COMPACT_LIST_NIL ?
+		CompactList_remove(list, list->last) : NULL;
+}
+
+
+/// push a new value onto the beginning of the list, returning its node.
+uint32_t CompactList_unshift(CompactList *list, void *value)
+{
+	uint32_t node = CompactList_alloc(list, value);
+	check(node != COMPACT_LIST_NIL, "Failed to allocate CompactList node.");
+
+	list->nodes[node].next = list->first;
+	if(list->first == COMPACT_LIST_NIL) {
+		list->last = node;
+	} else {
+		list->nodes[list->first].prev = node;
+	}
+	list->first = node;
+	list->count++;
+
+error:
+	return node;
+}
+
+
+/// remove and return the beginning of the list.
+void *CompactList_shift(CompactList *list)
+{
+	return list->first != COMPACT_LIST_NIL ?
+		CompactList_remove(list, list->first) : NULL;
+}
+
+
+/// remove and return the value of a node.
+void *CompactList_remove(CompactList *list, uint32_t node)
+{
+	check(node < list->used, "Invalid CompactList node %u.", node);
+	check(list->count > 0, "List is empty.");
+
+	CompactNode *cur = &list->nodes[node];
+	if(cur->prev == COMPACT_LIST_NIL) {
+		list->first = cur->next;
+	} else {
+		list->nodes[cur->prev].next = cur->next;
+	}
+	if(cur->next == COMPACT_LIST_NIL) {
+		list->last = cur->prev;
+	} else {
+		list->nodes[cur->next].prev = cur->prev;
+	}
+	list->count--;
+
+	// recycle the slot
+	void *value = cur->value;
+	cur->value = NULL;
+	cur->prev = COMPACT_LIST_NIL;
+	cur->next = list->free_nodes;
+	list->free_nodes = node;
+	return value;
+
+error:
+	return NULL;
+}
@@ -0,0 +1,125 @@
+/*
+ * Index linked list in a single node array.
+ * Copyright (C) 2014 Axel Magnuson <axelmagn@gmail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef collect_Compact_list_h
+#define collect_Compact_list_h
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// the index that links to nothing
+#define COMPACT_LIST_NIL UINT32_MAX
+// positions and count are ints, which bounds the list well below NIL
+#define COMPACT_LIST_MAX_NODES INT_MAX
+#define COMPACT_LIST_MIN_CAPACITY 16
+
+/// A node of a CompactList, linked to its neighbours by array index.
+typedef struct CompactNode {
+	void *value;
+	uint32_t next;
+	uint32_t prev;
+} CompactNode;
+
+/// A doubly linked list whose nodes live in one growable array.
+/**
+ * Links are 32 bit indices into nodes, so a node is 16 bytes on 64 bit
+ * builds instead of a 24 byte ListNode plus its malloc header, and the
+ * whole list is a single allocation.  Removed nodes go onto a free list
+ * threaded through next and are reused before the array grows.
+ *
+ * Nodes are named by their index, which stays valid until the node is
+ * removed even when the array is reallocated.  A list holds at most
+ * COMPACT_LIST_MAX_NODES nodes.
+ */
+typedef struct CompactList {
+	CompactNode *nodes;
+	uint32_t capacity;
+	uint32_t used;
+	uint32_t free_nodes;
+	uint32_t first;
+	uint32_t last;
+	int count;
+} CompactList;
+
+
+/// Allocate a new list with room for capacity nodes before it grows.
+CompactList *CompactList_create(uint32_t capacity);
+
+/// Free a list and its node array, but not its values.
+void CompactList_destroy(CompactList *list);
+
+/// Free all values contained by the list.
+void CompactList_clear(CompactList *list);
+
+/// Free a list, its node array, and any values it contains.
+void CompactList_clear_destroy(CompactList *list);
+
+/// Grow the node array to hold at least capacity nodes.  Returns 0 on
+/// success, or -1 if capacity exceeds COMPACT_LIST_MAX_NODES.
+int CompactList_reserve(CompactList *list, uint32_t capacity);
+
+
+#define CompactList_count(A) ((A)->count)
+#define CompactList_node(A, I) (&(A)->nodes[(I)])
+#define CompactList_value(A, I) ((A)->nodes[(I)].value)
+#define CompactList_first(A) ((A)->first != COMPACT_LIST_NIL ? \
+		(A)->nodes[(A)->first].value : NULL)
+#define CompactList_last(A) ((A)->last != COMPACT_LIST_NIL ? \
+		(A)->nodes[(A)->last].value : NULL)
+
+
+/// index of the node at a position, or COMPACT_LIST_NIL if out of bounds.
+uint32_t CompactList_get_node(CompactList *list, int position);
+
+/// retrieve the value stored at a position.
+void *CompactList_get(CompactList *list, int position);
+
+
+/// push a new value onto the end of the list, returning its node.
+uint32_t CompactList_push(CompactList *list, void *value);
+
+/// remove and return the end of the list.
+void *CompactList_pop(CompactList *list);
+
+/// push a new value onto the beginning of the list, returning its node.
+uint32_t CompactList_unshift(CompactList *list, void *value);
+
+/// remove and return the beginning of the list.
+void *CompactList_shift(CompactList *list);
+
+/// remove and return the value of a node.
+void *CompactList_remove(CompactList *list, uint32_t node);
+
+
+/// convenience for loop iterating across a compact list.
+/**
+ * @param L the list to iterate on.
+ * @param S the side of the list to start on. (first|last)
+ * @param M the direction in which to move. (next|prev)
+ * @param V the name to use for the index of the current node.
+ */
+#define COMPACT_LIST_FOREACH(L, S, M, V) uint32_t V = 0;\
+	for(V = (L)->S; V != COMPACT_LIST_NIL; V = (L)->nodes[V].M)
+
+#endif
@@ -0,0 +1,159 @@
+#include <collect/darray.h>
+#include <assert.h>
+
+
+static DArray *DArray_alloc(size_t element_size, size_t initial_max,
+        int flags)
+{
+    DArray *array = malloc(sizeof(DArray));
+    check_mem(array);
+    check(initial_max > 0, "You must set an initial_max > 0.");
+    check(!(flags & DARRAY_INLINE) || element_size > 0,
+            "Inline darrays need an element_size > 0.");
+
+    array->max = initial_max;
+    array->min_max = initial_max;
+    array->flags = flags;
+    array->end = 0;
+    array->element_size = element_size;
+    array->expand_rate = DEFAULT_EXPAND_RATE;
+    array->data = calloc(initial_max, DArray_width(array));
+    check_mem(array->data);
+
+    return array;
+
+error:
+    if(array) free(array);
+    return NULL;
+}
+
+DArray *DArray_create(size_t element_size, size_t initial_max)
+{
+    return DArray_alloc(element_size, initial_max, 0);
+}
+
+DArray *DArray_create_inline(size_t element_size, size_t initial_max)
+{
+    return DArray_alloc(element_size, initial_max, DARRAY_INLINE);
+}
+
+void DArray_clear(DArray *array)
+{
+    int i = 0;
+    if(!DArray_is_inline(array) && array->element_size > 0) {
+        for(i = 0; i < array->end; i++) {
+            if(array->contents[i] != NULL) {
+                free(array->contents[i]);
+                array->contents[i] = NULL;
+            }
+        }
+    }
+    array->end = 0;
+}
+
+static inline int DArray_resize(DArray *array, size_t newsize)
+{
+    check(newsize > 0, "The newsize must be > 0.");
+
+    void *data = realloc(array->data, newsize * DArray_width(array));
+    // check data and assume realloc doesn't harm the original on error
+    check_mem(data);
+
+    array->max = newsize;
+    array->data = data;
+
+    return 0;
+error:
+    return -1;
+}
+
+int DArray_expand(DArray *array)
+{
+    size_t old_max = array->max;
+    size_t grow = old_max * array->expand_rate / 100;
+    check(DArray_resize(array, old_max + (grow > 0 ? grow : 1)) == 0,
+            "Failed to expand array to new size: %d",
+            array->max + (int)(grow > 0 ? grow : 1));
+
+    memset(array->data + old_max * DArray_width(array), 0,
+            (array->max - old_max) * DArray_width(array));
+    return 0;
+
+error:
+    return -1;
+}
+
+int DArray_reserve(DArray *array, int count)
+{
+    size_t old_max = array->max;
+    if(count <= array->max) {
+        return 0;
+    }
+
+    check(DArray_resize(array, count) == 0,
+            "Failed to reserve array size: %d", count);
+    memset(array->data + old_max * DArray_width(array), 0,
+            (array->max - old_max) * DArray_width(array));
+    return 0;
+
+error:
+    return -1;
+}
+
+int DArray_contract(DArray *array)
+{
+    // only shrink well below capacity, and leave headroom when we do
+    if(array->end >= array->max / 4 || array->max <= array->min_max) {
+        return 0;
+    }
+
+    int new_size = array->end * 2 < array->min_max ?
+        array->min_max : array->end * 2;
+
+    return DArray_resize(array, new_size);
+}
+
+
+void DArray_destroy(DArray *array)
+{
+    if(array) {
+        if(array->data) free(array->data);
+        free(array);
+    }
+}
+
+void DArray_clear_destroy(DArray *array)
+{
+    DArray_clear(array);
+    DArray_destroy(array);
+}
+
+int DArray_push(DArray *array, void *el)
+{
+    if(array->end >= array->max) {
+        check(DArray_expand(array) == 0, "Failed to expand darray.");
+    }
+
+    DArray_set(array, array->end, el);
+    array->end++;
+
+    return 0;
+error:
+    return -1;
+}
+
+void *DArray_pop(DArray *array)
+{
+    check(array->end - 1 >= 0, "Attempt to pop from empty array.");
+
+    array->end--;
+    if(DArray_is_inline(array)) {
+        return DArray_slot(array, array->end);
+    }
+
+    void *el = array->contents[array->end];
+    array->contents[array->end] = NULL;
+    return el;
+error:
+    return NULL;
+}
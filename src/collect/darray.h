@@ -1,29 +1,130 @@
 #ifndef _DArray_h
 #define _DArray_h
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <dbg.h>
 
+// percent of the current capacity added on each expansion
+#define DEFAULT_EXPAND_RATE 100
+
+// store element_size-byte values in the array itself instead of pointers
+#define DARRAY_INLINE 1
+
+/// A contiguous, growable array.
+/**
+ * By default contents holds pointers to elements owned by the caller.  An
+ * array made with DArray_create_inline instead copies element_size bytes
+ * per element into data, so scans walk memory linearly.  Either way,
+ * DArray_get returns a pointer to the element and DArray_push takes one.
+ */
 typedef struct DArray {
     int end;
     int max;
+    int min_max;
+    int flags;
     size_t element_size;
     size_t expand_rate;
-    void **contents;
+    union {
+        void **contents;
+        char *data;
+    };
 } DArray;
 
+/// Allocate an array of element pointers.
 DArray *DArray_create(size_t element_size, size_t initial_max);
 
+/// Allocate an array that stores element_size-byte values inline.
+DArray *DArray_create_inline(size_t element_size, size_t initial_max);
+
 void DArray_destroy(DArray *array);
 
+/// Empty the array, freeing each element first in pointer mode.
 void DArray_clear(DArray *array);
 
+/// Grow capacity by expand_rate percent.
 int DArray_expand(DArray *array);
 
+/// Make room for at least count elements without further expansion.
+int DArray_reserve(DArray *array, int count);
+
+/// Give back capacity once the array is less than a quarter full.
+/**
+ * The array shrinks to twice its count (never below its initial size), so
+ * alternating pushes and pops around a boundary can't thrash realloc.
+ */
 int DArray_contract(DArray *array);
 
 int DArray_push(DArray *array, void *el);
 
+/// Remove the last element.
+/**
+ * In inline mode the returned pointer refers to the vacated slot, and is
+ * only valid until the array is next modified.
+ */
 void *DArray_pop(DArray *array);
 
 void DArray_clear_destroy(DArray *array);
+
+#define DArray_last(A) DArray_get((A), (A)->end - 1)
+#define DArray_first(A) DArray_get((A), 0)
+#define DArray_end(A) ((A)->end)
+#define DArray_count(A) DArray_end(A)
+#define DArray_max(A) ((A)->max)
+#define DArray_is_inline(A) (((A)->flags & DARRAY_INLINE) != 0)
+#define DArray_width(A) (DArray_is_inline(A) ? (A)->element_size : \
+        sizeof(void *))
+
+#define DArray_free(E) free((E))
+
+/// Address of element i's slot, for either storage mode.
+static inline void *DArray_slot(DArray *array, int i)
+{
+    return array->data + (size_t)i * DArray_width(array);
+}
+
+static inline int DArray_set(DArray *array, int i, void *el)
+{
+    check(i < array->max, "darray attempt to set past max");
+    if(DArray_is_inline(array)) {
+        memcpy(DArray_slot(array, i), el, array->element_size);
+    } else {
+        array->contents[i] = el;
+    }
+    return 0;
+error:
+    return -1;
+}
+
+static inline void *DArray_get(DArray *array, int i)
+{
+    check(i < array->max, "darray attempt to get past max");
+    if(DArray_is_inline(array)) {
+        return DArray_slot(array, i);
+    }
+    return array->contents[i];
+error:
+    return NULL;
+}
+
+/// Take an element pointer out of a pointer mode array, leaving NULL.
+static inline void *DArray_remove(DArray *array, int i)
+{
+    check(!DArray_is_inline(array), "darray remove needs pointer storage");
+    void *el = array->contents[i];
+    array->contents[i] = NULL;
+    return el;
+error:
+    return NULL;
+}
+
+/// Allocate a zeroed element for a pointer mode array.
+static inline void *DArray_new(DArray *array)
+{
+    check(array->element_size > 0, "Can't use DArray_new on 0 size darrays.");
+    return calloc(1, array->element_size);
+error:
+    return NULL;
+}
+
+#endif
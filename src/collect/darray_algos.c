@@ -0,0 +1,554 @@
+#include <collect/darray_algos.h>
+#include <stdint.h>
+
+// buckets per worker, enough that one slow bucket doesn't hold up the rest
+#define SAMPLE_SORT_BUCKETS_PER_WORKER 4
+// with an equality bucket per splitter this keeps bucket ids in a byte
+#define SAMPLE_SORT_MAX_BUCKETS 128
+#define SAMPLE_SORT_OVERSAMPLE 16
+// ranges shorter than this are merge sorted on the calling thread
+#define MERGE_SORT_TASK_CUTOFF 8192
+// merges shorter than this aren't worth splitting across the pool
+#define PARALLEL_MERGE_CUTOFF 32768
+#define PARALLEL_MERGE_MAX_PARTS 64
+
+/// A view over DArray storage that hides the pointer/inline distinction.
+/**
+ * With nodes set the slots point at ListNodes, and cmp is given their
+ * values, which lets lists be sorted through an array of their nodes.
+ */
+typedef struct SortArray {
+    char *base;
+    size_t width;
+    int indirect;
+    int nodes;
+    List_compare cmp;
+} SortArray;
+
+static inline char *SortArray_at(SortArray *s, size_t i)
+{
+    return s->base + i * s->width;
+}
+
+static inline void *SortArray_elem(SortArray *s, char *slot)
+{
+    if(s->nodes) {
+        return (*(ListNode **)slot)->value;
+    }
+    return s->indirect ? *(void **)slot : (void *)slot;
+}
+
+static inline int SortArray_cmp(SortArray *s, size_t i, size_t j)
+{
+    return s->cmp(SortArray_elem(s, SortArray_at(s, i)),
+            SortArray_elem(s, SortArray_at(s, j)));
+}
+
+static inline void SortArray_swap(SortArray *s, size_t i, size_t j)
+{
+    char *a = SortArray_at(s, i);
+    char *b = SortArray_at(s, j);
+
+    if(s->width == sizeof(void *)) {
+        void *tmp = *(void **)a;
+        *(void **)a = *(void **)b;
+        *(void **)b = tmp;
+    } else {
+        char tmp[64];
+        size_t done = 0;
+        while(done < s->width) {
+            size_t n = s->width - done < sizeof(tmp) ?
+                s->width - done : sizeof(tmp);
+            memcpy(tmp, a + done, n);
+            memcpy(a + done, b + done, n);
+            memcpy(b + done, tmp, n);
+            done += n;
+        }
+    }
+}
+
+static SortArray SortArray_from(DArray *array, List_compare cmp)
+{
+    SortArray s;
+    s.base = array->data;
+    s.width = DArray_width(array);
+    s.indirect = !DArray_is_inline(array);
+    s.nodes = 0;
+    s.cmp = cmp;
+    return s;
+}
+
+
+DARRAY_GENERATE_INTRO_SORT(SortArray_sort, SortArray *, SortArray_cmp,
+        SortArray_swap)
+
+
+int DArray_sort(DArray *array, List_compare comparator)
+{
+    check(array != NULL, "Received null pointer for array.");
+    check(comparator != NULL, "Received null comparator.");
+
+    SortArray s = SortArray_from(array, comparator);
+    if(array->end > 1) {
+        SortArray_sort(&s, 0, array->end);
+    }
+    return 0;
+error:
+    return -1;
+}
+
+
+/// Splitter i bounds range bucket 2i from above and owns equality bucket
+/// 2i + 1, so buckets alternate between ranges that still need sorting
+/// and runs of keys equal to a splitter, which don't.  Equality buckets are
+/// only filled when the sample held repeated splitters, the sign of a key
+/// too common to share a range bucket without swamping it.
+typedef struct SampleSort {
+    SortArray src;
+    SortArray tmp;
+    char *splitters;
+    unsigned char *bucket_of;
+    size_t *offsets;
+    size_t *bucket_start;
+    size_t n;
+    int splitter_count;
+    int buckets;
+    int blocks;
+    int equal_buckets;
+} SampleSort;
+
+typedef struct SampleSortPart {
+    SampleSort *sort;
+    int index;
+} SampleSortPart;
+
+static inline size_t SampleSort_block_start(SampleSort *ss, int block)
+{
+    return ss->n * block / ss->blocks;
+}
+
+static inline void *SampleSort_splitter(SampleSort *ss, int i)
+{
+    return SortArray_elem(&ss->src, ss->splitters + i * ss->src.width);
+}
+
+/// the range bucket below the first splitter greater than slot, or the
+/// equality bucket of the splitter before that if slot equals it
+static int SampleSort_classify(SampleSort *ss, char *slot)
+{
+    void *el = SortArray_elem(&ss->src, slot);
+    int lo = 0;
+    int hi = ss->splitter_count;
+    while(lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if(ss->src.cmp(el, SampleSort_splitter(ss, mid)) < 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+
+    // el is not below splitter lo - 1, so not above means equal
+    if(ss->equal_buckets && lo > 0 &&
+            ss->src.cmp(el, SampleSort_splitter(ss, lo - 1)) <= 0) {
+        return 2 * lo - 1;
+    }
+    return 2 * lo;
+}
+
+static void *SampleSort_count_block(void *args)
+{
+    SampleSortPart *part = (SampleSortPart *)args;
+    SampleSort *ss = part->sort;
+    size_t *counts = ss->offsets + (size_t)part->index * ss->buckets;
+    size_t end = SampleSort_block_start(ss, part->index + 1);
+    size_t i;
+
+    for(i = SampleSort_block_start(ss, part->index); i < end; i++) {
+        int bucket = SampleSort_classify(ss, SortArray_at(&ss->src, i));
+        ss->bucket_of[i] = (unsigned char)bucket;
+        counts[bucket]++;
+    }
+    return NULL;
+}
+
+static void *SampleSort_scatter_block(void *args)
+{
+    SampleSortPart *part = (SampleSortPart *)args;
+    SampleSort *ss = part->sort;
+    size_t *offsets = ss->offsets + (size_t)part->index * ss->buckets;
+    size_t end = SampleSort_block_start(ss, part->index + 1);
+    size_t i;
+
+    for(i = SampleSort_block_start(ss, part->index); i < end; i++) {
+        size_t to = offsets[ss->bucket_of[i]]++;
+        memcpy(SortArray_at(&ss->tmp, to), SortArray_at(&ss->src, i),
+                ss->src.width);
+    }
+    return NULL;
+}
+
+static void *SampleSort_sort_bucket(void *args)
+{
+    SampleSortPart *part = (SampleSortPart *)args;
+    SampleSort *ss = part->sort;
+    size_t lo = ss->bucket_start[part->index];
+    size_t hi = ss->bucket_start[part->index + 1];
+
+    // odd buckets hold keys equal to their splitter, already in order
+    if(part->index % 2 == 0 && hi - lo > 1) {
+        SortArray_sort(&ss->tmp, lo, hi);
+    }
+    memcpy(SortArray_at(&ss->src, lo), SortArray_at(&ss->tmp, lo),
+            (hi - lo) * ss->src.width);
+    return NULL;
+}
+
+/// run func over parts[0..count) on the pool and wait for all of them
+static void SampleSort_run(TaskPool *pool, Task *tasks, SampleSortPart *parts,
+        int count, Task_func func)
+{
+    int i;
+    for(i = 0; i < count; i++) {
+        TaskPool_spawn(pool, &tasks[i], func, &parts[i]);
+    }
+    for(i = 0; i < count; i++) {
+        TaskPool_join(pool, &tasks[i]);
+    }
+}
+
+/// pick splitter_count evenly spaced splitters from a sorted random sample
+static int SampleSort_pick_splitters(SampleSort *ss)
+{
+    int samples = (ss->splitter_count + 1) * SAMPLE_SORT_OVERSAMPLE;
+    size_t width = ss->src.width;
+    SortArray sample = ss->src;
+    uint64_t seed = 0x9E3779B97F4A7C15ULL ^ ss->n;
+    int i;
+
+    sample.base = malloc(samples * width);
+    check_mem(sample.base);
+
+    for(i = 0; i < samples; i++) {
+        // xorshift is plenty to avoid sampling patterns in the input
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        memcpy(SortArray_at(&sample, i),
+                SortArray_at(&ss->src, seed % ss->n), width);
+    }
+    SortArray_sort(&sample, 0, samples);
+
+    for(i = 0; i < ss->splitter_count; i++) {
+        memcpy(ss->splitters + i * width,
+                SortArray_at(&sample, (i + 1) * SAMPLE_SORT_OVERSAMPLE),
+                width);
+        if(i > 0 && ss->src.cmp(SampleSort_splitter(ss, i - 1),
+                    SampleSort_splitter(ss, i)) == 0) {
+            ss->equal_buckets = 1;
+        }
+    }
+
+    free(sample.base);
+    return 0;
+error:
+    return -1;
+}
+
+
+int DArray_parallel_sort(DArray *array, List_compare comparator)
+{
+    return DArray_parallel_sort_on(array, comparator, TaskPool_default());
+}
+
+int DArray_parallel_sort_on(DArray *array, List_compare comparator,
+        TaskPool *pool)
+{
+    SampleSort ss;
+    SampleSortPart *parts = NULL;
+    Task *tasks = NULL;
+    int workers = TaskPool_worker_count(pool);
+    int rc = -1;
+    int i, b;
+
+    memset(&ss, 0, sizeof(ss));
+    check(array != NULL, "Received null pointer for array.");
+    check(comparator != NULL, "Received null comparator.");
+
+    if(array->end < DARRAY_PARALLEL_CUTOFF || workers < 2) {
+        return DArray_sort(array, comparator);
+    }
+
+    ss.src = SortArray_from(array, comparator);
+    ss.tmp = ss.src;
+    ss.n = array->end;
+    ss.splitter_count = workers * SAMPLE_SORT_BUCKETS_PER_WORKER - 1;
+    if(ss.splitter_count >= SAMPLE_SORT_MAX_BUCKETS) {
+        ss.splitter_count = SAMPLE_SORT_MAX_BUCKETS - 1;
+    }
+    ss.buckets = 2 * ss.splitter_count + 1;
+    ss.blocks = workers * SAMPLE_SORT_BUCKETS_PER_WORKER;
+
+    ss.tmp.base = malloc(ss.n * ss.src.width);
+    check_mem(ss.tmp.base);
+    ss.splitters = malloc(ss.splitter_count * ss.src.width);
+    check_mem(ss.splitters);
+    ss.bucket_of = malloc(ss.n);
+    check_mem(ss.bucket_of);
+    ss.offsets = calloc((size_t)ss.blocks * ss.buckets, sizeof(size_t));
+    check_mem(ss.offsets);
+    ss.bucket_start = calloc(ss.buckets + 1, sizeof(size_t));
+    check_mem(ss.bucket_start);
+
+    int parts_count = ss.blocks > ss.buckets ? ss.blocks : ss.buckets;
+    parts = calloc(parts_count, sizeof(SampleSortPart));
+    check_mem(parts);
+    tasks = calloc(parts_count, sizeof(Task));
+    check_mem(tasks);
+    for(i = 0; i < parts_count; i++) {
+        parts[i].sort = &ss;
+        parts[i].index = i;
+    }
+
+    check(SampleSort_pick_splitters(&ss) == 0, "Failed to pick splitters.");
+
+    // 1. count how many elements of each block land in each bucket
+    SampleSort_run(pool, tasks, parts, ss.blocks, SampleSort_count_block);
+
+    // 2. turn the counts into scatter offsets, bucket major
+    size_t total = 0;
+    for(b = 0; b < ss.buckets; b++) {
+        ss.bucket_start[b] = total;
+        for(i = 0; i < ss.blocks; i++) {
+            size_t *slot = &ss.offsets[(size_t)i * ss.buckets + b];
+            size_t count = *slot;
+            *slot = total;
+            total += count;
+        }
+    }
+    ss.bucket_start[ss.buckets] = total;
+    check(total == ss.n, "Bucket counts don't add up to the array size.");
+
+    // 3. scatter into the buckets, then 4. sort each bucket and copy back
+    SampleSort_run(pool, tasks, parts, ss.blocks, SampleSort_scatter_block);
+    SampleSort_run(pool, tasks, parts, ss.buckets, SampleSort_sort_bucket);
+
+    rc = 0;
+error:
+    if(tasks) free(tasks);
+    if(parts) free(parts);
+    if(ss.bucket_start) free(ss.bucket_start);
+    if(ss.offsets) free(ss.offsets);
+    if(ss.bucket_of) free(ss.bucket_of);
+    if(ss.splitters) free(ss.splitters);
+    if(ss.tmp.base) free(ss.tmp.base);
+    return rc;
+}
+
+
+/// A stable merge sort that ping-pongs between the array and a scratch copy.
+typedef struct MergeSort {
+    SortArray data;
+    SortArray scratch;
+    TaskPool *pool;
+    int parts;
+} MergeSort;
+
+/// Sort src[lo, hi) into dst[lo, hi).
+typedef struct MergeSortRange {
+    MergeSort *sort;
+    SortArray *src;
+    SortArray *dst;
+    size_t lo;
+    size_t hi;
+} MergeSortRange;
+
+/// Merge src[a, a_end) and src[b, b_end) into dst starting at out.
+typedef struct MergePart {
+    SortArray *src;
+    SortArray *dst;
+    size_t a;
+    size_t a_end;
+    size_t b;
+    size_t b_end;
+    size_t out;
+} MergePart;
+
+static inline void SortArray_copy(SortArray *dst, size_t to, SortArray *src,
+        size_t from, size_t count)
+{
+    memcpy(SortArray_at(dst, to), SortArray_at(src, from), count * src->width);
+}
+
+/// how many of the first k merged elements come from the run at a, given
+/// the run at b follows it.  Ties go to a, which keeps the merge stable.
+static size_t merge_co_rank(SortArray *s, size_t a, size_t na, size_t b,
+        size_t nb, size_t k)
+{
+    // the answer is the smallest i where a[i] must follow b[k - i - 1]
+    size_t lo = k > nb ? k - nb : 0;
+    size_t hi = k < na ? k : na;
+    while(lo < hi) {
+        size_t i = lo + (hi - lo) / 2;
+        if(SortArray_cmp(s, a + i, b + k - i - 1) <= 0) {
+            lo = i + 1;
+        } else {
+            hi = i;
+        }
+    }
+    return lo;
+}
+
+static void *merge_part(void *args)
+{
+    MergePart *part = (MergePart *)args;
+    SortArray *src = part->src;
+    size_t a = part->a;
+    size_t b = part->b;
+    size_t out = part->out;
+
+    while(a < part->a_end && b < part->b_end) {
+        if(SortArray_cmp(src, a, b) <= 0) {
+            SortArray_copy(part->dst, out++, src, a++, 1);
+        } else {
+            SortArray_copy(part->dst, out++, src, b++, 1);
+        }
+    }
+    SortArray_copy(part->dst, out, src, a, part->a_end - a);
+    SortArray_copy(part->dst, out + part->a_end - a, src, b, part->b_end - b);
+    return NULL;
+}
+
+/// merge src[lo, mid) and src[mid, hi) into dst[lo, hi).  Long merges are
+/// cut into equal slices of output by co-ranking, one task per slice.
+static void merge_parallel(MergeSort *ms, SortArray *src, SortArray *dst,
+        size_t lo, size_t mid, size_t hi)
+{
+    MergePart parts[PARALLEL_MERGE_MAX_PARTS];
+    Task tasks[PARALLEL_MERGE_MAX_PARTS];
+    size_t n = hi - lo;
+    size_t na = mid - lo;
+    size_t nb = hi - mid;
+    int count = n < PARALLEL_MERGE_CUTOFF ? 1 : ms->parts;
+    size_t prev_k = 0;
+    size_t prev_i = 0;
+    int p;
+
+    for(p = 0; p < count; p++) {
+        size_t k = n * (p + 1) / count;
+        size_t i = merge_co_rank(src, lo, na, mid, nb, k);
+        parts[p].src = src;
+        parts[p].dst = dst;
+        parts[p].a = lo + prev_i;
+        parts[p].a_end = lo + i;
+        parts[p].b = mid + (prev_k - prev_i);
+        parts[p].b_end = mid + (k - i);
+        parts[p].out = lo + prev_k;
+        prev_k = k;
+        prev_i = i;
+    }
+
+    if(count == 1) {
+        merge_part(&parts[0]);
+        return;
+    }
+    for(p = 1; p < count; p++) {
+        TaskPool_spawn(ms->pool, &tasks[p], merge_part, &parts[p]);
+    }
+    merge_part(&parts[0]);
+    for(p = 1; p < count; p++) {
+        TaskPool_join(ms->pool, &tasks[p]);
+    }
+}
+
+/// sort src[lo, hi) into dst[lo, hi).  Both hold the same elements on the
+/// way in, so each level sorts its halves into the other buffer and merges
+/// them back, and nothing is ever copied just to move it.
+static void *merge_sort_range(void *args)
+{
+    MergeSortRange *range = (MergeSortRange *)args;
+    MergeSort *ms = range->sort;
+    size_t lo = range->lo;
+    size_t hi = range->hi;
+
+    if(hi - lo <= DARRAY_SORT_INSERTION_CUTOFF) {
+        // insertion sort only swaps neighbours that are out of order, so
+        // it is stable
+        SortArray_sort_insertion(range->dst, lo, hi);
+        return NULL;
+    }
+
+    size_t mid = lo + (hi - lo) / 2;
+    MergeSortRange left = {ms, range->dst, range->src, lo, mid};
+    MergeSortRange right = {ms, range->dst, range->src, mid, hi};
+
+    if(hi - lo >= MERGE_SORT_TASK_CUTOFF && ms->parts > 1) {
+        Task task;
+        TaskPool_spawn(ms->pool, &task, merge_sort_range, &left);
+        merge_sort_range(&right);
+        TaskPool_join(ms->pool, &task);
+    } else {
+        merge_sort_range(&left);
+        merge_sort_range(&right);
+    }
+
+    merge_parallel(ms, range->src, range->dst, lo, mid, hi);
+    return NULL;
+}
+
+
+int DArray_merge_sort(DArray *array, List_compare comparator)
+{
+    return DArray_merge_sort_on(array, comparator, TaskPool_default());
+}
+
+/// merge sort the array, comparing ListNode values if nodes is set
+static int merge_sort(DArray *array, List_compare comparator, TaskPool *pool,
+        int nodes)
+{
+    MergeSort ms;
+
+    check(array != NULL, "Received null pointer for array.");
+    check(comparator != NULL, "Received null comparator.");
+    if(array->end < 2) {
+        return 0;
+    }
+
+    ms.data = SortArray_from(array, comparator);
+    ms.data.nodes = nodes;
+    ms.scratch = ms.data;
+    ms.pool = pool;
+    ms.parts = TaskPool_worker_count(pool);
+    if(ms.parts > PARALLEL_MERGE_MAX_PARTS) {
+        ms.parts = PARALLEL_MERGE_MAX_PARTS;
+    }
+
+    size_t n = array->end;
+    ms.scratch.base = malloc(n * ms.data.width);
+    check_mem(ms.scratch.base);
+    SortArray_copy(&ms.scratch, 0, &ms.data, 0, n);
+
+    MergeSortRange all = {&ms, &ms.scratch, &ms.data, 0, n};
+    merge_sort_range(&all);
+
+    free(ms.scratch.base);
+    return 0;
+error:
+    return -1;
+}
+
+int DArray_merge_sort_on(DArray *array, List_compare comparator,
+        TaskPool *pool)
+{
+    return merge_sort(array, comparator, pool, 0);
+}
+
+int DArray_merge_sort_nodes(DArray *nodes, List_compare comparator,
+        TaskPool *pool)
+{
+    check(nodes == NULL || !DArray_is_inline(nodes),
+            "DArray_merge_sort_nodes needs a pointer mode DArray.");
+    return merge_sort(nodes, comparator, pool, 1);
+error:
+    return -1;
+}
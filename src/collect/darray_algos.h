@@ -0,0 +1,221 @@
+#ifndef darray_algos_h
+#define darray_algos_h
+
+#include <collect/darray.h>
+#include <collect/list.h>
+#include <collect/task_pool.h>
+
+// arrays shorter than this are always sorted on the calling thread
+#define DARRAY_PARALLEL_CUTOFF 32768
+
+/// Sort an array in place with an introsort.
+/**
+ * comparator receives element pointers, exactly as DArray_get returns
+ * them, so the same List_compare works for pointer and inline arrays.
+ * Not stable.  Returns 0 on success.
+ */
+int DArray_sort(DArray *array, List_compare comparator);
+
+/// Sort an array in place across the default TaskPool with a sample sort.
+/**
+ * Splitters drawn from a sorted sample partition the array into buckets,
+ * elements are scattered into their buckets in parallel, and each bucket
+ * is finished with DArray_sort.  A key that repeats among the splitters
+ * gets a bucket of its own, which needs no sorting, so inputs with few
+ * distinct keys still split evenly.  Small arrays, or machines with a
+ * single worker, take the serial path directly.  Not stable.  Returns 0 on
+ * success.
+ */
+int DArray_parallel_sort(DArray *array, List_compare comparator);
+
+/// DArray_parallel_sort on a caller supplied pool.
+int DArray_parallel_sort_on(DArray *array, List_compare comparator,
+        TaskPool *pool);
+
+/// Stable merge sort across the default TaskPool.
+/**
+ * Halves are sorted as separate tasks, and every merge long enough to be
+ * worth it is itself split into one slice of output per worker: the
+ * co-rank of each slice boundary is found by binary search, after which
+ * the slices merge independently.  The top level merges therefore use
+ * every core instead of leaving one thread to merge all n elements.
+ * Needs a scratch copy of the array.  Returns 0 on success.
+ */
+int DArray_merge_sort(DArray *array, List_compare comparator);
+
+/// DArray_merge_sort on a caller supplied pool.
+int DArray_merge_sort_on(DArray *array, List_compare comparator,
+        TaskPool *pool);
+
+/// DArray_merge_sort_on for a pointer array of ListNodes, by their values.
+/**
+ * comparator receives each node's value rather than the node, as it would
+ * sorting the list itself.  List_merge_sort gathers long lists into such
+ * an array and relinks them afterwards.
+ */
+int DArray_merge_sort_nodes(DArray *nodes, List_compare comparator,
+        TaskPool *pool);
+
+
+// ranges this short are finished by an insertion sort
+#define DARRAY_SORT_INSERTION_CUTOFF 16
+
+/// Generate the introsort behind DArray_sort and DARRAY_DEFINE_SORT.
+/**
+ * Expands to `static void name(S s, size_t lo, size_t hi)`, which sorts
+ * slots [lo, hi) of s, along with the name##_insertion, name##_heap and
+ * name##_intro steps it is built from.  S is whatever describes the
+ * slots, and the slots are only ever reached through CMP(s, i, j), which
+ * compares slots i and j like a comparator, and SWAP(s, i, j).  Both are
+ * usually static inline functions, so a typed S compiles down to plain
+ * array accesses.  name##_insertion only swaps neighbours strictly out of
+ * order, which keeps it stable for merge sorts to reuse.
+ */
+#define DARRAY_GENERATE_INTRO_SORT(name, S, CMP, SWAP) \
+static __attribute__((unused)) void name##_insertion(S s, size_t lo, \
+        size_t hi) \
+{ \
+    size_t i, j; \
+    for(i = lo + 1; i < hi; i++) { \
+        for(j = i; j > lo && CMP(s, j - 1, j) > 0; j--) { \
+            SWAP(s, j - 1, j); \
+        } \
+    } \
+} \
+\
+static void name##_sift_down(S s, size_t lo, size_t root, size_t n) \
+{ \
+    while(2 * root + 1 < n) { \
+        size_t child = 2 * root + 1; \
+        if(child + 1 < n && CMP(s, lo + child, lo + child + 1) < 0) { \
+            child++; \
+        } \
+        if(CMP(s, lo + root, lo + child) >= 0) { \
+            return; \
+        } \
+        SWAP(s, lo + root, lo + child); \
+        root = child; \
+    } \
+} \
+\
+static void name##_heap(S s, size_t lo, size_t hi) \
+{ \
+    size_t n = hi - lo; \
+    size_t i; \
+    for(i = n / 2; i > 0; i--) { \
+        name##_sift_down(s, lo, i - 1, n); \
+    } \
+    for(i = n - 1; i > 0; i--) { \
+        SWAP(s, lo, lo + i); \
+        name##_sift_down(s, lo, 0, i); \
+    } \
+} \
+\
+/* quicksort with a median of three pivot, falling back to heapsort when */ \
+/* the recursion gets too deep and to insertion sort on short ranges */ \
+static void name##_intro(S s, size_t lo, size_t hi, int depth) \
+{ \
+    while(hi - lo > DARRAY_SORT_INSERTION_CUTOFF) { \
+        if(depth-- == 0) { \
+            name##_heap(s, lo, hi); \
+            return; \
+        } \
+\
+        /* order lo, mid, hi - 1 and move the median to lo.  hi - 1 then */ \
+        /* stops the left scan, and the pivot stops the right one. */ \
+        size_t mid = lo + (hi - lo) / 2; \
+        if(CMP(s, mid, lo) < 0) SWAP(s, mid, lo); \
+        if(CMP(s, hi - 1, mid) < 0) { \
+            SWAP(s, hi - 1, mid); \
+            if(CMP(s, mid, lo) < 0) SWAP(s, mid, lo); \
+        } \
+        SWAP(s, lo, mid); \
+\
+        size_t i = lo + 1; \
+        size_t j = hi - 1; \
+        while(1) { \
+            while(CMP(s, i, lo) < 0) i++; \
+            while(CMP(s, j, lo) > 0) j--; \
+            if(i >= j) break; \
+            SWAP(s, i, j); \
+            i++; \
+            j--; \
+        } \
+        SWAP(s, lo, j); \
+\
+        /* recurse into the smaller side to bound the stack */ \
+        if(j - lo < hi - j - 1) { \
+            name##_intro(s, lo, j, depth); \
+            lo = j + 1; \
+        } else { \
+            name##_intro(s, j + 1, hi, depth); \
+            hi = j; \
+        } \
+    } \
+    name##_insertion(s, lo, hi); \
+} \
+\
+static __attribute__((unused)) void name(S s, size_t lo, size_t hi) \
+{ \
+    int depth = 0; \
+    size_t n = 0; \
+    for(n = hi - lo; n > 1; n >>= 1) { \
+        depth += 2; \
+    } \
+    if(hi - lo > 1) { \
+        name##_intro(s, lo, hi, depth); \
+    } \
+}
+
+/// Define a DArray_sort specialized for one element type and comparison.
+/**
+ * Expands to `static int name(DArray *array)`, the same introsort as
+ * DArray_sort, working on the array's slots as a plain C array of type
+ * with cmp_expr compiled into every comparison.  Elements are moved by
+ * assignment rather than memcpy, and no comparison goes through a
+ * function pointer.  Inside cmp_expr, a and b are two elements of type,
+ * and the expression returns less than, equal to or greater than 0.
+ *
+ * type must be as wide as the array's slots: the element type itself for
+ * inline arrays, or a pointer type for pointer arrays.
+ *
+ *     DARRAY_DEFINE_SORT(sort_ints, int, (a > b) - (a < b))
+ *     DARRAY_DEFINE_SORT(sort_strings, char *, strcmp(a, b))
+ *
+ * Use it at file scope.  It also defines helpers prefixed with name##_.
+ * Returns 0 on success, or -1 if the slot width doesn't match type.
+ */
+#define DARRAY_DEFINE_SORT(name, type, cmp_expr) \
+static inline int name##_compare(type a, type b) \
+{ \
+    return (cmp_expr); \
+} \
+\
+static inline int name##_compare_at(type *v, size_t i, size_t j) \
+{ \
+    return name##_compare(v[i], v[j]); \
+} \
+\
+static inline void name##_swap(type *v, size_t i, size_t j) \
+{ \
+    type tmp = v[i]; \
+    v[i] = v[j]; \
+    v[j] = tmp; \
+} \
+\
+DARRAY_GENERATE_INTRO_SORT(name##_range, type *, name##_compare_at, \
+        name##_swap) \
+\
+static __attribute__((unused)) int name(DArray *array) \
+{ \
+    check(array != NULL, "Received null pointer for array."); \
+    check(DArray_width(array) == sizeof(type), \
+            "Array slots are not the width of " #type "."); \
+\
+    name##_range((type *)array->data, 0, array->end); \
+    return 0; \
+error: \
+    return -1; \
+}
+
+#endif
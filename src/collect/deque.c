@@ -0,0 +1,252 @@
+/*
+ * Ring buffer double ended queue.
+ * Copyright (C) 2014 Axel Magnuson <axelmagn@gmail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <collect/deque.h>
+#include <dbg.h>
+#include <string.h>
+
+
+/// Allocate a new deque from the heap.
+Deque *Deque_create(int capacity)
+{
+	Deque *deque = calloc(1, sizeof(Deque));
+	check_mem(deque);
+
+	int size = DEQUE_MIN_CAPACITY;
+	while(size < capacity) {
+		size *= 2;
+	}
+
+	deque->values = malloc(size * sizeof(void *));
+	check_mem(deque->values);
+	deque->capacity = size;
+	return deque;
+error:
+	if(deque) { free(deque); }
+	return NULL;
+}
+
+
+/// Free a deque, but not its values.
+void Deque_destroy(Deque *deque)
+{
+	if(deque) {
+		free(deque->values);
+		free(deque);
+	}
+}
+
+
+/// Free all values contained by the deque, leaving it empty.
+void Deque_clear(Deque *deque)
+{
+	DEQUE_FOREACH(deque, i, value) {
+		free(value);
+	}
+	deque->head = 0;
+	deque->count = 0;
+}
+
+
+/// Free a deque and any values it contains.
+void Deque_clear_destroy(Deque *deque)
+{
+	Deque_clear(deque);
+	Deque_destroy(deque);
+}
+
+
+/// Copy count values from the ring, starting at index, into out.
+static void Deque_read(Deque *deque, int index, void **out, int count)
+{
+	int start = (deque->head + index) & (deque->capacity - 1);
+	int first = deque->capacity - start < count ?
+		deque->capacity - start : count;
+
+	memcpy(out, &deque->values[start], first * sizeof(void *));
+	memcpy(out + first, deque->values, (count - first) * sizeof(void *));
+}
+
+
+/// Copy count values from in into the ring, starting at index.
+static void Deque_write(Deque *deque, int index, void **in, int count)
+{
+	int start = (deque->head + index) & (deque->capacity - 1);
+	int first = deque->capacity - start < count ?
+		deque->capacity - start : count;
+
+	memcpy(&deque->values[start], in, first * sizeof(void *));
+	memcpy(deque->values, in + first, (count - first) * sizeof(void *));
+}
+
+
+/// Make room for at least capacity values without further growth.
+int Deque_reserve(Deque *deque, int capacity)
+{
+	if(capacity <= deque->capacity) {
+		return 0;
+	}
+
+	int size = deque->capacity;
+	while(size < capacity) {
+		size *= 2;
+	}
+
+	void **values = realloc(deque->values, size * sizeof(void *));
+	check_mem(values);
+
+	// the part that wrapped around to the front moves to just past the old
+	// end, so the values are contiguous again in the larger ring
+	int wrapped = deque->head + deque->count - deque->capacity;
+	if(wrapped > 0) {
+		memcpy(&values[deque->capacity], values, wrapped * sizeof(void *));
+	}
+
+	deque->values = values;
+	deque->capacity = size;
+	return 0;
+error:
+	return -1;
+}
+
+
+/// retrieve the value stored at an index, or NULL if it is out of bounds.
+void *Deque_get(Deque *deque, int index)
+{
+	if(index < 0 || index >= deque->count) {
+		return NULL;
+	}
+	return *Deque_slot(deque, index);
+}
+
+
+/// replace the value stored at an index.  Returns -1 if out of bounds.
+int Deque_set(Deque *deque, int index, void *value)
+{
+	check(index >= 0 && index < deque->count,
+			"Deque index %d out of bounds.", index);
+	*Deque_slot(deque, index) = value;
+	return 0;
+error:
+	return -1;
+}
+
+
+/// push a new value onto the end of the deque.
+int Deque_push(Deque *deque, void *value)
+{
+	if(deque->count == deque->capacity) {
+		check(Deque_reserve(deque, deque->capacity * 2) == 0,
+				"Failed to grow deque.");
+	}
+	*Deque_slot(deque, deque->count) = value;
+	deque->count++;
+	return 0;
+error:
+	return -1;
+}
+
+
+/// remove and return the end of the deque.
+void *Deque_pop(Deque *deque)
+{
+	if(deque->count == 0) {
+		return NULL;
+	}
+	deque->count--;
+	return *Deque_slot(deque, deque->count);
+}
+
+
+/// push a new value onto the beginning of the deque.
+int Deque_unshift(Deque *deque, void *value)
+{
+	if(deque->count == deque->capacity) {
+		check(Deque_reserve(deque, deque->capacity * 2) == 0,
+				"Failed to grow deque.");
+	}
+	deque->head = (deque->head - 1) & (deque->capacity - 1);
+	deque->values[deque->head] = value;
+	deque->count++;
+	return 0;
+error:
+	return -1;
+}
+
+
+/// remove and return the beginning of the deque.
+void *Deque_shift(Deque *deque)
+{
+	if(deque->count == 0) {
+		return NULL;
+	}
+	void *value = deque->values[deque->head];
+	deque->head = (deque->head + 1) & (deque->capacity - 1);
+	deque->count--;
+	return value;
+}
+
+
+/// push count values onto the end of the deque in order.
+int Deque_push_batch(Deque *deque, void **values, int count)
+{
+	check(count >= 0, "Can't push a negative number of values.");
+	check(Deque_reserve(deque, deque->count + count) == 0,
+			"Failed to grow deque.");
+
+	Deque_write(deque, deque->count, values, count);
+	deque->count += count;
+	return 0;
+error:
+	return -1;
+}
+
+
+/// remove up to max values from the beginning of the deque into out.
+int Deque_shift_batch(Deque *deque, void **out, int max)
+{
+	int count = max < deque->count ? max : deque->count;
+	if(count <= 0) {
+		return 0;
+	}
+
+	Deque_read(deque, 0, out, count);
+	deque->head = (deque->head + count) & (deque->capacity - 1);
+	deque->count -= count;
+	return count;
+}
+
+
+/// copy count values starting at index into out, without removing them.
+int Deque_copy_out(Deque *deque, int index, void **out, int count)
+{
+	if(index < 0 || index >= deque->count || count <= 0) {
+		return 0;
+	}
+	if(count > deque->count - index) {
+		count = deque->count - index;
+	}
+
+	Deque_read(deque, index, out, count);
+	return count;
+}
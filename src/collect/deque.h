@@ -0,0 +1,133 @@
+/*
+ * Ring buffer double ended queue.
+ * Copyright (C) 2014 Axel Magnuson <axelmagn@gmail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef collect_Deque_h
+#define collect_Deque_h
+
+#include <stdlib.h>
+
+#define DEQUE_MIN_CAPACITY 16
+
+
+/// A double ended queue stored in a growable circular buffer.
+/**
+ * Values occupy count consecutive slots of values starting at head,
+ * wrapping around the end of the buffer.  capacity is always a power of
+ * two, so a position maps to its slot with a mask.  Pushing and popping
+ * at either end only moves head or count; the buffer doubles when it
+ * fills and is never shrunk, so a deque that has reached its working size
+ * stops allocating altogether.
+ */
+typedef struct Deque {
+	void **values;
+	int capacity;
+	int head;
+	int count;
+} Deque;
+
+
+/// Allocate a new deque from the heap.
+/**
+ * @param capacity initial number of slots, rounded up to a power of two
+ * and at least DEQUE_MIN_CAPACITY.
+ */
+Deque *Deque_create(int capacity);
+
+/// Free a deque, but not its values.
+void Deque_destroy(Deque *deque);
+
+/// Free all values contained by the deque, leaving it empty.
+void Deque_clear(Deque *deque);
+
+/// Free a deque and any values it contains.
+void Deque_clear_destroy(Deque *deque);
+
+/// Make room for at least capacity values without further growth.
+int Deque_reserve(Deque *deque, int capacity);
+
+
+#define Deque_count(A) ((A)->count)
+#define Deque_first(A) ((A)->count > 0 ? (A)->values[(A)->head] : NULL)
+#define Deque_last(A) ((A)->count > 0 ? \
+		(A)->values[((A)->head + (A)->count - 1) & ((A)->capacity - 1)] : \
+		NULL)
+
+/// Slot of the value at an index, which must be in bounds.
+#define Deque_slot(A, I) (&(A)->values[((A)->head + (I)) & \
+		((A)->capacity - 1)])
+
+
+/// retrieve the value stored at an index, or NULL if it is out of bounds.
+void *Deque_get(Deque *deque, int index);
+
+/// replace the value stored at an index.  Returns -1 if out of bounds.
+int Deque_set(Deque *deque, int index, void *value);
+
+
+/// push a new value onto the end of the deque.  Returns 0 on success.
+int Deque_push(Deque *deque, void *value);
+
+/// remove and return the end of the deque.
+void *Deque_pop(Deque *deque);
+
+/// push a new value onto the beginning of the deque.  Returns 0 on success.
+int Deque_unshift(Deque *deque, void *value);
+
+/// remove and return the beginning of the deque.
+void *Deque_shift(Deque *deque);
+
+
+/// push count values onto the end of the deque in order.
+/**
+ * The values are copied in with at most two memcpys after growing the
+ * buffer once.  Returns 0 on success, leaving the deque untouched on
+ * failure.
+ */
+int Deque_push_batch(Deque *deque, void **values, int count);
+
+/// remove up to max values from the beginning of the deque into out.
+/**
+ * Returns the number of values removed, which is less than max once the
+ * deque runs out.
+ */
+int Deque_shift_batch(Deque *deque, void **out, int max);
+
+/// copy count values starting at index into out, without removing them.
+/**
+ * Returns the number of values copied, which is less than count if the
+ * range runs past the end of the deque.
+ */
+int Deque_copy_out(Deque *deque, int index, void **out, int count);
+
+
+/// convenience for loop iterating across a deque by index.
+/**
+ * @param D the deque to iterate on.
+ * @param I the name to use for the current index.
+ * @param V the name to use for the current value.
+ */
+#define DEQUE_FOREACH(D, I, V) int I = 0;\
+	void *V = NULL;\
+	for(I = 0; I < (D)->count && ((V = *Deque_slot(D, I)), 1); I++)
+
+#endif
@@ -0,0 +1,320 @@
+#include <stdint.h>
+#include <string.h>
+#include <collect/hashmap.h>
+#include <dbg.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define CTRL_EMPTY ((int8_t)-128)
+#define CTRL_DELETED ((int8_t)-2)
+
+#define H1(H) ((H) >> 7)
+#define H2(H) ((int8_t)((H) & 0x7f))
+
+// bit i is set when tag i of the group matched
+typedef uint32_t GroupMask;
+
+
+static int default_compare(void *a, void *b)
+{
+    return strcmp((char *)a, (char *)b);
+}
+
+uint64_t Hashmap_default_hash(void *key)
+{
+    const unsigned char *s = key;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    while(*s) {
+        hash ^= *s++;
+        hash *= 0x100000001b3ULL;
+    }
+
+    // FNV leaves the low bits weak, and they pick the tag
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+
+#ifdef __SSE2__
+
+static inline GroupMask Group_match(const int8_t *group, int8_t tag)
+{
+    __m128i ctrl = _mm_load_si128((const __m128i *)group);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(tag)));
+}
+
+/// empty and deleted tags are the only ones with the sign bit set
+static inline GroupMask Group_match_free(const int8_t *group)
+{
+    return _mm_movemask_epi8(_mm_load_si128((const __m128i *)group));
+}
+
+#else
+
+static inline GroupMask Group_match(const int8_t *group, int8_t tag)
+{
+    GroupMask mask = 0;
+    int i = 0;
+    for(i = 0; i < HASHMAP_GROUP_WIDTH; i++) {
+        mask |= (GroupMask)(group[i] == tag) << i;
+    }
+    return mask;
+}
+
+static inline GroupMask Group_match_free(const int8_t *group)
+{
+    GroupMask mask = 0;
+    int i = 0;
+    for(i = 0; i < HASHMAP_GROUP_WIDTH; i++) {
+        mask |= (GroupMask)(group[i] < 0) << i;
+    }
+    return mask;
+}
+
+#endif
+
+#define Group_match_empty(G) Group_match((G), CTRL_EMPTY)
+#define Mask_first(M) ((size_t)__builtin_ctz(M))
+#define Mask_next(M) ((M) & ((M) - 1))
+
+
+/// Walks groups in triangular order, which visits every group exactly
+/// once when the group count is a power of two.
+typedef struct Probe {
+    size_t group;
+    size_t step;
+    size_t mask;
+} Probe;
+
+static inline Probe Probe_start(Hashmap *map, uint64_t hash)
+{
+    Probe probe;
+    probe.mask = map->capacity / HASHMAP_GROUP_WIDTH - 1;
+    probe.group = H1(hash) & probe.mask;
+    probe.step = 0;
+    return probe;
+}
+
+static inline void Probe_next(Probe *probe)
+{
+    probe->step++;
+    probe->group = (probe->group + probe->step) & probe->mask;
+}
+
+
+static int Hashmap_alloc_table(Hashmap *map, size_t capacity)
+{
+    void *ctrl = NULL;
+    int rc = posix_memalign(&ctrl, HASHMAP_GROUP_WIDTH, capacity);
+    check(rc == 0, "Failed to allocate Hashmap control bytes.");
+    map->entries = calloc(capacity, sizeof(HashmapEntry));
+    check_mem(map->entries);
+
+    memset(ctrl, CTRL_EMPTY, capacity);
+    map->ctrl = ctrl;
+    map->capacity = capacity;
+    map->growth_left = capacity - capacity / 8 - map->count;
+    return 0;
+
+error:
+    if(ctrl) free(ctrl);
+    return -1;
+}
+
+
+Hashmap *Hashmap_create(Hashmap_compare compare, Hashmap_hash hash)
+{
+    Hashmap *map = calloc(1, sizeof(Hashmap));
+    check_mem(map);
+
+    map->compare = compare == NULL ? default_compare : compare;
+    map->hash = hash == NULL ? Hashmap_default_hash : hash;
+    check(Hashmap_alloc_table(map, DEFAULT_NUMBER_OF_BUCKETS) == 0,
+            "Failed to allocate Hashmap table.");
+
+    return map;
+
+error:
+    if(map) {
+        Hashmap_destroy(map);
+    }
+    return NULL;
+}
+
+void Hashmap_destroy(Hashmap *map)
+{
+    if(map) {
+        if(map->ctrl) free(map->ctrl);
+        if(map->entries) free(map->entries);
+        free(map);
+    }
+}
+
+
+/// index of key's slot, or -1 if it isn't in the map
+static inline long Hashmap_find(Hashmap *map, void *key, uint64_t hash)
+{
+    Probe probe = Probe_start(map, hash);
+    int8_t tag = H2(hash);
+
+    while(1) {
+        const int8_t *group = map->ctrl + probe.group * HASHMAP_GROUP_WIDTH;
+        GroupMask mask = Group_match(group, tag);
+        for(; mask != 0; mask = Mask_next(mask)) {
+            size_t i = probe.group * HASHMAP_GROUP_WIDTH + Mask_first(mask);
+            if(map->compare(map->entries[i].key, key) == 0) {
+                return (long)i;
+            }
+        }
+        // an empty slot means the key was never pushed past this group
+        if(Group_match_empty(group) != 0) {
+            return -1;
+        }
+        Probe_next(&probe);
+    }
+}
+
+/// first empty or deleted slot on hash's probe sequence
+static inline size_t Hashmap_find_free(Hashmap *map, uint64_t hash)
+{
+    Probe probe = Probe_start(map, hash);
+
+    while(1) {
+        const int8_t *group = map->ctrl + probe.group * HASHMAP_GROUP_WIDTH;
+        GroupMask mask = Group_match_free(group);
+        if(mask != 0) {
+            return probe.group * HASHMAP_GROUP_WIDTH + Mask_first(mask);
+        }
+        Probe_next(&probe);
+    }
+}
+
+/// rebuild the table at capacity, dropping all tombstones
+static int Hashmap_rehash(Hashmap *map, size_t capacity)
+{
+    int8_t *old_ctrl = map->ctrl;
+    HashmapEntry *old_entries = map->entries;
+    size_t old_capacity = map->capacity;
+    size_t i = 0;
+
+    check(Hashmap_alloc_table(map, capacity) == 0,
+            "Failed to grow Hashmap to %zu slots.", capacity);
+
+    for(i = 0; i < old_capacity; i++) {
+        if(old_ctrl[i] >= 0) {
+            uint64_t hash = map->hash(old_entries[i].key);
+            size_t slot = Hashmap_find_free(map, hash);
+            map->ctrl[slot] = H2(hash);
+            map->entries[slot] = old_entries[i];
+        }
+    }
+
+    free(old_ctrl);
+    free(old_entries);
+    return 0;
+
+error:
+    map->ctrl = old_ctrl;
+    map->entries = old_entries;
+    map->capacity = old_capacity;
+    return -1;
+}
+
+int Hashmap_reserve(Hashmap *map, size_t count)
+{
+    size_t capacity = map->capacity;
+
+    while(capacity - capacity / 8 < count) {
+        capacity *= 2;
+    }
+    if(capacity == map->capacity) {
+        return 0;
+    }
+    return Hashmap_rehash(map, capacity);
+}
+
+
+int Hashmap_set(Hashmap *map, void *key, void *data)
+{
+    uint64_t hash = map->hash(key);
+    long found = Hashmap_find(map, key, hash);
+
+    if(found >= 0) {
+        map->entries[found].data = data;
+        return 0;
+    }
+
+    size_t slot = Hashmap_find_free(map, hash);
+    if(map->ctrl[slot] == CTRL_EMPTY && map->growth_left == 0) {
+        // mostly tombstones: clean up in place, otherwise double
+        size_t capacity = map->count * 2 >= map->capacity - map->capacity / 8 ?
+            map->capacity * 2 : map->capacity;
+        check(Hashmap_rehash(map, capacity) == 0, "Failed to grow Hashmap.");
+        slot = Hashmap_find_free(map, hash);
+    }
+
+    if(map->ctrl[slot] == CTRL_EMPTY) {
+        map->growth_left--;
+    }
+    map->ctrl[slot] = H2(hash);
+    map->entries[slot].key = key;
+    map->entries[slot].data = data;
+    map->count++;
+    return 0;
+
+error:
+    return -1;
+}
+
+void *Hashmap_get(Hashmap *map, void *key)
+{
+    long found = Hashmap_find(map, key, map->hash(key));
+    return found >= 0 ? map->entries[found].data : NULL;
+}
+
+void *Hashmap_delete(Hashmap *map, void *key)
+{
+    long found = Hashmap_find(map, key, map->hash(key));
+    if(found < 0) {
+        return NULL;
+    }
+
+    void *data = map->entries[found].data;
+    size_t group = (size_t)found / HASHMAP_GROUP_WIDTH * HASHMAP_GROUP_WIDTH;
+
+    // probes stop at a group with an empty slot, so if this group has one
+    // nobody probes through it and the slot can simply be emptied
+    if(Group_match_empty(map->ctrl + group) != 0) {
+        map->ctrl[found] = CTRL_EMPTY;
+        map->growth_left++;
+    } else {
+        map->ctrl[found] = CTRL_DELETED;
+    }
+    map->entries[found].key = NULL;
+    map->entries[found].data = NULL;
+    map->count--;
+
+    return data;
+}
+
+int Hashmap_traverse(Hashmap *map, Hashmap_traverse_cb traverse_cb)
+{
+    size_t i = 0;
+    int rc = 0;
+
+    for(i = 0; i < map->capacity; i++) {
+        if(map->ctrl[i] >= 0) {
+            rc = traverse_cb(&map->entries[i]);
+            if(rc != 0) return rc;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,64 @@
+#ifndef _Hashmap_h
+#define _Hashmap_h
+
+#include <stdint.h>
+#include <stdlib.h>
+
+// control bytes examined together by one probe
+#define HASHMAP_GROUP_WIDTH 16
+#define DEFAULT_NUMBER_OF_BUCKETS 16
+
+typedef int (*Hashmap_compare)(void *a, void *b);
+typedef uint64_t (*Hashmap_hash)(void *key);
+
+typedef struct HashmapEntry {
+    void *key;
+    void *data;
+} HashmapEntry;
+
+/// An open addressing hash table with grouped control bytes.
+/**
+ * Each slot has a one byte tag in ctrl: empty, deleted, or the low 7 bits
+ * of the key's hash.  A lookup hashes once, then compares the tag against
+ * a whole group of HASHMAP_GROUP_WIDTH tags at a time (with SSE2 where
+ * available), and only touches entries whose tag matched.  Almost every
+ * lookup reads one group of tags and one entry.
+ *
+ * capacity is always a power of two, and the table grows once it is 7/8
+ * full.
+ */
+typedef struct Hashmap {
+    int8_t *ctrl;
+    HashmapEntry *entries;
+    size_t capacity;
+    size_t count;
+    size_t growth_left;
+    Hashmap_compare compare;
+    Hashmap_hash hash;
+} Hashmap;
+
+typedef int (*Hashmap_traverse_cb)(HashmapEntry *entry);
+
+/// Allocate a map.  NULL compare or hash select C string defaults.
+Hashmap *Hashmap_create(Hashmap_compare compare, Hashmap_hash hash);
+void Hashmap_destroy(Hashmap *map);
+
+/// Insert or replace the data stored under key.
+int Hashmap_set(Hashmap *map, void *key, void *data);
+void *Hashmap_get(Hashmap *map, void *key);
+
+/// Remove key, returning the data that was stored under it.
+void *Hashmap_delete(Hashmap *map, void *key);
+
+/// Size the table so count keys fit without rehashing.
+int Hashmap_reserve(Hashmap *map, size_t count);
+
+int Hashmap_traverse(Hashmap *map, Hashmap_traverse_cb traverse_cb);
+
+/// FNV-1a over a NUL terminated string, finished with a 64 bit mixer.
+uint64_t Hashmap_default_hash(void *key);
+
+#define Hashmap_count(M) ((M)->count)
+#define Hashmap_capacity(M) ((M)->capacity)
+
+#endif
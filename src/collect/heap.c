@@ -0,0 +1,280 @@
+#include <collect/heap.h>
+#include <dbg.h>
+
+
+static inline HeapEntry *Heap_entry(Heap *heap, int i)
+{
+    return (HeapEntry *)heap->entries->data + i;
+}
+
+static inline int *Heap_position(Heap *heap, int handle)
+{
+    return (int *)heap->positions->data + handle;
+}
+
+/// store entry at index i and point its handle at it
+static inline void Heap_place(Heap *heap, int i, HeapEntry entry)
+{
+    *Heap_entry(heap, i) = entry;
+    *Heap_position(heap, entry.handle) = i;
+}
+
+
+// A free handle's position holds -(next free handle + 2), so every free
+// position is negative and the chain ends at -1.
+static int Heap_take_handle(Heap *heap)
+{
+    int handle = heap->free_handle;
+    if(handle >= 0) {
+        heap->free_handle = -*Heap_position(heap, handle) - 2;
+        return handle;
+    }
+
+    int unused = -1;
+    handle = DArray_count(heap->positions);
+    check(DArray_push(heap->positions, &unused) == 0,
+            "Failed to grow heap handles.");
+    return handle;
+error:
+    return -1;
+}
+
+static void Heap_release_handle(Heap *heap, int handle)
+{
+    *Heap_position(heap, handle) = -(heap->free_handle + 2);
+    heap->free_handle = handle;
+}
+
+
+/// move the entry at i towards the root until its parent is no larger,
+/// shifting parents down into the hole.  Returns its final index.
+static int Heap_sift_up(Heap *heap, int i)
+{
+    HeapEntry entry = *Heap_entry(heap, i);
+
+    while(i > 0) {
+        int parent = (i - 1) / heap->arity;
+        HeapEntry *above = Heap_entry(heap, parent);
+        if(heap->compare(entry.value, above->value) >= 0) {
+            break;
+        }
+        Heap_place(heap, i, *above);
+        i = parent;
+    }
+
+    Heap_place(heap, i, entry);
+    return i;
+}
+
+/// move the entry at i towards the leaves until no child is smaller.
+static void Heap_sift_down(Heap *heap, int i)
+{
+    HeapEntry entry = *Heap_entry(heap, i);
+    int count = Heap_count(heap);
+
+    while(1) {
+        int first = i * heap->arity + 1;
+        if(first >= count) {
+            break;
+        }
+        int last = first + heap->arity < count ? first + heap->arity : count;
+        int best = first;
+        int child = 0;
+
+        // siblings are adjacent, so this scan stays within a line or two
+        for(child = first + 1; child < last; child++) {
+            if(heap->compare(Heap_entry(heap, child)->value,
+                        Heap_entry(heap, best)->value) < 0) {
+                best = child;
+            }
+        }
+
+        HeapEntry *below = Heap_entry(heap, best);
+        if(heap->compare(below->value, entry.value) >= 0) {
+            break;
+        }
+        Heap_place(heap, i, *below);
+        i = best;
+    }
+
+    Heap_place(heap, i, entry);
+}
+
+static inline void Heap_restore(Heap *heap, int i)
+{
+    if(Heap_sift_up(heap, i) == i) {
+        Heap_sift_down(heap, i);
+    }
+}
+
+/// take the entry at i out, filling the hole with the last entry.
+static HeapEntry Heap_take(Heap *heap, int i)
+{
+    HeapEntry taken = *Heap_entry(heap, i);
+    HeapEntry last = *(HeapEntry *)DArray_pop(heap->entries);
+
+    if(i < Heap_count(heap)) {
+        Heap_place(heap, i, last);
+        Heap_restore(heap, i);
+    }
+
+    Heap_release_handle(heap, taken.handle);
+    return taken;
+}
+
+
+static Heap *Heap_alloc(List_compare compare, int arity, int initial_max)
+{
+    Heap *heap = calloc(1, sizeof(Heap));
+    check_mem(heap);
+
+    if(initial_max < HEAP_MIN_CAPACITY) {
+        initial_max = HEAP_MIN_CAPACITY;
+    }
+
+    heap->compare = compare;
+    heap->arity = arity < 2 ? HEAP_DEFAULT_ARITY : arity;
+    heap->free_handle = -1;
+    heap->entries = DArray_create_inline(sizeof(HeapEntry), initial_max);
+    check_mem(heap->entries);
+    heap->positions = DArray_create_inline(sizeof(int), initial_max);
+    check_mem(heap->positions);
+
+    return heap;
+error:
+    Heap_destroy(heap);
+    return NULL;
+}
+
+Heap *Heap_create(List_compare compare, int arity)
+{
+    check(compare != NULL, "Heap needs a compare function.");
+    return Heap_alloc(compare, arity, HEAP_MIN_CAPACITY);
+error:
+    return NULL;
+}
+
+Heap *Heap_create_from(List_compare compare, int arity, DArray *values)
+{
+    Heap *heap = NULL;
+    int i = 0;
+
+    check(compare != NULL, "Heap needs a compare function.");
+    check(values != NULL && !DArray_is_inline(values),
+            "Heap_create_from needs a pointer mode DArray.");
+
+    int count = DArray_count(values);
+    heap = Heap_alloc(compare, arity, count);
+    check(heap != NULL, "Failed to allocate heap.");
+
+    for(i = 0; i < count; i++) {
+        HeapEntry entry = {.value = values->contents[i], .handle = i};
+        DArray_push(heap->entries, &entry);
+        DArray_push(heap->positions, &i);
+    }
+
+    // Floyd's heapify: sift down every internal node, deepest first
+    for(i = (count - 2) / heap->arity; count > 1 && i >= 0; i--) {
+        Heap_sift_down(heap, i);
+    }
+
+    return heap;
+error:
+    return NULL;
+}
+
+void Heap_destroy(Heap *heap)
+{
+    if(heap) {
+        if(heap->entries) DArray_destroy(heap->entries);
+        if(heap->positions) DArray_destroy(heap->positions);
+        free(heap);
+    }
+}
+
+void Heap_clear(Heap *heap)
+{
+    heap->entries->end = 0;
+    heap->positions->end = 0;
+    heap->free_handle = -1;
+}
+
+
+int Heap_push(Heap *heap, void *value)
+{
+    int handle = Heap_take_handle(heap);
+    check(handle >= 0, "Failed to allocate a heap handle.");
+
+    HeapEntry entry = {.value = value, .handle = handle};
+    if(DArray_push(heap->entries, &entry) != 0) {
+        Heap_release_handle(heap, handle);
+        sentinel("Failed to grow heap.");
+    }
+
+    Heap_sift_up(heap, Heap_count(heap) - 1);
+    return handle;
+error:
+    return -1;
+}
+
+void *Heap_peek(Heap *heap)
+{
+    return Heap_is_empty(heap) ? NULL : Heap_entry(heap, 0)->value;
+}
+
+void *Heap_pop(Heap *heap)
+{
+    if(Heap_is_empty(heap)) {
+        return NULL;
+    }
+    return Heap_take(heap, 0).value;
+}
+
+
+int Heap_contains(Heap *heap, int handle)
+{
+    return handle >= 0 && handle < DArray_count(heap->positions) &&
+        *Heap_position(heap, handle) >= 0;
+}
+
+void *Heap_value(Heap *heap, int handle)
+{
+    if(!Heap_contains(heap, handle)) {
+        return NULL;
+    }
+    return Heap_entry(heap, *Heap_position(heap, handle))->value;
+}
+
+int Heap_decrease_key(Heap *heap, int handle, void *value)
+{
+    check(Heap_contains(heap, handle), "Heap handle %d is not in the heap.",
+            handle);
+
+    int i = *Heap_position(heap, handle);
+    if(value != NULL) {
+        Heap_entry(heap, i)->value = value;
+    }
+    Heap_sift_up(heap, i);
+    return 0;
+error:
+    return -1;
+}
+
+int Heap_update(Heap *heap, int handle)
+{
+    check(Heap_contains(heap, handle), "Heap handle %d is not in the heap.",
+            handle);
+
+    Heap_restore(heap, *Heap_position(heap, handle));
+    return 0;
+error:
+    return -1;
+}
+
+void *Heap_remove(Heap *heap, int handle)
+{
+    if(!Heap_contains(heap, handle)) {
+        return NULL;
+    }
+    return Heap_take(heap, *Heap_position(heap, handle)).value;
+}
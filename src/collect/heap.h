@@ -0,0 +1,92 @@
+#ifndef _Heap_h
+#define _Heap_h
+
+#include <collect/darray.h>
+#include <collect/list.h>
+
+// children per node; four keeps a node's children on one cache line
+#define HEAP_DEFAULT_ARITY 4
+
+#define HEAP_MIN_CAPACITY 16
+
+/// One value in a heap, and the handle that tracks it.
+typedef struct HeapEntry {
+    void *value;
+    int handle;
+} HeapEntry;
+
+/// A min priority queue stored as a d-ary heap in a DArray.
+/**
+ * entries is an inline DArray of HeapEntry laid out in heap order, so a
+ * sift touches a few contiguous slots per level instead of chasing
+ * pointers.  A wider heap is shallower, trading a few more comparisons
+ * per level for fewer cache lines per sift.
+ *
+ * Every value pushed is given an int handle that stays valid until the
+ * value leaves the heap.  positions maps each handle to its entry's index,
+ * which is what lets Heap_decrease_key and Heap_remove find a value
+ * without searching.  Handles of values that have left are recycled
+ * through free_handle, a chain stored in positions itself.
+ */
+typedef struct Heap {
+    DArray *entries;
+    DArray *positions;
+    int free_handle;
+    int arity;
+    List_compare compare;
+} Heap;
+
+/// Allocate an empty heap ordered by compare, smallest first.
+/**
+ * arity below 2 selects HEAP_DEFAULT_ARITY.
+ */
+Heap *Heap_create(List_compare compare, int arity);
+
+/// Build a heap from every element of a pointer mode array in O(n).
+/**
+ * The values are heapified in place rather than pushed one by one.  The
+ * value at index i of values is given handle i.  values itself is not
+ * modified.
+ */
+Heap *Heap_create_from(List_compare compare, int arity, DArray *values);
+
+/// Free a heap, but not the values it holds.
+void Heap_destroy(Heap *heap);
+
+/// Remove every value, without freeing them.  Handles are invalidated.
+void Heap_clear(Heap *heap);
+
+#define Heap_count(H) DArray_count((H)->entries)
+#define Heap_is_empty(H) (Heap_count(H) == 0)
+
+/// Add a value, returning its handle, or -1 on allocation failure.
+int Heap_push(Heap *heap, void *value);
+
+/// The smallest value, or NULL if the heap is empty.
+void *Heap_peek(Heap *heap);
+
+/// Remove and return the smallest value, or NULL if the heap is empty.
+void *Heap_pop(Heap *heap);
+
+/// Returns true if handle refers to a value still in the heap.
+int Heap_contains(Heap *heap, int handle);
+
+/// The value a handle refers to, or NULL if it has left the heap.
+void *Heap_value(Heap *heap, int handle);
+
+/// Restore heap order after the value behind handle has become smaller.
+/**
+ * The caller changes the value itself (or swaps in value, if it is not
+ * NULL) and then calls this, which only ever sifts up.  Returns 0 on
+ * success, -1 if handle is not in the heap.
+ */
+int Heap_decrease_key(Heap *heap, int handle, void *value);
+
+/// Restore heap order after the value behind handle changed either way.
+int Heap_update(Heap *heap, int handle);
+
+/// Remove and return the value behind handle, or NULL if it is not in the
+/// heap.
+void *Heap_remove(Heap *heap, int handle);
+
+#endif
@@ -0,0 +1,261 @@
+/*
+ * Intrusive doubly linked list.
+ * Copyright (C) 2014 Axel Magnuson <axelmagn@gmail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <collect/intrusive_list.h>
+#include <collect/list.h>
+#include <collect/task_pool.h>
+#include <dbg.h>
+
+
+/// Initialize an empty list in caller owned memory.
+void IList_init(IList *list)
+{
+	list->count = 0;
+	list->first = NULL;
+	list->last = NULL;
+}
+
+
+/// Allocate a new, empty list from the heap.
+IList *IList_create()
+{
+	IList *list = calloc(1, sizeof(IList));
+	check_mem(list);
+	return list;
+error:
+	return NULL;
+}
+
+
+/// Free a list allocated by IList_create.
+void IList_destroy(IList *list)
+{
+	free(list);
+}
+
+
+/// retrieve the link at an index, or NULL if it is out of bounds.
+IListLink *IList_get(IList *list, int index)
+{
+	IListLink *out = NULL;
+	int i;
+
+	check(index >= 0 && index < list->count,
+			"IList size is %d.  Index %d out of bounds.",
+			list->count, index);
+
+	// seek from whichever side is closest
+	if(index <= list->count / 2) {
+		out = list->first;
+		for(i = 0; i < index; i++) {
+			out = out->next;
+		}
+	} else {
+		out = list->last;
+		for(i = list->count - 1; i > index; i--) {
+			out = out->prev;
+		}
+	}
+
+error:
+	return out;
+}
+
+
+/// push a link onto the end of the list.
+void IList_push(IList *list, IListLink *link)
+{
+	link->next = NULL;
+	link->prev = list->last;
+	if(list->last == NULL) {
+		list->first = link;
+	} else {
+		list->last->next = link;
+	}
+	list->last = link;
+	list->count++;
+}
+
+
+/// remove and return the end of the list.
+IListLink *IList_pop(IList *list)
+{
+	return list->last != NULL ? IList_remove(list, list->last) : NULL;
+}
+
+
+/// push a link onto the beginning of the list.
+void IList_unshift(IList *list, IListLink *link)
+{
+	link->prev = NULL;
+	link->next = list->first;
+	if(list->first == NULL) {
+		list->last = link;
+	} else {
+		list->first->prev = link;
+	}
+	list->first = link;
+	list->count++;
+}
+
+
+/// remove and return the beginning of the list.
+IListLink *IList_shift(IList *list)
+{
+	return list->first != NULL ? IList_remove(list, list->first) : NULL;
+}
+
+
+/// remove a link from the list, returning it.
+IListLink *IList_remove(IList *list, IListLink *link)
+{
+	check(link != NULL, "link can't be NULL");
+	check(list->first != NULL, "List is empty.");
+
+	if(link->prev == NULL) {
+		list->first = link->next;
+	} else {
+		link->prev->next = link->next;
+	}
+	if(link->next == NULL) {
+		list->last = link->prev;
+	} else {
+		link->next->prev = link->prev;
+	}
+	link->next = NULL;
+	link->prev = NULL;
+	list->count--;
+
+	return link;
+error:
+	return NULL;
+}
+
+
+/// relink prev pointers and the ends of list after a sort rebuilt next.
+static void IList_relink(IList *list, IListLink *first)
+{
+	IListLink *prev = NULL;
+	IListLink *cur = first;
+
+	list->first = first;
+	while(cur != NULL) {
+		cur->prev = prev;
+		prev = cur;
+		cur = cur->next;
+	}
+	list->last = prev;
+}
+
+
+static inline int IList_sort_compare(IList_compare comparator,
+		IListLink *p, IListLink *q)
+{
+	return comparator(p, q);
+}
+
+LIST_GENERATE_CHAIN_SORT(IList_sort_chain, IListLink, IList_compare,
+		IList_sort_compare)
+
+int IList_sort(IList *list, IList_compare comparator)
+{
+	check(comparator != NULL, "Received null comparator.");
+
+	// the bottom-up merge of List_sort, over links; prev is rebuilt after
+	IList_relink(list, IList_sort_chain(list->first, comparator));
+	return 0;
+
+error:
+	return -1;
+}
+
+
+/// A NULL terminated chain of count links to sort, possibly on a worker.
+typedef struct IListSortChain {
+	IListLink *head;
+	int count;
+	IList_compare comparator;
+} IListSortChain;
+
+/// stably merge two sorted chains through next.
+LIST_GENERATE_CHAIN_MERGE(IList_merge_chains, IListLink, IList_compare,
+		IList_sort_compare)
+
+
+/// sort a chain, returning its new head.
+static void *IList_merge_sort_chain(void *args)
+{
+	IListSortChain *chain = args;
+	IListSortChain left;
+	IListSortChain right;
+	int i;
+
+	if(chain->count < 2) {
+		return chain->head;
+	}
+
+	// cut the chain in two
+	IListLink *mid = chain->head;
+	for(i = 1; i < chain->count / 2; i++) {
+		mid = mid->next;
+	}
+	left.head = chain->head;
+	left.count = chain->count / 2;
+	left.comparator = chain->comparator;
+	right.head = mid->next;
+	right.count = chain->count - left.count;
+	right.comparator = chain->comparator;
+	mid->next = NULL;
+
+	IListLink *sorted_left = NULL;
+	IListLink *sorted_right = NULL;
+	if(chain->count >= ILIST_SORT_TASK_CUTOFF) {
+		Task task;
+		TaskPool *pool = TaskPool_default();
+		TaskPool_spawn(pool, &task, IList_merge_sort_chain, &left);
+		sorted_right = IList_merge_sort_chain(&right);
+		sorted_left = TaskPool_join(pool, &task);
+	} else {
+		sorted_left = IList_merge_sort_chain(&left);
+		sorted_right = IList_merge_sort_chain(&right);
+	}
+
+	return IList_merge_chains(sorted_left, sorted_right, chain->comparator);
+}
+
+
+int IList_merge_sort(IList *list, IList_compare comparator)
+{
+	IListSortChain chain;
+
+	check(comparator != NULL, "Received null comparator.");
+
+	chain.head = list->first;
+	chain.count = list->count;
+	chain.comparator = comparator;
+	IList_relink(list, IList_merge_sort_chain(&chain));
+	return 0;
+
+error:
+	return -1;
+}
@@ -0,0 +1,122 @@
+/*
+ * Intrusive doubly linked list.
+ * Copyright (C) 2014 Axel Magnuson <axelmagn@gmail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef collect_Intrusive_list_h
+#define collect_Intrusive_list_h
+
+#include <stddef.h>
+#include <stdlib.h>
+
+/// Links embedded in a user struct to put it on an IList.
+typedef struct IListLink {
+	struct IListLink *next;
+	struct IListLink *prev;
+} IListLink;
+
+/// A doubly linked list of links embedded in the caller's own structs.
+/**
+ * The list never allocates or frees anything but itself: elements are
+ * owned by the caller and carry their own IListLink, so pushing and
+ * removing only rewrite pointers, and walking the list touches the
+ * elements directly.  IList_entry recovers the containing struct from a
+ * link.  A link may be on at most one list at a time.
+ */
+typedef struct IList {
+	int count;
+	IListLink *first;
+	IListLink *last;
+} IList;
+
+/// Compares the structs containing two links, as List_compare does values.
+typedef int (*IList_compare)(IListLink *lhs, IListLink *rhs);
+
+
+/// The struct of type T whose member M is the link L.
+#define IList_entry(L, T, M) ((T *)((char *)(L) - offsetof(T, M)))
+
+
+/// Initialize an empty list in caller owned memory.
+void IList_init(IList *list);
+
+/// Allocate a new, empty list from the heap.
+IList *IList_create();
+
+/// Free a list allocated by IList_create.  The elements are untouched.
+void IList_destroy(IList *list);
+
+
+#define IList_count(A) ((A)->count)
+#define IList_first(A) ((A)->first)
+#define IList_last(A) ((A)->last)
+
+
+/// retrieve the link at an index, or NULL if it is out of bounds.
+IListLink *IList_get(IList *list, int index);
+
+
+/// push a link onto the end of the list.
+void IList_push(IList *list, IListLink *link);
+
+/// remove and return the end of the list.
+IListLink *IList_pop(IList *list);
+
+/// push a link onto the beginning of the list.
+void IList_unshift(IList *list, IListLink *link);
+
+/// remove and return the beginning of the list.
+IListLink *IList_shift(IList *list);
+
+/// remove a link from the list, returning it.
+IListLink *IList_remove(IList *list, IListLink *link);
+
+
+/// Stable, in-place bottom-up merge sort.
+/**
+ * As List_sort: links are relinked, and O(1) extra memory is used.
+ * Returns 0 on success.
+ */
+int IList_sort(IList *list, IList_compare comparator);
+
+/// Stable merge sort that sorts large halves in parallel.
+/**
+ * As List_merge_sort: halves of at least ILIST_SORT_TASK_CUTOFF links
+ * are sorted on the default TaskPool.  Returns 0 on success.
+ */
+int IList_merge_sort(IList *list, IList_compare comparator);
+
+#define ILIST_SORT_TASK_CUTOFF 4096
+
+
+/// convenience for loop iterating across an intrusive list.
+/**
+ * The next link is read before the body runs, so the body may remove V.
+ * @param L the list to iterate on.
+ * @param S the side of the list to start on. (first|last)
+ * @param M the direction in which to move. (next|prev)
+ * @param V the name to use for the pointer to the current link.
+ */
+#define ILIST_FOREACH(L, S, M, V) IListLink *_link = NULL;\
+	IListLink *V = NULL;\
+	for(V = (L)->S; V != NULL && ((_link = V->M), 1); V = _link)
+
+#endif
@@ -22,9 +22,16 @@
  */
 
 #include <collect/list.h>
+#include <collect/list_pool.h>
+#include <collect/darray_algos.h>
+#include <collect/task_pool.h>
 #include <dbg.h>
 
-#define DEFAULT_PTHREAD_LIMIT 50;
+#define DEFAULT_PTHREAD_LIMIT 50
+// slices smaller than this are not worth a task of their own
+#define SORT_TASK_CUTOFF 4096
+// lists at least this long are sorted through an array of their nodes
+#define SORT_ARRAY_CUTOFF SORT_TASK_CUTOFF
 
 
 typedef struct ListSortContext {
@@ -33,13 +40,30 @@ typedef struct ListSortContext {
 	int extent;
 	int max_threads;
 	List_compare comparator;
+	TaskPool *pool;
 	int *thread_count;
 	pthread_mutex_t *lock;
+	ListNode *sorted;
+	ListSortResult result;
 } ListSortContext;
 
 
 /// Allocate a new list from the heap.
 List *List_create()
+{
+	ListNodePool *pool = ListNodePool_create(LIST_POOL_MIN_CHUNK);
+	check(pool != NULL, "Failed to allocate List->pool");
+	List *out = List_create_pooled(pool);
+	// the list holds its own reference, leaving it the sole owner
+	ListNodePool_release(pool);
+	return out;
+error:
+	return NULL;
+}
+
+
+/// Allocate a new list that draws its nodes from a shared pool.
+List *List_create_pooled(ListNodePool *pool)
 {
 	List *out = calloc(1, sizeof(List));
 	check(out != NULL, "Failed to allocate List");
@@ -47,9 +71,11 @@ List *List_create()
 	check(out->lock != NULL, "Failed to allocate mutex List->lock");
 	int err = pthread_mutex_init(out->lock, NULL);
 	check(err == 0, "Failed to initialize mutex List->lock");
+	ListNodePool_retain(pool);
+	out->pool = pool;
 	return out;
 error:
-	if(out->lock) { free(out->lock); }
+	if(out && out->lock) { free(out->lock); }
 	if(out) { free(out); }
 	return NULL;
 }
@@ -65,16 +91,21 @@ void List_destroy(List *list)
 	if(list->first != NULL) {
 		check(list->last != NULL, "List has a first element but null "
 				"last.");
-		LIST_FOREACH(list, first, next, cur) {
-			if(cur->prev) {
-				free(cur->prev);
+		// a private pool only holds our nodes, so its chunks can go
+		// all at once.  Otherwise hand each node back for reuse.
+		if(!ListNodePool_is_private(list->pool)) {
+			ListNode *cur = list->first;
+			while(cur != NULL) {
+				ListNode *next = cur->next;
+				ListNodePool_free(list->pool, cur);
+				cur = next;
 			}
 		}
-		free(list->last);
 	} else {
 		check(list->last == NULL, "List has a null first element but a "
 				"non-null last.");
 	}
+	ListNodePool_release(list->pool);
 	pthread_mutex_destroy(list->lock);
 	free(list->lock);
 	free(list);
@@ -105,63 +136,113 @@ void List_clear(List *list)
  */
 void List_clear_destroy(List *list)
 {
-	if(list->first != NULL) {
-		check(list->last != NULL, "List has a first element but null "
-				"last.");
-		LIST_FOREACH(list, first, next, cur) {
-			free(cur->value);
-			if(cur->prev) {
-				free(cur->prev);
-			}
-		}
-		free(list->last);
-	} else {
-		check(list->last == NULL, "List has a null first element but a "
-				"non-null last.");
+	List_clear(list);
+	List_destroy(list);
+}
+
+
+
+
+/// step from node, which sits at from, to the node at index.
+static ListNode *List_step(ListNode *node, int from, int index)
+{
+	for(; from < index; from++) {
+		node = node->next;
 	}
-	pthread_mutex_destroy(list->lock);
-	free(list->lock);
-	free(list);
-	return;
-error:
-	return;
+	for(; from > index; from--) {
+		node = node->prev;
+	}
+	return node;
 }
 
 
+/// find the node at index, starting from whichever of the two ends and
+/// the known node at known_index is closest.  index must be in bounds.
+static ListNode *List_seek(List *list, ListNode *known, int known_index,
+		int index)
+{
+	ListNode *from = list->first;
+	int from_index = 0;
+	int distance = index;
+
+	if(list->count - 1 - index < distance) {
+		from = list->last;
+		from_index = list->count - 1;
+		distance = list->count - 1 - index;
+	}
+	if(known != NULL && abs(index - known_index) < distance) {
+		from = known;
+		from_index = known_index;
+	}
+
+	return List_step(from, from_index, index);
+}
 
 
-/// retrieve the nodel located at an index
+/// retrieve the node located at an index, or NULL if it is out of bounds.
 ListNode *List_get_node(List *list, int index) {
 	ListNode *out = NULL;
 
 	// validate input
 	check(list, "Received null pointer for list.");
-	check(index < list->count, "List size is %d.  Index %d out of bounds.", 
+	check(index >= 0 && index < list->count,
+			"List size is %d.  Index %d out of bounds.",
 			list->count, index);
 
-	// seek the node in question.  Seek from whichever side is closest to
-	// minimize time
-	int i;
-	if(index <= list->count / 2) { 
-		// seek forward
-		out = list->first;
-		for(i = 0; i < index; i++) {
-			out = out->next;
-		}
-	} else { 
-		// seek backward
-		out = list->last;
-		for(i = list->count - 1; i > index; i--) {
-			out = out->prev;
-		}
-	}
+	out = List_seek(list, list->cursor, list->cursor_index, index);
+	list->cursor = out;
+	list->cursor_index = index;
 error:
 	return out;
 }
 
 /// retrieve the value stored at an index
 void *List_get(List *list, int index) {
-	return List_get_node(list, index)->value;
+	ListNode *node = List_get_node(list, index);
+	return node != NULL ? node->value : NULL;
+}
+
+
+/// Point a cursor at the first node of a list.
+void ListCursor_init(ListCursor *cursor, List *list)
+{
+	cursor->list = list;
+	cursor->node = list->first;
+	cursor->index = 0;
+}
+
+
+/// Move a cursor offset nodes forward, or backward if offset is negative.
+ListNode *ListCursor_seek(ListCursor *cursor, int offset)
+{
+	return ListCursor_seek_to(cursor, cursor->index + offset);
+}
+
+
+/// Move a cursor to an index.
+ListNode *ListCursor_seek_to(ListCursor *cursor, int index)
+{
+	List *list = cursor->list;
+	if(index < 0 || index >= list->count) {
+		return NULL;
+	}
+
+	cursor->node = List_seek(list, cursor->node, cursor->index, index);
+	cursor->index = index;
+	return cursor->node;
+}
+
+
+/// Remove the cursor's node, moving the cursor to the node after it.
+void *ListCursor_remove(ListCursor *cursor)
+{
+	ListNode *node = cursor->node;
+	check(node != NULL, "Cursor is past the end of the list.");
+
+	cursor->node = node->next;
+	return List_remove(cursor->list, node);
+error:
+	return NULL;
 }
 
 
@@ -169,7 +250,7 @@ void *List_get(List *list, int index) {
 void List_push(List *list, void *value)
 {
 	// allocate a new node
-	ListNode *node = calloc(1, sizeof(ListNode));
+	ListNode *node = ListNodePool_alloc(list->pool);
 	check_mem(node);
 
 	// store the value in the new node
@@ -203,7 +284,7 @@ void *List_pop(List *list)
 /// push a new value onto the beginning of the list.
 void List_unshift(List *list, void *value)
 {
-	ListNode *node = calloc(1, sizeof(ListNode));
+	ListNode *node = ListNodePool_alloc(list->pool);
 	check_mem(node);
 
 	node->value = value;
@@ -218,6 +299,7 @@ void List_unshift(List *list, void *value)
 	}
 
 	list->count++;
+	list->cursor_index++;
 
 error:
 	return;
@@ -242,6 +324,20 @@ void *List_remove(List *list, ListNode *node)
 	check(list->first && list->last, "List is empty.");
 	check(node, "node can't be NULL");
 
+	// keep the cached position when we can tell where it ends up
+	if(node == list->cursor) {
+		if(node->prev != NULL) {
+			list->cursor = node->prev;
+			list->cursor_index--;
+		} else {
+			list->cursor = node->next;
+		}
+	} else if(node == list->first) {
+		list->cursor_index--;
+	} else if(node != list->last) {
+		list->cursor = NULL;
+	}
+
 	// unlink node from list
 	if(node == list->first && node == list->last) {	
 		list->first = NULL;
@@ -271,14 +367,409 @@ void *List_remove(List *list, ListNode *node)
 	// adjust count
 	list->count--;
 
-	// store the value and delete the orphan node
+	// store the value and recycle the orphan node
 	result = node->value;
-	free(node);
+	ListNodePool_free(list->pool, node);
 
 error:
 	return result;
 }
 
+
+/// detach a run of count nodes, first through last, from a list.
+static void List_unlink_run(List *list, ListNode *first, ListNode *last,
+		int count)
+{
+	if(first->prev == NULL) {
+		list->first = last->next;
+	} else {
+		first->prev->next = last->next;
+	}
+	if(last->next == NULL) {
+		list->last = first->prev;
+	} else {
+		last->next->prev = first->prev;
+	}
+	first->prev = NULL;
+	last->next = NULL;
+	list->count -= count;
+	list->cursor = NULL;
+}
+
+
+/// attach a detached run of count nodes into a list before at, or at the
+/// end when at is NULL.
+static void List_link_run(List *list, ListNode *at, ListNode *first,
+		ListNode *last, int count)
+{
+	ListNode *before = at != NULL ? at->prev : list->last;
+
+	first->prev = before;
+	last->next = at;
+	if(before == NULL) {
+		list->first = first;
+	} else {
+		before->next = first;
+	}
+	if(at == NULL) {
+		list->last = last;
+	} else {
+		// indexes from at onwards have moved
+		at->prev = last;
+		list->cursor = NULL;
+	}
+	list->count += count;
+}
+
+
+/// get dest and src drawing from the same pool, merging a private pool
+/// into the other.  Returns -1 if both pools are shared with other lists.
+static int List_share_pool(List *dest, List *src)
+{
+	List *owner = NULL;
+	List *joiner = NULL;
+
+	if(dest->pool == src->pool) {
+		return 0;
+	} else if(ListNodePool_is_private(src->pool)) {
+		owner = dest;
+		joiner = src;
+	} else if(ListNodePool_is_private(dest->pool)) {
+		owner = src;
+		joiner = dest;
+	} else {
+		return -1;
+	}
+
+	ListNodePool_adopt(owner->pool, joiner->pool);
+	ListNodePool_retain(owner->pool);
+	ListNodePool_release(joiner->pool);
+	joiner->pool = owner->pool;
+	return 0;
+}
+
+
+/// copy the values of first through last into a new chain of nodes from
+/// pool, storing its end in *tail.  Returns NULL, having allocated nothing,
+/// if a node can't be allocated.
+static ListNode *List_copy_run(ListNodePool *pool, ListNode *first,
+		ListNode *last, ListNode **tail)
+{
+	ListNode *head = NULL;
+	ListNode *cur = NULL;
+
+	*tail = NULL;
+	for(cur = first; cur != last->next; cur = cur->next) {
+		ListNode *node = ListNodePool_alloc(pool);
+		check_mem(node);
+		node->value = cur->value;
+		node->prev = *tail;
+		if(*tail == NULL) {
+			head = node;
+		} else {
+			(*tail)->next = node;
+		}
+		*tail = node;
+	}
+	return head;
+
+error:
+	if(head != NULL) {
+		ListNodePool_free_chain(pool, head, *tail);
+	}
+	return NULL;
+}
+
+
+/// move a run between lists with unrelated pools by copying its values
+/// into new nodes from dest's pool.  Nothing changes if allocation fails.
+static int List_splice_copy(List *dest, ListNode *at, List *src,
+		ListNode *first, ListNode *last, int count)
+{
+	ListNode *tail = NULL;
+	ListNode *head = List_copy_run(dest->pool, first, last, &tail);
+	if(head == NULL) {
+		return -1;
+	}
+
+	List_unlink_run(src, first, last, count);
+	ListNodePool_free_chain(src->pool, first, last);
+	List_link_run(dest, at, head, tail, count);
+	return 0;
+}
+
+
+/// move every node of src onto the end of dest, leaving src empty.
+int List_concat(List *dest, List *src)
+{
+	check(dest != NULL && src != NULL, "Received null pointer for list.");
+	check(dest != src, "Can't concatenate a list onto itself.");
+
+	if(src->first == NULL) {
+		return 0;
+	}
+
+	// src ends up empty, so its private pool can hand everything over and
+	// stay private, rather than being shared with dest
+	if(dest->pool != src->pool && ListNodePool_is_private(src->pool)) {
+		ListNodePool_adopt(dest->pool, src->pool);
+	} else if(List_share_pool(dest, src) != 0) {
+		return List_splice_copy(dest, NULL, src, src->first, src->last,
+				src->count);
+	}
+
+	ListNode *first = src->first;
+	ListNode *last = src->last;
+	int count = src->count;
+	List_unlink_run(src, first, last, count);
+	List_link_run(dest, NULL, first, last, count);
+	return 0;
+
+error:
+	return -1;
+}
+
+
+/// move the nodes first through last from src into dest, before at.
+int List_splice(List *dest, ListNode *at, List *src, ListNode *first,
+		ListNode *last, int count)
+{
+	check(dest != NULL && src != NULL, "Received null pointer for list.");
+	check(first != NULL && last != NULL, "Received null pointer for node.");
+
+	if(count < 0) {
+		ListNode *cur = first;
+		for(count = 1; cur != last; count++) {
+			cur = cur->next;
+			check(cur != NULL, "last does not follow first in src.");
+		}
+	}
+
+	if(List_share_pool(dest, src) != 0) {
+		return List_splice_copy(dest, at, src, first, last, count);
+	}
+
+	List_unlink_run(src, first, last, count);
+	List_link_run(dest, at, first, last, count);
+	return 0;
+
+error:
+	return -1;
+}
+
+
+/// split a list in two at an index.
+List *List_split_at(List *list, int index)
+{
+	List *out = NULL;
+
+	check(list != NULL, "Received null pointer for list.");
+	check(index >= 0 && index <= list->count,
+			"List size is %d.  Index %d out of bounds.", list->count, index);
+
+	out = List_create_pooled(list->pool);
+	check(out != NULL, "Failed to allocate split List.");
+
+	if(index < list->count) {
+		ListNode *first = List_get_node(list, index);
+		ListNode *last = list->last;
+		int count = list->count - index;
+		List_unlink_run(list, first, last, count);
+		List_link_run(out, NULL, first, last, count);
+	}
+
+	return out;
+
+error:
+	return NULL;
+}
+
+
+/// move a list's nodes next to each other, in list order.
+int List_compact(List *list)
+{
+	ListNodePool *pool = NULL;
+	ListNodePool *fresh = NULL;
+	int i;
+
+	check(list != NULL, "Received null pointer for list.");
+	if(list->count == 0) {
+		return 0;
+	}
+
+	pool = list->pool;
+
+	// a private pool only holds this list, so start a new one and drop
+	// the old wholesale
+	if(ListNodePool_is_private(pool)) {
+		fresh = ListNodePool_create(pool->chunk_size);
+		check(fresh != NULL, "Failed to allocate List->pool");
+		pool = fresh;
+	}
+
+	ListNode *nodes = ListNodePool_alloc_run(pool, list->count);
+	check(nodes != NULL, "Failed to allocate compacted nodes.");
+
+	ListNode *cur = list->first;
+	for(i = 0; i < list->count; i++, cur = cur->next) {
+		nodes[i].value = cur->value;
+		nodes[i].prev = i > 0 ? &nodes[i - 1] : NULL;
+		nodes[i].next = i < list->count - 1 ? &nodes[i + 1] : NULL;
+	}
+
+	if(fresh != NULL) {
+		ListNodePool_release(list->pool);
+		list->pool = fresh;
+	} else {
+		ListNodePool_free_chain(pool, list->first, list->last);
+	}
+	list->first = &nodes[0];
+	list->last = &nodes[list->count - 1];
+	list->cursor = NULL;
+	return 0;
+
+error:
+	if(fresh != NULL) { ListNodePool_release(fresh); }
+	return -1;
+}
+
+
+/// push a new value onto the end of the list, under the list's lock.
+void List_push_ts(List *list, void *value)
+{
+	pthread_mutex_lock(list->lock);
+	List_push(list, value);
+	pthread_mutex_unlock(list->lock);
+}
+
+
+/// remove and return the end of the list, under the list's lock.
+void *List_pop_ts(List *list)
+{
+	pthread_mutex_lock(list->lock);
+	void *out = List_pop(list);
+	pthread_mutex_unlock(list->lock);
+	return out;
+}
+
+
+/// push a new value onto the beginning of the list, under the list's lock.
+void List_unshift_ts(List *list, void *value)
+{
+	pthread_mutex_lock(list->lock);
+	List_unshift(list, value);
+	pthread_mutex_unlock(list->lock);
+}
+
+
+/// remove and return the beginning of the list, under the list's lock.
+void *List_shift_ts(List *list)
+{
+	pthread_mutex_lock(list->lock);
+	void *out = List_shift(list);
+	pthread_mutex_unlock(list->lock);
+	return out;
+}
+
+
+/// retrieve the value stored at an index, or NULL if it is out of bounds.
+void *List_get_ts(List *list, int index)
+{
+	void *out = NULL;
+	pthread_mutex_lock(list->lock);
+	if(index >= 0 && index < list->count) {
+		out = List_get_node(list, index)->value;
+	}
+	pthread_mutex_unlock(list->lock);
+	return out;
+}
+
+
+/// read the number of values in the list, under the list's lock.
+int List_count_ts(List *list)
+{
+	pthread_mutex_lock(list->lock);
+	int out = list->count;
+	pthread_mutex_unlock(list->lock);
+	return out;
+}
+
+
+/// push count values onto the end of the list in order.
+int List_push_batch_ts(List *list, void **values, int count)
+{
+	int pushed = 0;
+	ListNode *first = NULL;
+	ListNode *last = NULL;
+
+	pthread_mutex_lock(list->lock);
+
+	// build the chain first, then attach it to the list in one step
+	for(pushed = 0; pushed < count; pushed++) {
+		ListNode *node = ListNodePool_alloc(list->pool);
+		check_mem(node);
+		node->value = values[pushed];
+		node->prev = last;
+		if(last == NULL) {
+			first = node;
+		} else {
+			last->next = node;
+		}
+		last = node;
+	}
+
+error:
+	if(first != NULL) {
+		if(list->last == NULL) {
+			list->first = first;
+		} else {
+			list->last->next = first;
+			first->prev = list->last;
+		}
+		list->last = last;
+		list->count += pushed;
+	}
+	pthread_mutex_unlock(list->lock);
+	return pushed;
+}
+
+
+/// remove up to max values from the beginning of the list into out.
+int List_shift_batch_ts(List *list, void **out, int max)
+{
+	int shifted = 0;
+
+	pthread_mutex_lock(list->lock);
+
+	ListNode *first = list->first;
+	ListNode *last = NULL;
+	ListNode *cur = first;
+	while(shifted < max && cur != NULL) {
+		out[shifted++] = cur->value;
+		last = cur;
+		cur = cur->next;
+	}
+
+	if(shifted > 0) {
+		list->first = cur;
+		if(cur == NULL) {
+			list->last = NULL;
+		} else {
+			cur->prev = NULL;
+		}
+		list->count -= shifted;
+		if(list->cursor_index < shifted) {
+			list->cursor = NULL;
+		}
+		list->cursor_index -= shifted;
+		// the removed nodes are still chained, so recycle them together
+		ListNodePool_free_chain(list->pool, first, last);
+	}
+
+	pthread_mutex_unlock(list->lock);
+	return shifted;
+}
+
 /// Create a context for sort subroutines to share
 ListSortContext *ListSortContext_create( List *list, ListNode *start, 
 		int extent, int max_threads, List_compare comparator)
@@ -299,8 +790,8 @@ ListSortContext *ListSortContext_create( List *list, ListNode *start,
 	out->comparator = comparator;
 	return out;
 error:
-	if(out->thread_count) { free(out->thread_count); }
-	if(out->lock) { free(out->lock); }
+	if(out && out->thread_count) { free(out->thread_count); }
+	if(out && out->lock) { free(out->lock); }
 	if(out) { free(out); }
 	return NULL;
 }
@@ -309,53 +800,174 @@ error:
 void ListSortContext_destroy(ListSortContext *context) {
 	pthread_mutex_destroy(context->lock);
 	free(context->lock);
+	free(context->thread_count);
 	free(context);
 	return;
 }
 
-/// Create a new context that shares context info with the one provided, but
-/// can specify a new start and extent to sort
-ListSortContext *ListSortContext_fork(ListSortContext *other) {
-	ListSortContext *out = calloc(1, sizeof(ListSortContext));
-	check(out != NULL, "Failed to allocate ListSortContext");
-	out->lock = other->lock;
-	out->thread_count = other->thread_count;
-	out->list = other->list;
-	out->start = other->start;
-	out->extent = other->extent;
-	out->max_threads = other->max_threads;
-	out->comparator = other->comparator;
+/// Increment thread count by given amount.  If the new thread count would
+/// exceed max_threads, then it is not incremented at all.  Returns amount
+/// incremented (0 if unsuccessful). Amount may be negative.
+int ListSortContext_increment_threads(ListSortContext *context, int amount) {
+	int out = amount;
+	pthread_mutex_lock(context->lock);
+	// check that it does not exceed max threads, or drop below 0
+	if(*(context->thread_count) + amount > context->max_threads ||
+			*(context->thread_count) + amount < 0) {
+		out = 0;
+	} else {
+		*(context->thread_count) += amount;
+	}
+	pthread_mutex_unlock(context->lock);
 	return out;
-error:
-	if(out) { free(out); }
-	return NULL;
 }
 
-/// Free a sort context without freeing any shared information
-void ListSortContext_merge(ListSortContext *context) {
-	free(context);
-	return;
+
+static inline int sublist_compare(List_compare comparator, ListNode *p,
+		ListNode *q)
+{
+	return comparator(p->value, q->value);
 }
 
-/// Increment thread count by given amount.  If the new thread count would
-/// exceed max_threads, then it is not incremented at all.  Returns amount
-/// incremented (0 if unsuccessful). Amount may be negative.
-int ListSortContext_increment_threads(ListSortContext *context, int amount) {
-	// check that it does not exceed max threads
-	if(*(out->thread_count) + amount > out->max_threads) {
-		return 0;
+/// merge two sorted, NULL terminated chains linked through next.
+/// Ties are taken from the left chain, so the merge is stable.
+LIST_GENERATE_CHAIN_MERGE(sublist_merge, ListNode, List_compare,
+		sublist_compare)
+
+
+/// sort a slice of the list
+/**
+ * Sorts the context->extent nodes following context->start by relinking
+ * their next pointers.  The slice must already be cut off from the rest of
+ * the chain.  The head of the sorted chain is left in context->sorted; prev
+ * pointers are not maintained until the top level fixes them up.
+ */
+void *sublist_merge_sort(void *args) 
+{
+	ListSortContext *context = (ListSortContext *)args;
+	ListSortContext left_context = *context;
+	ListSortContext right_context = *context;
+	ListNode *start = context->start;
+	int extent = context->extent;
+	int spawned = 0;
+	Task left_task;
+
+	context->result = ERROR;
+
+	// test for termination conditions. If the slice size is 1 or less,
+	// then it's sorted.
+	if(extent <= 1) {
+		context->sorted = start;
+		context->result = SUCCESS;
+		return context;
 	}
-	// check that it does not drop below 0
-	if(*(out->thread_count) + amount < 0) {
-		return 0;
+
+	// split list, cutting the chain after the left half
+	int left_extent = extent / 2;
+	int right_extent = extent - extent / 2;
+	ListNode *left_end = start;
+	int i;
+	for(i = 1; i < left_extent; i++) {
+		left_end = left_end->next;
+		check(left_end != NULL, "Found null next ptr within extent");
+	}
+	ListNode *right_start = left_end->next;
+	check(right_start != NULL, "Found null next ptr within extent");
+	left_end->next = NULL;
+
+	left_context.start = start;
+	left_context.extent = left_extent;
+	right_context.start = right_start;
+	right_context.extent = right_extent;
+
+	// if the budget allows, queue the left half on the task pool while
+	// this thread handles the right half.  otherwise, recurse in place.
+	if(extent >= SORT_TASK_CUTOFF &&
+			ListSortContext_increment_threads(context, 1) == 1) {
+		TaskPool_spawn(context->pool, &left_task,
+				sublist_merge_sort, &left_context);
+		spawned = 1;
+	} else {
+		sublist_merge_sort(&left_context);
+	}
+
+	sublist_merge_sort(&right_context);
+
+	if(spawned) {
+		TaskPool_join(context->pool, &left_task);
+		ListSortContext_increment_threads(context, -1);
 	}
-	*(out->thread_count) = *(out->thread_count) + amount;
-	return amount;
+
+	check(left_context.result == SUCCESS, "Left sort failed.");
+	check(right_context.result == SUCCESS, "Right sort failed.");
+
+	context->sorted = sublist_merge(left_context.sorted, 
+			right_context.sorted, context->comparator);
+	context->result = SUCCESS;
+
+error:
+	return context;
 }
 
-/// merge sort the list
+
+/// sort a list by gathering its nodes into an array, merge sorting that
+/// with DArray_merge_sort_nodes, and relinking the nodes in the new order.
+/// Returns -1, leaving the list untouched, if the array can't be allocated.
+static int List_array_sort(List *list, List_compare comparator,
+		TaskPool *pool)
+{
+	int n = list->count;
+	int i;
+
+	DArray *nodes = DArray_create(sizeof(ListNode *), n);
+	if(nodes == NULL) {
+		return -1;
+	}
+
+	ListNode *cur = list->first;
+	for(i = 0; i < n; i++, cur = cur->next) {
+		nodes->contents[i] = cur;
+	}
+	nodes->end = n;
+
+	if(DArray_merge_sort_nodes(nodes, comparator, pool) != 0) {
+		DArray_destroy(nodes);
+		return -1;
+	}
+
+	ListNode **sorted = (ListNode **)nodes->contents;
+	for(i = 0; i < n; i++) {
+		sorted[i]->prev = i > 0 ? sorted[i - 1] : NULL;
+		sorted[i]->next = i < n - 1 ? sorted[i + 1] : NULL;
+	}
+	list->first = sorted[0];
+	list->last = sorted[n - 1];
+	List_reset_cursor(list);
+
+	DArray_destroy(nodes);
+	return 0;
+}
+
+
+ListSortResult List_merge_sort(List *list, List_compare comparator)
+{
+	return List_merge_sort_on(list, comparator, TaskPool_default());
+}
+
+/// merge sort the list on a caller supplied pool
 /// returns result status.
-ListSortResult List_merge_sort(List *list, List_compare comparator) 
+/**
+ * Nodes are relinked in place, so no nodes or lists are allocated.  Lists
+ * of at least SORT_ARRAY_CUTOFF nodes are sorted through a temporary array
+ * of node pointers by DArray_merge_sort_nodes, which splits long merges
+ * between the workers by co-ranking.  Shorter lists, or any list when the
+ * array can't be allocated, are sorted by relinking chains, with halves of
+ * at least SORT_TASK_CUTOFF nodes sorted in parallel and at most
+ * DEFAULT_PTHREAD_LIMIT of them queued or running at once.  The sort is
+ * stable.
+ */
+ListSortResult List_merge_sort_on(List *list, List_compare comparator,
+		TaskPool *pool)
 {
 	// 1. Divide the unsorted list into n sublists, each containing 1
 	//    element
@@ -364,58 +976,209 @@ ListSortResult List_merge_sort(List *list, List_compare comparator)
 	//    list
 	
 	ListSortResult out = ERROR;
+	ListSortContext *context = NULL;
 
-	ListSortContext *context = ListSortContext_create(list, list->first, 
-			list->count, DEFAULT_PTHREAD_LIMIT, comparator);
+	check(list != NULL, "Received null pointer for list.");
+	check(comparator != NULL, "Received null comparator.");
 
 	pthread_mutex_lock(list->lock);
-	long err = (long)sublist_merge_sort((void *)context);
+
+	// long lists are sorted as an array, where every merge can be split
+	// across the pool.  The chain sort below is the fallback if the array
+	// can't be allocated.
+	if(list->count >= SORT_ARRAY_CUTOFF &&
+			List_array_sort(list, comparator, pool) == 0) {
+		pthread_mutex_unlock(list->lock);
+		return SUCCESS;
+	}
+
+	context = ListSortContext_create(list, list->first, list->count, 
+			DEFAULT_PTHREAD_LIMIT, comparator);
+	if(context != NULL) {
+		context->pool = pool;
+		sublist_merge_sort(context);
+		out = context->result;
+	}
+
+	if(out == SUCCESS) {
+		// restore prev pointers and the ends of the list
+		ListNode *prev = NULL;
+		ListNode *cur = context->sorted;
+		list->first = cur;
+		while(cur != NULL) {
+			cur->prev = prev;
+			prev = cur;
+			cur = cur->next;
+		}
+		list->last = prev;
+		List_reset_cursor(list);
+	}
+
 	pthread_mutex_unlock(list->lock);
+
+	check(context != NULL, "Failed to create sort context.");
+	check(out == SUCCESS, "Merge sort failed.");
+
 error:
-	return out:
+	if(context != NULL) { ListSortContext_destroy(context); }
+	return out;
 }
 
 
-/// sort a slice of the list
-void *sublist_merge_sort(void *args) 
+/// true if run a's head should come out of the merge before run b's.
+/// Exhausted runs lose to everything, and ties go to the earlier list.
+static inline int List_merge_beats(ListNode **heads, int a, int b,
+		List_compare comparator)
 {
-	ListSortContext *context = (ListSortContext *)args;
-	ListNode *start = context->start;
-	int extent = context->extent;
+	if(heads[a] == NULL) {
+		return 0;
+	}
+	if(heads[b] == NULL) {
+		return 1;
+	}
+	int rc = comparator(heads[a]->value, heads[b]->value);
+	return rc < 0 || (rc == 0 && a < b);
+}
 
-	// test for termination conditions. If the slice size is 1 or less,
-	// then it's sorted.
-	if(extent <= 1) {
-		return;
+
+/// merge k sorted lists into lists[0], leaving the others empty.
+int List_merge_k(List **lists, int k, List_compare comparator)
+{
+	ListNode **heads = NULL;
+	int *tree = NULL;
+	int *winners = NULL;
+	List *dest = NULL;
+	ListNodePool *pool = NULL;
+	int total = 0;
+	int i = 0;
+
+	check(lists != NULL && k > 0, "Received no lists to merge.");
+	check(comparator != NULL, "Received null comparator.");
+	dest = lists[0];
+
+	heads = calloc(k, sizeof(ListNode *));
+	check_mem(heads);
+	// tree[1..k-1] holds the loser at each internal node and tree[0] the
+	// overall winner.  Run i is the leaf at k + i, so a node's parent is
+	// at half its index.  winners is scratch for building the tree.
+	tree = calloc(3 * k, sizeof(int));
+	check_mem(tree);
+	winners = tree + k;
+
+	// every node must end up in dest's pool.  As in List_concat, a
+	// private pool hands its chunks over and stays private, since its list
+	// ends up empty, and a private dest joins the first shared pool it
+	// meets.  Runs that still can't share are copied into the pool dest
+	// will end up with.  All copies are made before any pool changes
+	// hands, so a failed allocation leaves every list as it was.
+	pool = dest->pool;
+	int joinable = ListNodePool_is_private(pool);
+	for(i = 0; i < k; i++) {
+		check(lists[i] != NULL, "Received null pointer for list.");
+		heads[i] = lists[i]->first;
+		if(i == 0 || heads[i] == NULL || pool == lists[i]->pool ||
+				ListNodePool_is_private(lists[i]->pool)) {
+			continue;
+		}
+		if(joinable) {
+			pool = lists[i]->pool;
+			joinable = 0;
+			continue;
+		}
+		ListNode *tail = NULL;
+		heads[i] = List_copy_run(pool, lists[i]->first, lists[i]->last,
+				&tail);
+		check(heads[i] != NULL, "Failed to copy list %d to merge.", i);
 	}
 
-	// split list
-	int left_extent = extent / 2;
-	int right_extent = extent - extent / 2;
-	ListNode *right_start = start;
-	int i;
-	for(i = 0; i < left_extent; i++) {
-		right_start = right_start->next;
-		check(midpoint != NULL, "Found null next ptr within extent");
+	// nothing below can fail
+	for(i = 1; i < k; i++) {
+		List *list = lists[i];
+		if(list->first == NULL || heads[i] != list->first ||
+				dest->pool == list->pool) {
+			continue;
+		}
+		if(ListNodePool_is_private(list->pool)) {
+			ListNodePool_adopt(dest->pool, list->pool);
+		} else {
+			List_share_pool(dest, list);
+		}
 	}
 
-	// sort sublists, spawning threads if available
-	pthread_mutex_lock(context->lock);
-	// if threads are available, spawn threads for subsorts
-	// otherwise, do them recursively in this thread.
-	int incr = ListSortContext_increment_threads(context, 2);
-	int threaded = 0;
-	if(incr == 2) {
-		threaded = 1;
-		left_context = ListSortContext_fork(context);
-		left_context->start = start; // redundant, but safe
-		left_context->extent = left_extent;
-		right_context = ListSortContext_fork(context);
-		right_context->start = right_start;
-		right_context->extent = right_extent;
-		// TODO
-	} else {
-		// TODO
+	for(i = 0; i < k; i++) {
+		List *list = lists[i];
+		if(list->first != NULL && heads[i] != list->first) {
+			ListNodePool_free_chain(list->pool, list->first, list->last);
+		}
+		total += list->count;
+		list->first = NULL;
+		list->last = NULL;
+		list->count = 0;
+		list->cursor = NULL;
 	}
-	pthread_mutex_unlock(context->lock);
+
+	// build the loser tree bottom up, carrying each subtree's winner
+	// upwards in the scratch half
+	for(i = 0; i < k; i++) {
+		winners[k + i] = i;
+	}
+	for(i = k - 1; i >= 1; i--) {
+		int a = winners[2 * i];
+		int b = winners[2 * i + 1];
+		int a_wins = List_merge_beats(heads, a, b, comparator);
+		winners[i] = a_wins ? a : b;
+		tree[i] = a_wins ? b : a;
+	}
+	tree[0] = k > 1 ? winners[1] : 0;
+
+	ListNode *tail = NULL;
+	int winner = tree[0];
+	while(heads[winner] != NULL) {
+		ListNode *node = heads[winner];
+		heads[winner] = node->next;
+		node->prev = tail;
+		if(tail == NULL) {
+			dest->first = node;
+		} else {
+			tail->next = node;
+		}
+		tail = node;
+
+		// replay the winner's path, trading places with any stored loser
+		// that now beats it
+		int n;
+		for(n = (winner + k) / 2; n >= 1; n /= 2) {
+			if(List_merge_beats(heads, tree[n], winner, comparator)) {
+				int loser = winner;
+				winner = tree[n];
+				tree[n] = loser;
+			}
+		}
+	}
+
+	if(tail != NULL) {
+		tail->next = NULL;
+	}
+	dest->last = tail;
+	dest->count = total;
+
+	free(tree);
+	free(heads);
+	return 0;
+
+error:
+	if(heads != NULL && tree != NULL) {
+		for(i--; i > 0; i--) {
+			if(heads[i] != NULL && heads[i] != lists[i]->first) {
+				ListNode *last = heads[i];
+				while(last->next != NULL) {
+					last = last->next;
+				}
+				ListNodePool_free_chain(pool, heads[i], last);
+			}
+		}
+	}
+	if(tree != NULL) { free(tree); }
+	if(heads != NULL) { free(heads); }
+	return -1;
 }
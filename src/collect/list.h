@@ -29,6 +29,8 @@
 
 
 struct ListNode;
+struct ListNodePool;
+struct TaskPool;
 
 /// A Node within a Linked List.
 typedef struct ListNode {
@@ -38,13 +40,37 @@ typedef struct ListNode {
 } ListNode;
 
 /// A Doubly Linked List.
+/**
+ * Nodes are allocated from pool, which is private to the list unless it
+ * was created with List_create_pooled.  Every node in a list always comes
+ * from that list's pool.
+ *
+ * cursor caches the node most recently found by index, at cursor_index,
+ * so that List_get can step from it instead of from either end.  It is
+ * NULL when nothing is cached.
+ */
 typedef struct List {
 	pthread_mutex_t *lock;
 	int count;
 	ListNode *first;
 	ListNode *last;
+	struct ListNodePool *pool;
+	ListNode *cursor;
+	int cursor_index;
 } List;
 
+/// A position within a List, for walking it by index.
+/**
+ * Cursors are owned by the caller, usually on the stack.  A cursor is only
+ * valid until its list is next modified, other than through
+ * ListCursor_remove on that same cursor.
+ */
+typedef struct ListCursor {
+	struct List *list;
+	ListNode *node;
+	int index;
+} ListCursor;
+
 typedef enum {
 	SUCCESS,
 	ERROR
@@ -56,10 +82,21 @@ typedef int (*List_compare)(void *lhs, void *rhs);
 /// Allocate a new list from the heap.
 List *List_create();
 
+/// Allocate a new list that draws its nodes from a shared pool.
+/**
+ * The list takes its own reference to pool, so the caller may release
+ * theirs at any time.  Shared pools serialize allocation on the pool's
+ * lock; lists that are only ever touched by one thread should prefer the
+ * private pool that List_create provides.
+ */
+List *List_create_pooled(struct ListNodePool *pool);
+
 /// Free a list, as well as any nodes belonging to it.
 /**
  * List_destroy frees list resources, but does not free the values of its
  * nodes. Refer to List_clear and List_clear_destroy for freeing node values.
+ * When the list holds the only reference to its pool, the pool's chunks are
+ * released wholesale rather than node by node.
  */
 void List_destroy(List *list);
 
@@ -85,8 +122,53 @@ void List_clear_destroy(List *list);
 
 
 /// retrieve the value stored at an index
+/**
+ * The node found is cached on the list, and the next lookup seeks from
+ * whichever of it and the two ends is closest, so walking a list by
+ * ascending or descending index costs O(1) per step.  Since the cache is
+ * written on every lookup, threads sharing a list must use List_get_ts.
+ */
 void *List_get(List *list, int index);
 
+/// retrieve the node located at an index, or NULL if it is out of bounds.
+ListNode *List_get_node(List *list, int index);
+
+/// Forget the cached List_get position.
+/**
+ * The list functions keep the cache up to date themselves; only code that
+ * relinks nodes directly needs to call this.
+ */
+#define List_reset_cursor(A) ((A)->cursor = NULL)
+
+
+/// Point a cursor at the first node of a list.
+/**
+ * On an empty list the cursor's node is NULL and its index is 0.
+ */
+void ListCursor_init(ListCursor *cursor, List *list);
+
+/// Move a cursor offset nodes forward, or backward if offset is negative.
+/**
+ * Returns the new node, or NULL, leaving the cursor where it was, if the
+ * target is outside the list.
+ */
+ListNode *ListCursor_seek(ListCursor *cursor, int offset);
+
+/// Move a cursor to an index, stepping from whichever of the cursor and
+/// the two ends of the list is closest.  Returns NULL if out of bounds.
+ListNode *ListCursor_seek_to(ListCursor *cursor, int index);
+
+/// Remove the cursor's node, moving the cursor to the node after it.
+/**
+ * Returns the removed value.  Removing the last node leaves the cursor's
+ * node NULL, with its index equal to the list's count.
+ */
+void *ListCursor_remove(ListCursor *cursor);
+
+#define ListCursor_node(C) ((C)->node)
+#define ListCursor_index(C) ((C)->index)
+#define ListCursor_value(C) ((C)->node != NULL ? (C)->node->value : NULL)
+
 
 /// push a new value onto the end of the list.
 void List_push(List *list, void *value);
@@ -106,9 +188,125 @@ void *List_shift(List *list);
 void *List_remove(List *list, ListNode *node);
 
 
-/// merge sort the list
+/// move every node of src onto the end of dest, leaving src empty.
+/**
+ * Nodes are relinked, never reallocated.  When src's pool is private, its
+ * chunks move into dest's pool along with the nodes, so the cost does not
+ * depend on the length of src.  Lists drawing from two different pools
+ * that are both shared with other lists cannot exchange nodes; their
+ * values are copied into nodes from dest's pool instead.
+ * Returns 0 on success.
+ */
+int List_concat(List *dest, List *src);
+
+/// move the nodes first through last from src into dest, before at.
+/**
+ * at may be NULL to append to dest, and must not lie inside the moved run.
+ * count is the number of nodes from first to last, which keeps the splice
+ * constant time; pass -1 to have it counted.  To relink nodes the two
+ * lists must draw from one pool, so when they don't, the private one of
+ * the two pools is merged into the other and both lists share it from
+ * then on.  If neither is private the values are copied as in List_concat.
+ * Returns 0 on success.
+ */
+int List_splice(List *dest, ListNode *at, List *src, ListNode *first,
+		ListNode *last, int count);
+
+/// split a list in two at an index.
+/**
+ * list keeps the nodes before index, and the returned list holds the rest.
+ * Only the seek to index is linear.  The new list shares list's pool.
+ */
+List *List_split_at(List *list, int index);
+
+
+/// move a list's nodes next to each other, in list order.
+/**
+ * After long runs of pushes, removals and sorts the nodes of a list are
+ * scattered around its pool, and traversal becomes a chain of cache
+ * misses.  List_compact copies the list into a single block of nodes laid
+ * out first to last, so later traversals walk memory sequentially.  A
+ * private pool is replaced outright, returning every old chunk to the
+ * system; in a shared pool the old nodes go back on the free list.
+ *
+ * Nodes are copied, so ListNode pointers into the list are invalidated.
+ * Returns 0 on success, leaving the list untouched on failure.
+ */
+int List_compact(List *list);
+
+
+/// Thread-safe variants.
+/**
+ * The plain functions above never lock, so a list shared between threads
+ * must only be modified through the _ts functions below, which hold
+ * list->lock for the duration of the call.  Code that needs several
+ * operations to appear atomic, or wants to iterate, can hold the lock
+ * itself with List_lock and use the plain functions in between.
+ *
+ * The batch forms move many values under a single acquisition of the
+ * lock, amortizing its cost across the whole batch.
+ */
+#define List_lock(A) pthread_mutex_lock((A)->lock)
+#define List_unlock(A) pthread_mutex_unlock((A)->lock)
+
+/// push a new value onto the end of the list, under the list's lock.
+void List_push_ts(List *list, void *value);
+
+/// remove and return the end of the list, under the list's lock.
+void *List_pop_ts(List *list);
+
+/// push a new value onto the beginning of the list, under the list's lock.
+void List_unshift_ts(List *list, void *value);
+
+/// remove and return the beginning of the list, under the list's lock.
+void *List_shift_ts(List *list);
+
+/// retrieve the value stored at an index, or NULL if it is out of bounds.
+void *List_get_ts(List *list, int index);
+
+/// read the number of values in the list, under the list's lock.
+int List_count_ts(List *list);
+
+/// push count values onto the end of the list in order.
+/**
+ * Returns the number of values pushed, which is only less than count if
+ * a node could not be allocated.
+ */
+int List_push_batch_ts(List *list, void **values, int count);
+
+/// remove up to max values from the beginning of the list into out.
+/**
+ * Returns the number of values removed, which is less than max once the
+ * list runs out.
+ */
+int List_shift_batch_ts(List *list, void **out, int max);
+
+
+/// merge sort the list on the default TaskPool.
 ListSortResult List_merge_sort(List *list, List_compare comparator);
 
+/// merge sort the list on a caller supplied pool.
+/**
+ * Stable.  Lists of at least a few thousand nodes are sorted through an
+ * array of their nodes, where the halves are sorted as separate tasks and
+ * long merges are split between the workers by co-ranking; shorter lists
+ * are sorted by relinking chains.  No nodes are allocated.
+ */
+ListSortResult List_merge_sort_on(List *list, List_compare comparator,
+		struct TaskPool *pool);
+
+/// merge k sorted lists into lists[0], leaving the others empty.
+/**
+ * The heads of the k lists are kept in a loser tree, so each value costs
+ * about log2(k) comparisons, and nodes are relinked rather than copied.
+ * Equal values keep the order of the lists they came from.  Pools are
+ * handled as in List_concat: values from pools that can't be merged with
+ * lists[0]'s are copied into new nodes first, and if that allocation fails
+ * every list is left as it was.  The lists must be distinct.  Returns 0 on
+ * success.
+ */
+int List_merge_k(List **lists, int k, List_compare comparator);
+
 
 /// convenience for loop iterating across a list.
 /**
@@ -122,4 +320,104 @@ ListSortResult List_merge_sort(List *list, List_compare comparator);
 	ListNode *V = NULL;\
 	for(V = _node = L->S; _node != NULL; V = _node = _node->M)
 
+
+/// Generate a stable merge of two sorted chains.
+/**
+ * Expands to `static N *name(N *left, N *right, C ctx)`, which merges the
+ * NULL terminated chains left and right, linked through next, and returns
+ * the head of the result.  Ties are taken from left.  CMP is as for
+ * LIST_GENERATE_CHAIN_SORT.
+ */
+#define LIST_GENERATE_CHAIN_MERGE(name, N, C, CMP) \
+static __attribute__((unused)) N *name(N *left, N *right, C ctx) \
+{ \
+	N head; \
+	N *tail = &head; \
+\
+	while(left != NULL && right != NULL) { \
+		if(CMP(ctx, left, right) <= 0) { \
+			tail->next = left; \
+			left = left->next; \
+		} else { \
+			tail->next = right; \
+			right = right->next; \
+		} \
+		tail = tail->next; \
+	} \
+	tail->next = left != NULL ? left : right; \
+\
+	return head.next; \
+}
+
+/// Generate the bottom-up merge sort behind List_sort and its relatives.
+/**
+ * Expands to `static N *name(N *first, C ctx)`, which stably sorts the
+ * NULL terminated chain of nodes starting at first, linked through next,
+ * and returns its new head.  Each pass merges adjacent runs of doubling
+ * width by relinking next alone, so nothing is allocated; prev pointers,
+ * if N has them, are left for the caller to rebuild.  CMP(ctx, p, q)
+ * compares two nodes like a comparator, and is usually a static inline
+ * function so a typed comparison compiles into the merge loop.
+ */
+#define LIST_GENERATE_CHAIN_SORT(name, N, C, CMP) \
+static __attribute__((unused)) N *name(N *first, C ctx) \
+{ \
+	int insize = 1; \
+\
+	if(first == NULL) { \
+		return NULL; \
+	} \
+\
+	while(1) { \
+		N *p = first; \
+		N *tail = NULL; \
+		int merges = 0; \
+\
+		first = NULL; \
+\
+		while(p != NULL) { \
+			merges++; \
+\
+			/* step q insize nodes past p to find the second run */ \
+			N *q = p; \
+			int psize = 0; \
+			int i; \
+			for(i = 0; i < insize && q != NULL; i++) { \
+				psize++; \
+				q = q->next; \
+			} \
+			int qsize = insize; \
+\
+			/* merge the two runs, taking from p on ties for stability */ \
+			while(psize > 0 || (qsize > 0 && q != NULL)) { \
+				N *e = NULL; \
+				if(psize == 0) { \
+					e = q; q = q->next; qsize--; \
+				} else if(qsize == 0 || q == NULL) { \
+					e = p; p = p->next; psize--; \
+				} else if(CMP(ctx, p, q) <= 0) { \
+					e = p; p = p->next; psize--; \
+				} else { \
+					e = q; q = q->next; qsize--; \
+				} \
+\
+				if(tail != NULL) { \
+					tail->next = e; \
+				} else { \
+					first = e; \
+				} \
+				tail = e; \
+			} \
+\
+			p = q; \
+		} \
+		tail->next = NULL; \
+\
+		if(merges <= 1) { \
+			return first; \
+		} \
+		insize *= 2; \
+	} \
+}
+
 #endif
@@ -1,6 +1,11 @@
 #include <collect/list_algos.h>
 #include <dbg.h>
 
+// List_tim_sort tuning, as in CPython's listsort
+#define TIM_SORT_MIN_MERGE 32
+#define TIM_SORT_MIN_GALLOP 7
+#define TIM_SORT_MAX_RUNS 85
+
 typedef int (*List_compare)(void *lhs, void *rhs);
 
 int List_bubble_sort(List *list, List_compare comparator) 
@@ -28,208 +33,401 @@ int List_bubble_sort(List *list, List_compare comparator)
 }
 
 
-List *List_old_merge_sort(List *list, List_compare comparator) {
-	ListSortContext context;
-	context.in = list;
-	context.out = NULL;
-	context.comparator = comparator;
+static inline int List_sort_compare(List_compare comparator, ListNode *p,
+		ListNode *q)
+{
+	return comparator(p->value, q->value);
+}
 
-	pthread_t sort_pt;
+LIST_GENERATE_SORT(List_sort_nodes, List_compare, List_sort_compare)
 
-	pthread_attr_t attr;
-	pthread_attr_init(&attr);
-	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+int List_sort(List *list, List_compare comparator)
+{
+	return List_sort_nodes(list, comparator);
+}
 
-	int rc;
-	rc = pthread_create(&sort_pt, &attr, List_pt_merge_sort, 
-			(void *)&context);
-	check(rc == 0, "Return code from pthread_create() on merge sort is %d", 
-			rc);
 
-	void *sort_status;
-	rc = pthread_join(sort_pt, &sort_status);
-	check(rc == 0, "Return code from pthread_join() on merge sort is %d", 
-			rc);
-	check((long)sort_status == SUCCESS_STATUS, "Exit status for merge sort "
-			"is %ld", (long)sort_status);
-error:
-	pthread_attr_destroy(&attr);
-	return context.out;
+/// A sorted, NULL terminated stretch of nodes awaiting a merge.
+typedef struct ListRun {
+	ListNode *head;
+	ListNode *tail;
+	int len;
+} ListRun;
+
+typedef struct ListMergeState {
+	List_compare comparator;
+	int min_gallop;
+	int count;
+	ListRun runs[TIM_SORT_MAX_RUNS];
+} ListMergeState;
+
+
+/// minimum run length, chosen so n / minrun is at or just under a power of
+/// two and the final merges stay balanced
+static int tim_sort_minrun(int n)
+{
+	int r = 0;
+	while(n >= TIM_SORT_MIN_MERGE) {
+		r |= n & 1;
+		n >>= 1;
+	}
+	return n + r;
 }
 
 
-void *List_pt_merge_sort(void *args) 
+/// cut the next natural run off the front of *rest
+/**
+ * Ascending runs are taken as they are.  Strictly descending runs are
+ * reversed, which can't reorder equal elements.  Runs shorter than minrun
+ * are extended with a stable insertion sort.  prev pointers are kept valid
+ * inside the run.
+ */
+static ListRun tim_sort_next_run(ListNode **rest, int remaining, int minrun,
+		List_compare comparator)
 {
-	// From Wikipedia:
-	// 1. Divide the unsorted list into n sublists, each containing 1
-	//    element
-	// 2. Repeatedly merge sublists to produce new sorted sublists until
-	//    there is only 1 sublist remaining.  This will be th the sorted 
-	//    list
+	ListRun run;
+	ListNode *cur = *rest;
+
+	run.head = cur;
+	run.tail = cur;
+	run.len = 1;
+	cur->prev = NULL;
+	cur = cur->next;
+
+	if(cur != NULL && comparator(run.head->value, cur->value) > 0) {
+		// strictly descending: push each node onto the front
+		run.tail->next = NULL;
+		while(cur != NULL && comparator(run.head->value, cur->value) > 0) {
+			ListNode *next = cur->next;
+			cur->next = run.head;
+			cur->prev = NULL;
+			run.head->prev = cur;
+			run.head = cur;
+			run.len++;
+			cur = next;
+		}
+	} else if(cur != NULL) {
+		// the first pair is already known to be in order
+		do {
+			cur->prev = run.tail;
+			run.tail = cur;
+			run.len++;
+			cur = cur->next;
+		} while(cur != NULL && 
+				comparator(run.tail->value, cur->value) <= 0);
+	}
 
-	List *out = List_create();
-	List *left = NULL;
-	List *right = NULL;
-	List *sorted_left = NULL;
-	List *sorted_right = NULL;
-	long status = FAIL_STATUS;
-	int  list_locked = 0;
+	// extend short runs up to minrun
+	int target = minrun < remaining ? minrun : remaining;
+	run.tail->next = NULL;
+	while(run.len < target && cur != NULL) {
+		ListNode *next = cur->next;
+		ListNode *after = run.tail;
+		while(after != NULL && comparator(after->value, cur->value) > 0) {
+			after = after->prev;
+		}
+		if(after == NULL) {
+			cur->prev = NULL;
+			cur->next = run.head;
+			run.head->prev = cur;
+			run.head = cur;
+		} else {
+			cur->prev = after;
+			cur->next = after->next;
+			if(after->next != NULL) {
+				after->next->prev = cur;
+			} else {
+				run.tail = cur;
+			}
+			after->next = cur;
+		}
+		run.len++;
+		cur = next;
+	}
 
-	// cast context
-	ListSortContext *context = (ListSortContext *)args;
-	List *list = context->in;
-	List_compare comparator = context->comparator;
-	check(list != NULL, "Input list was NULL");
-	
-	// This is a thread call, so we lock the shared data
-	// we also need to track locally whether the thread is locked
-	pthread_mutex_lock(list->lock);
-	list_locked = 1;
+	*rest = cur;
+	return run;
+}
 
-	// store this variable for later use
-	int list_count = list->count;
 
-	// Check for single-node or empty lists, which are already sorted
-	if(list->count < 2) {
-		if(list->count == 1) {
-			List_push(out, list->first->value);
+/// count the leading nodes of a run that belong before key, probing at
+/// exponentially growing offsets and then bisecting.  Nodes count when
+/// they compare <= key, or < key if strict is set.  *last is set to the
+/// final counted node.
+static int tim_sort_gallop(ListNode *start, int len, void *key, int strict,
+		List_compare comparator, ListNode **last)
+{
+	// the first lo nodes are known to count, index hi is known not to
+	ListNode *lo_node = NULL;
+	ListNode *node = start;
+	int lo = 0;
+	int hi = len;
+	int index = 0;
+	int i = 0;
+
+	// probe indices 0, 1, 3, 7, ...
+	while(index < len) {
+		for(; i < index; i++) {
+			node = node->next;
 		}
-		context->out = out;
-		pthread_mutex_unlock(list->lock);
-		pthread_exit(SUCCESS_STATUS);
-	}
-
-	// Divide list into two new lists
-	left = List_create();
-	right = List_create();
-	ListNode *cur = list->first;
-	int i;
-	for(i = 0; i < list->count / 2; i++) {
-		check(cur != NULL, "Got a null value for a node in the list "
-			"with index less than list->count");
-		List_push(left, cur->value);
-		cur = cur->next;
-	}
-	for(; i < list->count; i++) {
-		check(cur != NULL, "Got a null value for a node in the list "
-				"with index less than list->count");
-		List_push(right, cur->value);
-		cur = cur->next;
+		int c = comparator(node->value, key);
+		if(strict ? c >= 0 : c > 0) {
+			hi = index;
+			break;
+		}
+		lo = index + 1;
+		lo_node = node;
+		index = index * 2 + 1;
 	}
 
-	// unlock the list after reading.  we don't need it
-	pthread_mutex_unlock(list->lock);
-	list_locked = 0;
-
-	// debug("list->count:\t%d", list->count);
-	// debug("left->count:\t%d", left->count);
-	// debug("right->count:\t%d", right->count);
-	check(list_count == left->count + right->count, "left and right list "
-			"split sizes do not add up to input size.");
-
-	// merge sort each
-	pthread_t left_sort_pt;
-	pthread_t right_sort_pt;
-
-	pthread_attr_t attr;
-	pthread_attr_init(&attr);
-	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
-	ListSortContext left_sort_ctx;
-	left_sort_ctx.in = left;
-	left_sort_ctx.out = NULL;
-	left_sort_ctx.comparator = comparator;
-
-	ListSortContext right_sort_ctx;
-	right_sort_ctx.in = right;
-	right_sort_ctx.out = NULL;
-	right_sort_ctx.comparator = comparator;
-
-	int rc;
-	rc = pthread_create(&left_sort_pt, &attr, List_pt_merge_sort, 
-			(void *)&left_sort_ctx);
-	check(rc == 0, "Return code from pthread_create() on left sort is %d", 
-			rc);
-	rc = pthread_create(&right_sort_pt, &attr, List_pt_merge_sort,
-			(void *) &right_sort_ctx);
-	check(rc == 0, "Return code from pthread_create() on right sort is %d", 
-			rc);
-
-	pthread_attr_destroy(&attr);
-
-	void *sort_status;
-	rc = pthread_join(left_sort_pt, &sort_status);
-	check(rc == 0, "Return code from pthread_join() on left sort is %d", 
-			rc);
-	check(sort_status == SUCCESS_STATUS, "Exit status for left sort is %ld", 
-			(long)sort_status);
-
-	rc = pthread_join(right_sort_pt, &sort_status);
-	check(rc == 0, "Return code from pthread_join() on right sort is %d", 
-			rc);
-	check(sort_status == SUCCESS_STATUS, "Exit status for right sort is %ld", 
-			(long)sort_status);
-
-
-	sorted_left = left_sort_ctx.out;
-	sorted_right = right_sort_ctx.out;
-	// debug("sorted_left->count:\t%d", sorted_left->count);
-	// debug("sorted_right->count:\t%d", sorted_right->count);
-	check(left->count == sorted_left->count, "Internal sorted list had a "
-			"different count than its input");
-	check(right->count == sorted_right->count, "Internal sorted list had a "
-			"different count than its input");
-
-	// merge sorted lists
-	void *lval = NULL;
-	void *rval = NULL;
-	int lcount = sorted_left->count;
-	int rcount = sorted_right->count;
-	while(sorted_left->count > 0 || sorted_right->count > 0 
-			|| lval != NULL || rval != NULL) {
-		// load left and right values from START
-		if(lval == NULL && sorted_left->count > 0) {
-			lval = List_shift(sorted_left);
+	// bisect [lo, hi), always walking forward from the last counted node
+	while(lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		ListNode *probe = lo_node != NULL ? lo_node->next : start;
+		for(i = lo; i < mid; i++) {
+			probe = probe->next;
 		}
-		if(rval == NULL && sorted_right->count > 0) {
-			rval = List_shift(sorted_right);
+		int c = comparator(probe->value, key);
+		if(strict ? c >= 0 : c > 0) {
+			hi = mid;
+		} else {
+			lo = mid + 1;
+			lo_node = probe;
 		}
-		// append lesser of the values to out
-		if(lval == NULL) {
-			List_push(out, rval);
-			rval = NULL;
-			continue;
+	}
+
+	*last = lo_node;
+	return lo;
+}
+
+
+/// stable merge of two adjacent runs, galloping through long streaks
+static ListRun tim_sort_merge(ListMergeState *state, ListRun a, ListRun b)
+{
+	List_compare comparator = state->comparator;
+	ListNode head;
+	ListNode *tail = &head;
+	ListRun out;
+	ListNode *pa = a.head;
+	ListNode *pb = b.head;
+	int alen = a.len;
+	int blen = b.len;
+
+	out.len = a.len + b.len;
+
+	// already in order: the runs just join up
+	if(comparator(a.tail->value, b.head->value) <= 0) {
+		a.tail->next = b.head;
+		out.head = a.head;
+		out.tail = b.tail;
+		return out;
+	}
+
+	while(alen > 0 && blen > 0) {
+		int acount = 0;
+		int bcount = 0;
+
+		// one pair at a time until one side keeps winning
+		while(alen > 0 && blen > 0 && acount < state->min_gallop &&
+				bcount < state->min_gallop) {
+			if(comparator(pb->value, pa->value) < 0) {
+				tail->next = pb;
+				tail = pb;
+				pb = pb->next;
+				blen--;
+				bcount++;
+				acount = 0;
+			} else {
+				tail->next = pa;
+				tail = pa;
+				pa = pa->next;
+				alen--;
+				acount++;
+				bcount = 0;
+			}
 		}
-		if(rval == NULL) {
-			List_push(out, lval);
-			lval = NULL;
-			continue;
+
+		// gallop: splice whole streaks found by exponential search
+		while(alen > 0 && blen > 0) {
+			ListNode *last = NULL;
+			acount = tim_sort_gallop(pa, alen, pb->value, 0,
+					comparator, &last);
+			if(acount > 0) {
+				tail->next = pa;
+				tail = last;
+				pa = last->next;
+				alen -= acount;
+				if(alen == 0) { break; }
+			}
+			tail->next = pb;
+			tail = pb;
+			pb = pb->next;
+			if(--blen == 0) { break; }
+
+			bcount = tim_sort_gallop(pb, blen, pa->value, 1,
+					comparator, &last);
+			if(bcount > 0) {
+				tail->next = pb;
+				tail = last;
+				pb = last->next;
+				blen -= bcount;
+				if(blen == 0) { break; }
+			}
+			tail->next = pa;
+			tail = pa;
+			pa = pa->next;
+			if(--alen == 0) { break; }
+
+			if(state->min_gallop > 1) {
+				state->min_gallop--;
+			}
+			if(acount < TIM_SORT_MIN_GALLOP &&
+					bcount < TIM_SORT_MIN_GALLOP) {
+				// streaks dried up, make galloping harder to enter
+				state->min_gallop += 2;
+				break;
+			}
 		}
-		// if comparator < 0 then lval < rval
-		if(comparator(lval, rval) < 0) {
-			List_push(out, lval);
-			lval = NULL;
-		} else {
-			List_push(out, rval);
-			rval = NULL;
+	}
+
+	if(alen > 0) {
+		tail->next = pa;
+		out.tail = a.tail;
+	} else {
+		tail->next = pb;
+		out.tail = blen > 0 ? b.tail : tail;
+	}
+	out.head = head.next;
+	return out;
+}
+
+
+/// merge runs i and i + 1 on the stack
+static void tim_sort_merge_at(ListMergeState *state, int i)
+{
+	state->runs[i] = tim_sort_merge(state, state->runs[i], 
+			state->runs[i + 1]);
+	if(i + 2 < state->count) {
+		state->runs[i + 1] = state->runs[i + 2];
+	}
+	state->count--;
+}
+
+
+/// restore the stack invariants: each run is longer than the two above it
+/// combined, and longer than the one directly above it
+static void tim_sort_merge_collapse(ListMergeState *state)
+{
+	ListRun *r = state->runs;
+	while(state->count > 1) {
+		int n = state->count - 2;
+		if((n > 0 && r[n - 1].len <= r[n].len + r[n + 1].len) ||
+				(n > 1 && r[n - 2].len <= r[n - 1].len + r[n].len)) {
+			if(r[n - 1].len < r[n + 1].len) {
+				n--;
+			}
+		} else if(r[n].len > r[n + 1].len) {
+			break;
 		}
+		tim_sort_merge_at(state, n);
 	}
+}
+
 
-	// debug("out->count:\t%d", out->count);
+int List_tim_sort(List *list, List_compare comparator)
+{
+	ListMergeState state;
+	ListNode *rest = list->first;
+	int remaining = list->count;
+	int minrun = tim_sort_minrun(list->count);
+
+	if(list->count < 2) {
+		return 0;
+	}
+	List_reset_cursor(list);
+
+	state.comparator = comparator;
+	state.min_gallop = TIM_SORT_MIN_GALLOP;
+	state.count = 0;
+
+	while(rest != NULL) {
+		check(state.count < TIM_SORT_MAX_RUNS, "Run stack overflow.");
+		ListRun run = tim_sort_next_run(&rest, remaining, minrun, 
+				comparator);
+		remaining -= run.len;
+		state.runs[state.count++] = run;
+		tim_sort_merge_collapse(&state);
+	}
+
+	while(state.count > 1) {
+		int n = state.count - 2;
+		if(n > 0 && state.runs[n - 1].len < state.runs[n + 1].len) {
+			n--;
+		}
+		tim_sort_merge_at(&state, n);
+	}
+
+	// merges only maintain next, so rebuild prev along the final run
+	ListNode *prev = NULL;
+	ListNode *cur = state.runs[0].head;
+	list->first = cur;
+	while(cur != NULL) {
+		cur->prev = prev;
+		prev = cur;
+		cur = cur->next;
+	}
+	list->last = prev;
+
+	return 0;
+error:
+	return -1;
+}
+
+
+List *List_old_merge_sort(List *list, List_compare comparator) {
+	ListSortContext context;
+	context.in = list;
+	context.out = NULL;
+	context.comparator = comparator;
+
+	void *sort_status = List_pt_merge_sort((void *)&context);
+	check((long)sort_status == SUCCESS_STATUS, "Exit status for merge sort "
+			"is %ld", (long)sort_status);
+error:
+	return context.out;
+}
+
+
+/// sort a copy of context->in into context->out
+/**
+ * The values are copied into a new list under the input's lock, and that
+ * list is sorted by List_merge_sort, so even the top level merge is split
+ * across the default TaskPool.
+ */
+void *List_pt_merge_sort(void *args)
+{
+	ListSortContext *context = (ListSortContext *)args;
+	List *list = context->in;
+	List *out = List_create();
+	long status = FAIL_STATUS;
+
+	check(list != NULL, "Input list was NULL");
+	check_mem(out);
+
+	pthread_mutex_lock(list->lock);
+	LIST_FOREACH(list, first, next, cur) {
+		List_push(out, cur->value);
+	}
+	int list_count = list->count;
+	pthread_mutex_unlock(list->lock);
 
-	check(out->count == lcount + rcount, "merged list count was not equal "
-			"to size of right + left.");
-	check(out->count == list->count, "merged list count was not equal to "
-			"size of input.");
+	check(out->count == list_count, "Failed to copy the input list.");
+	check(List_merge_sort(out, context->comparator) == SUCCESS,
+			"Merge sort failed.");
 
 	status = SUCCESS_STATUS;
 
 error:
-	if(left != NULL) { List_destroy(left); }
-	if(right != NULL) { List_destroy(right); }
-	if(sorted_left != NULL) { List_destroy(sorted_left); }
-	if(sorted_right != NULL) { List_destroy(sorted_right); }
-	if(list_locked) { pthread_mutex_unlock(list->lock); }
 	context->out = out;
-	pthread_exit((void *)status);
+	return (void *)status;
 }
@@ -15,7 +15,80 @@ typedef struct ListSortContext {
 } ListSortContext;
 
 int List_bubble_sort(List *list, List_compare comparator);
+
+/// Stable, in-place bottom-up merge sort.
+/**
+ * Nodes are relinked rather than copied, so List_sort never allocates and
+ * uses O(1) extra memory.  Returns 0 on success.
+ */
+int List_sort(List *list, List_compare comparator);
+
+/// Stable, adaptive natural merge sort in the style of Timsort.
+/**
+ * Existing ascending and strictly descending runs are detected and kept,
+ * short runs are padded with an insertion sort, and runs are merged with
+ * galloping, so presorted or nearly sorted input costs close to O(n)
+ * comparisons.  Equal elements always keep their original order.  Nodes are
+ * relinked in place without allocating.  Returns 0 on success.
+ */
+int List_tim_sort(List *list, List_compare comparator);
+
 List *List_old_merge_sort(List *list, List_compare comparator);
 void *List_pt_merge_sort(void *args);
 
+
+/// Generate `static int name(List *list, C ctx)`, sorting a List with
+/// LIST_GENERATE_CHAIN_SORT from list.h and then restoring its prev
+/// pointers and ends.
+#define LIST_GENERATE_SORT(name, C, CMP) \
+LIST_GENERATE_CHAIN_SORT(name##_chain, ListNode, C, CMP) \
+\
+static __attribute__((unused)) int name(List *list, C ctx) \
+{ \
+	ListNode *prev = NULL; \
+	ListNode *cur = name##_chain(list->first, ctx); \
+\
+	list->first = cur; \
+	for(; cur != NULL; cur = cur->next) { \
+		cur->prev = prev; \
+		prev = cur; \
+	} \
+	list->last = prev; \
+	List_reset_cursor(list); \
+	return 0; \
+}
+
+/// Define a List_sort specialized for one value type and comparison.
+/**
+ * Expands to `static int name(List *list)`, the same stable bottom-up
+ * merge sort as List_sort, with cmp_expr compiled straight into the merge
+ * loop instead of called through a List_compare pointer.  Inside cmp_expr,
+ * a and b are two values of the list cast to type, and the expression
+ * returns less than, equal to or greater than 0 just like a comparator.
+ *
+ *     LIST_DEFINE_SORT(sort_by_int, int *, (*a > *b) - (*a < *b))
+ *     LIST_DEFINE_SORT(sort_by_string, char *, strcmp(a, b))
+ *
+ * Use it at file scope.  It also defines helpers prefixed with name##_.
+ */
+#define LIST_DEFINE_SORT(name, type, cmp_expr) \
+static inline int name##_compare(type a, type b) \
+{ \
+	return (cmp_expr); \
+} \
+\
+static inline int name##_compare_nodes(void *unused, ListNode *p, \
+		ListNode *q) \
+{ \
+	(void)unused; \
+	return name##_compare((type)p->value, (type)q->value); \
+} \
+\
+LIST_GENERATE_SORT(name##_list, void *, name##_compare_nodes) \
+\
+static __attribute__((unused)) int name(List *list) \
+{ \
+	return name##_list(list, NULL); \
+}
+
 #endif
@@ -0,0 +1,246 @@
+/*
+ * Node pool allocator for Linked Lists.
+ * Copyright (C) 2014 Axel Magnuson <axelmagn@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <collect/list_pool.h>
+#include <dbg.h>
+
+
+/// Allocate a new pool from the heap, holding one reference.
+ListNodePool *ListNodePool_create(int chunk_size)
+{
+	ListNodePool *out = calloc(1, sizeof(ListNodePool));
+	check(out != NULL, "Failed to allocate ListNodePool");
+	out->lock = calloc(1, sizeof(pthread_mutex_t));
+	check(out->lock != NULL, "Failed to allocate mutex ListNodePool->lock");
+	int err = pthread_mutex_init(out->lock, NULL);
+	check(err == 0, "Failed to initialize mutex ListNodePool->lock");
+	out->refs = 1;
+	out->chunk_size = chunk_size < LIST_POOL_MIN_CHUNK ?
+		LIST_POOL_MIN_CHUNK : chunk_size;
+	return out;
+error:
+	if(out && out->lock) { free(out->lock); }
+	if(out) { free(out); }
+	return NULL;
+}
+
+
+/// Take an additional reference to a pool.
+void ListNodePool_retain(ListNodePool *pool)
+{
+	__atomic_add_fetch(&pool->refs, 1, __ATOMIC_ACQ_REL);
+}
+
+
+/// Drop a reference to a pool, freeing all of its chunks with the last one.
+void ListNodePool_release(ListNodePool *pool)
+{
+	if(__atomic_sub_fetch(&pool->refs, 1, __ATOMIC_ACQ_REL) > 0) {
+		return;
+	}
+
+	ListNodeChunk *chunk = pool->chunks;
+	while(chunk != NULL) {
+		ListNodeChunk *next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
+	pthread_mutex_destroy(pool->lock);
+	free(pool->lock);
+	free(pool);
+}
+
+
+/// Carve a node out of the pool.  Caller holds the lock if one is needed.
+static ListNode *ListNodePool_take(ListNodePool *pool)
+{
+	ListNode *node = NULL;
+
+	// recycled nodes first, they are the most likely to be in cache
+	if(pool->free_nodes != NULL) {
+		node = pool->free_nodes;
+		pool->free_nodes = node->next;
+		return node;
+	}
+
+	ListNodeChunk *chunk = pool->chunks;
+	if(chunk == NULL || chunk->used == chunk->capacity) {
+		chunk = malloc(sizeof(ListNodeChunk) +
+				pool->chunk_size * sizeof(ListNode));
+		check_mem(chunk);
+		chunk->capacity = pool->chunk_size;
+		chunk->used = 0;
+		chunk->next = pool->chunks;
+		if(pool->chunks == NULL) {
+			pool->chunks_tail = chunk;
+		}
+		pool->chunks = chunk;
+		if(pool->chunk_size < LIST_POOL_MAX_CHUNK) {
+			pool->chunk_size *= 2;
+		}
+	}
+	node = &chunk->nodes[chunk->used++];
+
+error:
+	return node;
+}
+
+
+/// Hand out a zeroed node, growing the pool if necessary.
+ListNode *ListNodePool_alloc(ListNodePool *pool)
+{
+	ListNode *node = NULL;
+	if(ListNodePool_is_private(pool)) {
+		node = ListNodePool_take(pool);
+	} else {
+		pthread_mutex_lock(pool->lock);
+		node = ListNodePool_take(pool);
+		pthread_mutex_unlock(pool->lock);
+	}
+
+	if(node != NULL) {
+		node->next = NULL;
+		node->prev = NULL;
+		node->value = NULL;
+	}
+	return node;
+}
+
+
+/// Hand out count nodes that are adjacent in memory.
+ListNode *ListNodePool_alloc_run(ListNodePool *pool, int count)
+{
+	ListNodeChunk *chunk = malloc(sizeof(ListNodeChunk) +
+			count * sizeof(ListNode));
+	check_mem(chunk);
+	chunk->capacity = count;
+	chunk->used = count;
+
+	int shared = !ListNodePool_is_private(pool);
+	if(shared) {
+		pthread_mutex_lock(pool->lock);
+	}
+	// the head chunk is the one being carved, so the run goes behind it
+	if(pool->chunks == NULL) {
+		chunk->next = NULL;
+		pool->chunks = chunk;
+		pool->chunks_tail = chunk;
+	} else {
+		chunk->next = pool->chunks->next;
+		pool->chunks->next = chunk;
+		if(pool->chunks_tail == pool->chunks) {
+			pool->chunks_tail = chunk;
+		}
+	}
+	if(shared) {
+		pthread_mutex_unlock(pool->lock);
+	}
+
+	return chunk->nodes;
+error:
+	return NULL;
+}
+
+
+/// Put a chain of nodes on the free list.  Caller holds the lock if needed.
+static inline void ListNodePool_push_free(ListNodePool *pool,
+		ListNode *first, ListNode *last)
+{
+	if(pool->free_nodes == NULL) {
+		pool->free_tail = last;
+	}
+	last->next = pool->free_nodes;
+	pool->free_nodes = first;
+}
+
+
+/// Return a node to the pool's free list.
+void ListNodePool_free(ListNodePool *pool, ListNode *node)
+{
+	if(ListNodePool_is_private(pool)) {
+		ListNodePool_push_free(pool, node, node);
+	} else {
+		pthread_mutex_lock(pool->lock);
+		ListNodePool_push_free(pool, node, node);
+		pthread_mutex_unlock(pool->lock);
+	}
+}
+
+
+/// Return a run of nodes to the pool's free list.
+void ListNodePool_free_chain(ListNodePool *pool, ListNode *first,
+		ListNode *last)
+{
+	if(ListNodePool_is_private(pool)) {
+		ListNodePool_push_free(pool, first, last);
+	} else {
+		pthread_mutex_lock(pool->lock);
+		ListNodePool_push_free(pool, first, last);
+		pthread_mutex_unlock(pool->lock);
+	}
+}
+
+
+/// Move every chunk and recycled node of donor into pool.
+void ListNodePool_adopt(ListNodePool *pool, ListNodePool *donor)
+{
+	ListNodeChunk *chunks = donor->chunks;
+	ListNodeChunk *chunks_tail = donor->chunks_tail;
+	ListNode *free_nodes = donor->free_nodes;
+	ListNode *free_tail = donor->free_tail;
+	donor->chunks = NULL;
+	donor->chunks_tail = NULL;
+	donor->free_nodes = NULL;
+	donor->free_tail = NULL;
+
+	if(chunks == NULL && free_nodes == NULL) {
+		return;
+	}
+
+	int shared = !ListNodePool_is_private(pool);
+	if(shared) {
+		pthread_mutex_lock(pool->lock);
+	}
+
+	// the head chunk is the one being carved, so the donor's go behind it
+	if(chunks != NULL) {
+		if(pool->chunks == NULL) {
+			pool->chunks = chunks;
+			pool->chunks_tail = chunks_tail;
+		} else {
+			chunks_tail->next = pool->chunks->next;
+			pool->chunks->next = chunks;
+			if(pool->chunks_tail == pool->chunks) {
+				pool->chunks_tail = chunks_tail;
+			}
+		}
+	}
+
+	if(free_nodes != NULL) {
+		ListNodePool_push_free(pool, free_nodes, free_tail);
+	}
+
+	if(shared) {
+		pthread_mutex_unlock(pool->lock);
+	}
+}
@@ -0,0 +1,106 @@
+/*
+ * Node pool allocator for Linked Lists.
+ * Copyright (C) 2014 Axel Magnuson <axelmagn@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef collect_List_pool_h
+#define collect_List_pool_h
+
+#include <collect/list.h>
+
+#define LIST_POOL_MIN_CHUNK 16
+#define LIST_POOL_MAX_CHUNK 4096
+
+
+/// A contiguous block of nodes handed out by a ListNodePool.
+typedef struct ListNodeChunk {
+	struct ListNodeChunk *next;
+	int capacity;
+	int used;
+	ListNode nodes[];
+} ListNodeChunk;
+
+/// A chunked allocator for ListNodes.
+/**
+ * Nodes are carved out of chunks that double in size up to
+ * LIST_POOL_MAX_CHUNK, and released nodes are recycled through a free list,
+ * so steady-state pushes and pops never reach malloc.  Chunks are only
+ * returned to the system when the last reference to the pool is released.
+ *
+ * A pool referenced by a single list is used without locking.  Once a pool
+ * is shared (refs > 1) every allocation and release takes pool->lock.
+ *
+ * chunks_tail and free_tail point at the last chunk and the last recycled
+ * node, so one pool can take over another's in constant time.  Each is
+ * only meaningful while its list is non-empty.
+ */
+typedef struct ListNodePool {
+	pthread_mutex_t *lock;
+	int refs;
+	int chunk_size;
+	ListNodeChunk *chunks;
+	ListNodeChunk *chunks_tail;
+	ListNode *free_nodes;
+	ListNode *free_tail;
+} ListNodePool;
+
+
+/// Allocate a new pool from the heap, holding one reference.
+/**
+ * @param chunk_size number of nodes in the first chunk.  Values below
+ * LIST_POOL_MIN_CHUNK are rounded up.
+ */
+ListNodePool *ListNodePool_create(int chunk_size);
+
+/// Take an additional reference to a pool.
+void ListNodePool_retain(ListNodePool *pool);
+
+/// Drop a reference to a pool, freeing all of its chunks with the last one.
+void ListNodePool_release(ListNodePool *pool);
+
+/// Returns true if the caller holds the only reference to the pool.
+#define ListNodePool_is_private(P) (__atomic_load_n(&(P)->refs, \
+			__ATOMIC_ACQUIRE) == 1)
+
+
+/// Hand out a zeroed node, growing the pool if necessary.
+ListNode *ListNodePool_alloc(ListNodePool *pool);
+
+/// Hand out count nodes that are adjacent in memory, in a chunk of their
+/// own.  The nodes are not zeroed.
+ListNode *ListNodePool_alloc_run(ListNodePool *pool, int count);
+
+/// Return a node to the pool's free list.
+void ListNodePool_free(ListNodePool *pool, ListNode *node);
+
+/// Return a run of nodes, linked first to last through next, in one step.
+void ListNodePool_free_chain(ListNodePool *pool, ListNode *first,
+		ListNode *last);
+
+/// Move all of donor's chunks and recycled nodes into pool.
+/**
+ * Afterwards every node ever handed out by donor belongs to pool, and
+ * donor is empty but still usable.  donor must be private, so that nothing
+ * else is allocating from it.  Runs in constant time.
+ */
+void ListNodePool_adopt(ListNodePool *pool, ListNodePool *donor);
+
+#endif
@@ -0,0 +1,309 @@
+/*
+ * Bounded lock-free multi-producer, multi-consumer queue.
+ * Copyright (C) 2014 Axel Magnuson <axelmagn@gmail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <collect/mpmc_queue.h>
+#include <dbg.h>
+#include <stdint.h>
+#include <string.h>
+
+// rounds of retrying the ring before a blocking call goes to sleep
+#define MPMC_QUEUE_SPINS 64
+
+#if defined(__x86_64__) || defined(__i386__)
+#define cpu_relax() __builtin_ia32_pause()
+#else
+#define cpu_relax() do {} while(0)
+#endif
+
+
+MPMCQueue *MPMCQueue_create(size_t capacity)
+{
+	MPMCQueue *queue = NULL;
+	size_t size = 2;
+	size_t i;
+
+	while(size < capacity) {
+		size *= 2;
+	}
+
+	check(posix_memalign((void **)&queue, MPMC_QUEUE_CACHE_LINE,
+				sizeof(MPMCQueue)) == 0, "Failed to allocate MPMCQueue.");
+	memset(queue, 0, sizeof(MPMCQueue));
+
+	queue->cells = calloc(size, sizeof(MPMCCell));
+	check_mem(queue->cells);
+	queue->mask = size - 1;
+	for(i = 0; i < size; i++) {
+		queue->cells[i].seq = i;
+	}
+
+	queue->lock = calloc(1, sizeof(pthread_mutex_t));
+	check_mem(queue->lock);
+	check(pthread_mutex_init(queue->lock, NULL) == 0,
+			"Failed to initialize mutex MPMCQueue->lock");
+	queue->not_empty = calloc(1, sizeof(pthread_cond_t));
+	check_mem(queue->not_empty);
+	check(pthread_cond_init(queue->not_empty, NULL) == 0,
+			"Failed to initialize MPMCQueue->not_empty");
+	queue->not_full = calloc(1, sizeof(pthread_cond_t));
+	check_mem(queue->not_full);
+	check(pthread_cond_init(queue->not_full, NULL) == 0,
+			"Failed to initialize MPMCQueue->not_full");
+
+	return queue;
+error:
+	// a partly built queue has NULL for anything not yet allocated
+	if(queue) {
+		if(queue->not_full) { free(queue->not_full); }
+		if(queue->not_empty) { free(queue->not_empty); }
+		if(queue->lock) { free(queue->lock); }
+		free(queue->cells);
+		free(queue);
+	}
+	return NULL;
+}
+
+void MPMCQueue_destroy(MPMCQueue *queue)
+{
+	if(queue == NULL) {
+		return;
+	}
+	pthread_cond_destroy(queue->not_full);
+	free(queue->not_full);
+	pthread_cond_destroy(queue->not_empty);
+	free(queue->not_empty);
+	pthread_mutex_destroy(queue->lock);
+	free(queue->lock);
+	free(queue->cells);
+	free(queue);
+}
+
+
+/// Claim up to want consecutive ring positions from *pos_ptr.
+/**
+ * A cell is ready for the claimer of position p when its seq is p + ready,
+ * where ready is 0 for producers and 1 for consumers.  Every ready cell
+ * from the current position onwards is claimed with one compare-and-swap.
+ * Returns the number claimed, storing the first position in *start, or 0
+ * if the queue is full (for producers) or empty (for consumers).
+ */
+static size_t MPMCQueue_claim(MPMCQueue *queue, size_t *pos_ptr,
+		size_t ready, size_t want, size_t *start)
+{
+	size_t pos = __atomic_load_n(pos_ptr, __ATOMIC_RELAXED);
+
+	while(1) {
+		size_t n = 0;
+		while(n < want) {
+			MPMCCell *cell = &queue->cells[(pos + n) & queue->mask];
+			size_t seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+			if(seq != pos + n + ready) {
+				break;
+			}
+			n++;
+		}
+
+		if(n == 0) {
+			MPMCCell *cell = &queue->cells[pos & queue->mask];
+			size_t seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+			intptr_t diff = (intptr_t)(seq - (pos + ready));
+			if(diff < 0) {
+				// the cell is a lap behind: nothing to claim
+				return 0;
+			}
+			// another thread claimed pos first, catch up
+			pos = __atomic_load_n(pos_ptr, __ATOMIC_RELAXED);
+			continue;
+		}
+
+		// nobody else can change a ready cell until pos moves past it
+		if(__atomic_compare_exchange_n(pos_ptr, &pos, pos + n, 1,
+					__ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+			*start = pos;
+			return n;
+		}
+	}
+}
+
+/// wake sleepers on cond after we published work they are waiting for.
+/// locked is true when the caller already holds queue->lock.
+static inline void MPMCQueue_wake(MPMCQueue *queue, int *waiting,
+		pthread_cond_t *cond, int all, int locked)
+{
+	// pairs with the fence in the sleeper: either it sees our cells, or
+	// we see it waiting
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if(__atomic_load_n(waiting, __ATOMIC_RELAXED) > 0) {
+		if(!locked) { pthread_mutex_lock(queue->lock); }
+		if(all) {
+			pthread_cond_broadcast(cond);
+		} else {
+			pthread_cond_signal(cond);
+		}
+		if(!locked) { pthread_mutex_unlock(queue->lock); }
+	}
+}
+
+static int MPMCQueue_put(MPMCQueue *queue, void **values, size_t count,
+		int locked)
+{
+	size_t start = 0;
+	size_t n = MPMCQueue_claim(queue, &queue->enqueue_pos, 0, count, &start);
+	size_t i;
+
+	for(i = 0; i < n; i++) {
+		MPMCCell *cell = &queue->cells[(start + i) & queue->mask];
+		cell->value = values[i];
+		__atomic_store_n(&cell->seq, start + i + 1, __ATOMIC_RELEASE);
+	}
+	if(n > 0) {
+		MPMCQueue_wake(queue, &queue->waiting_consumers, queue->not_empty,
+				n > 1, locked);
+	}
+	return (int)n;
+}
+
+static int MPMCQueue_take(MPMCQueue *queue, void **out, size_t max,
+		int locked)
+{
+	size_t start = 0;
+	size_t n = MPMCQueue_claim(queue, &queue->dequeue_pos, 1, max, &start);
+	size_t i;
+
+	for(i = 0; i < n; i++) {
+		MPMCCell *cell = &queue->cells[(start + i) & queue->mask];
+		out[i] = cell->value;
+		// free the cell for the producer one lap ahead
+		__atomic_store_n(&cell->seq, start + i + queue->mask + 1,
+				__ATOMIC_RELEASE);
+	}
+	if(n > 0) {
+		MPMCQueue_wake(queue, &queue->waiting_producers, queue->not_full,
+				n > 1, locked);
+	}
+	return (int)n;
+}
+
+
+int MPMCQueue_try_enqueue(MPMCQueue *queue, void *value)
+{
+	return MPMCQueue_put(queue, &value, 1, 0) == 1 ? 0 : -1;
+}
+
+int MPMCQueue_try_dequeue(MPMCQueue *queue, void **out)
+{
+	return MPMCQueue_take(queue, out, 1, 0) == 1 ? 0 : -1;
+}
+
+int MPMCQueue_try_enqueue_batch(MPMCQueue *queue, void **values, int count)
+{
+	return count > 0 ? MPMCQueue_put(queue, values, count, 0) : 0;
+}
+
+int MPMCQueue_try_dequeue_batch(MPMCQueue *queue, void **out, int max)
+{
+	return max > 0 ? MPMCQueue_take(queue, out, max, 0) : 0;
+}
+
+
+void MPMCQueue_enqueue_batch(MPMCQueue *queue, void **values, int count)
+{
+	int spins = 0;
+
+	while(count > 0) {
+		int n = MPMCQueue_try_enqueue_batch(queue, values, count);
+		values += n;
+		count -= n;
+		if(count == 0) {
+			break;
+		}
+		if(n > 0 || ++spins < MPMC_QUEUE_SPINS) {
+			cpu_relax();
+			continue;
+		}
+
+		// still full: sleep until a consumer frees a cell
+		pthread_mutex_lock(queue->lock);
+		__atomic_add_fetch(&queue->waiting_producers, 1, __ATOMIC_SEQ_CST);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		while((n = MPMCQueue_put(queue, values, count, 1)) == 0) {
+			pthread_cond_wait(queue->not_full, queue->lock);
+		}
+		__atomic_sub_fetch(&queue->waiting_producers, 1, __ATOMIC_SEQ_CST);
+		pthread_mutex_unlock(queue->lock);
+		values += n;
+		count -= n;
+		spins = 0;
+	}
+}
+
+int MPMCQueue_dequeue_batch(MPMCQueue *queue, void **out, int max)
+{
+	int spins = 0;
+	int n = 0;
+
+	if(max <= 0) {
+		return 0;
+	}
+
+	while((n = MPMCQueue_try_dequeue_batch(queue, out, max)) == 0) {
+		if(++spins < MPMC_QUEUE_SPINS) {
+			cpu_relax();
+			continue;
+		}
+
+		// still empty: sleep until a producer publishes a cell
+		pthread_mutex_lock(queue->lock);
+		__atomic_add_fetch(&queue->waiting_consumers, 1, __ATOMIC_SEQ_CST);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		while((n = MPMCQueue_take(queue, out, max, 1)) == 0) {
+			pthread_cond_wait(queue->not_empty, queue->lock);
+		}
+		__atomic_sub_fetch(&queue->waiting_consumers, 1, __ATOMIC_SEQ_CST);
+		pthread_mutex_unlock(queue->lock);
+		break;
+	}
+
+	return n;
+}
+
+void MPMCQueue_enqueue(MPMCQueue *queue, void *value)
+{
+	MPMCQueue_enqueue_batch(queue, &value, 1);
+}
+
+void *MPMCQueue_dequeue(MPMCQueue *queue)
+{
+	void *value = NULL;
+	MPMCQueue_dequeue_batch(queue, &value, 1);
+	return value;
+}
+
+
+size_t MPMCQueue_count(MPMCQueue *queue)
+{
+	size_t tail = __atomic_load_n(&queue->dequeue_pos, __ATOMIC_ACQUIRE);
+	size_t head = __atomic_load_n(&queue->enqueue_pos, __ATOMIC_ACQUIRE);
+	// dequeue_pos is read first, so it can only lag behind
+	return head >= tail ? head - tail : 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * Bounded lock-free multi-producer, multi-consumer queue.
+ * Copyright (C) 2014 Axel Magnuson <axelmagn@gmail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef collect_MPMC_queue_h
+#define collect_MPMC_queue_h
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#define MPMC_QUEUE_CACHE_LINE 64
+
+/// One slot of an MPMCQueue ring.
+/**
+ * seq tells producers and consumers whose turn the cell is: it equals the
+ * ring position when the cell is free for the producer of that position,
+ * and position + 1 once the value is ready for its consumer.
+ */
+typedef struct MPMCCell {
+	size_t seq;
+	void *value;
+} MPMCCell;
+
+/// A bounded multi-producer, multi-consumer queue.
+/**
+ * The lock-free ring of Dmitry Vyukov: a producer claims a position by
+ * advancing enqueue_pos with one compare-and-swap, fills the cell, and
+ * publishes it through the cell's sequence number.  Consumers do the same
+ * with dequeue_pos.  Producers and consumers only meet on the cells they
+ * hand over, and the two positions live on separate cache lines.
+ *
+ * The try_ functions never block.  The blocking functions spin through the
+ * ring first and only sleep on a condition variable when the queue stays
+ * full or empty, so the mutex is never touched while the queue is flowing.
+ */
+typedef struct MPMCQueue {
+	MPMCCell *cells;
+	size_t mask;
+	pthread_mutex_t *lock;
+	pthread_cond_t *not_empty;
+	pthread_cond_t *not_full;
+	int waiting_producers;
+	int waiting_consumers;
+
+	size_t enqueue_pos __attribute__((aligned(MPMC_QUEUE_CACHE_LINE)));
+	size_t dequeue_pos __attribute__((aligned(MPMC_QUEUE_CACHE_LINE)));
+} __attribute__((aligned(MPMC_QUEUE_CACHE_LINE))) MPMCQueue;
+
+
+/// Allocate a queue holding up to capacity values.
+/**
+ * @param capacity rounded up to a power of two, and at least 2.
+ */
+MPMCQueue *MPMCQueue_create(size_t capacity);
+
+/// Free a queue.  Values still queued are not freed.
+void MPMCQueue_destroy(MPMCQueue *queue);
+
+/// Add value to the tail.  Returns 0, or -1 if the queue is full.
+int MPMCQueue_try_enqueue(MPMCQueue *queue, void *value);
+
+/// Take the value at the head into *out.  Returns 0, or -1 if the queue is
+/// empty.
+int MPMCQueue_try_dequeue(MPMCQueue *queue, void **out);
+
+/// Add value to the tail, waiting for space if the queue is full.
+void MPMCQueue_enqueue(MPMCQueue *queue, void *value);
+
+/// Take the value at the head, waiting for one if the queue is empty.
+void *MPMCQueue_dequeue(MPMCQueue *queue);
+
+/// Add as many of the count values as fit without waiting.
+/**
+ * The values are claimed with a single compare-and-swap and stay
+ * contiguous in the queue.  Returns the number enqueued, from the start of
+ * values.
+ */
+int MPMCQueue_try_enqueue_batch(MPMCQueue *queue, void **values, int count);
+
+/// Take up to max values into out without waiting.  Returns the number
+/// taken.
+int MPMCQueue_try_dequeue_batch(MPMCQueue *queue, void **out, int max);
+
+/// Add all count values, waiting for space whenever the queue is full.
+void MPMCQueue_enqueue_batch(MPMCQueue *queue, void **values, int count);
+
+/// Take between 1 and max values into out, waiting if the queue is empty.
+/// Returns the number taken.
+int MPMCQueue_dequeue_batch(MPMCQueue *queue, void **out, int max);
+
+/// Values in the queue.  Only a snapshot while other threads are using it.
+size_t MPMCQueue_count(MPMCQueue *queue);
+
+#define MPMCQueue_capacity(Q) ((Q)->mask + 1)
+
+#endif
@@ -0,0 +1,239 @@
+#include <collect/radix_sort.h>
+#include <dbg.h>
+
+
+typedef struct RadixSort {
+    RadixItem *items;
+    size_t n;
+    Radix_key key;
+    // the low key_bits bits, which are all the sort looks at
+    uint64_t key_mask;
+    // items point at ListNodes rather than at the values themselves
+    int nodes;
+    int passes;
+    int blocks;
+    // blocks * passes * RADIX_BUCKETS digit counts
+    size_t *counts;
+} RadixSort;
+
+typedef struct RadixBlock {
+    RadixSort *sort;
+    int index;
+} RadixBlock;
+
+static inline unsigned int Radix_digit(uint64_t key, int pass)
+{
+    return (key >> (pass * RADIX_DIGIT_BITS)) & (RADIX_BUCKETS - 1);
+}
+
+/// extract the keys of one block of items and count the digits of every
+/// pass over them in a single read
+static void *RadixSort_count_block(void *args)
+{
+    RadixBlock *block = (RadixBlock *)args;
+    RadixSort *rs = block->sort;
+    size_t *counts = rs->counts +
+        (size_t)block->index * rs->passes * RADIX_BUCKETS;
+    size_t end = rs->n * (block->index + 1) / rs->blocks;
+    size_t i;
+    int pass;
+
+    for(i = rs->n * block->index / rs->blocks; i < end; i++) {
+        void *ptr = rs->items[i].ptr;
+        uint64_t key = rs->key(rs->nodes ? ((ListNode *)ptr)->value : ptr) &
+            rs->key_mask;
+        rs->items[i].key = key;
+        for(pass = 0; pass < rs->passes; pass++) {
+            counts[pass * RADIX_BUCKETS + Radix_digit(key, pass)]++;
+        }
+    }
+    return NULL;
+}
+
+/// sort rs->items by key, returning the buffer that holds the result,
+/// which is either items or scratch
+static RadixItem *RadixSort_run(RadixSort *rs, RadixItem *scratch,
+        TaskPool *pool)
+{
+    RadixBlock blocks[RADIX_MAX_BLOCKS];
+    Task tasks[RADIX_MAX_BLOCKS];
+    RadixItem *src = rs->items;
+    RadixItem *dst = scratch;
+    size_t offsets[RADIX_BUCKETS];
+    int pass, b, i;
+
+    for(b = 0; b < rs->blocks; b++) {
+        blocks[b].sort = rs;
+        blocks[b].index = b;
+    }
+    for(b = 1; b < rs->blocks; b++) {
+        TaskPool_spawn(pool, &tasks[b], RadixSort_count_block, &blocks[b]);
+    }
+    RadixSort_count_block(&blocks[0]);
+    for(b = 1; b < rs->blocks; b++) {
+        TaskPool_join(pool, &tasks[b]);
+    }
+
+    // fold the per block counts into the first block's
+    for(b = 1; b < rs->blocks; b++) {
+        size_t *counts = rs->counts + (size_t)b * rs->passes * RADIX_BUCKETS;
+        for(i = 0; i < rs->passes * RADIX_BUCKETS; i++) {
+            rs->counts[i] += counts[i];
+        }
+    }
+
+    for(pass = 0; pass < rs->passes; pass++) {
+        size_t *counts = rs->counts + pass * RADIX_BUCKETS;
+        size_t total = 0;
+        size_t n = 0;
+
+        // a digit every key shares leaves the order as it is
+        if(counts[Radix_digit(src[0].key, pass)] == rs->n) {
+            continue;
+        }
+
+        for(i = 0; i < RADIX_BUCKETS; i++) {
+            offsets[i] = total;
+            total += counts[i];
+        }
+        for(n = 0; n < rs->n; n++) {
+            dst[offsets[Radix_digit(src[n].key, pass)]++] = src[n];
+        }
+
+        RadixItem *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    return src;
+}
+
+/// allocate the items, scratch and counts for sorting n values
+static int RadixSort_init(RadixSort *rs, size_t n, Radix_key key,
+        int key_bits, TaskPool *pool, RadixItem **scratch)
+{
+    check(key != NULL, "Received null key function.");
+    check(key_bits > 0 && key_bits <= 64, "key_bits must be 1 to 64.");
+
+    rs->n = n;
+    rs->key = key;
+    rs->key_mask = key_bits == 64 ? UINT64_MAX : (1ull << key_bits) - 1;
+    rs->passes = (key_bits + RADIX_DIGIT_BITS - 1) / RADIX_DIGIT_BITS;
+    rs->blocks = 1;
+    if(n >= RADIX_PARALLEL_CUTOFF) {
+        rs->blocks = TaskPool_worker_count(pool);
+        if(rs->blocks > RADIX_MAX_BLOCKS) {
+            rs->blocks = RADIX_MAX_BLOCKS;
+        }
+    }
+
+    rs->items = malloc(2 * n * sizeof(RadixItem));
+    check_mem(rs->items);
+    *scratch = rs->items + n;
+    rs->counts = calloc((size_t)rs->blocks * rs->passes * RADIX_BUCKETS,
+            sizeof(size_t));
+    check_mem(rs->counts);
+    return 0;
+
+error:
+    if(rs->items) free(rs->items);
+    rs->items = NULL;
+    return -1;
+}
+
+static void RadixSort_free(RadixSort *rs)
+{
+    free(rs->items);
+    free(rs->counts);
+}
+
+
+int List_radix_sort(List *list, Radix_key key, int key_bits, TaskPool *pool)
+{
+    RadixSort rs = {0};
+    RadixItem *scratch = NULL;
+    size_t i = 0;
+
+    check(list != NULL, "Received null pointer for list.");
+    if(list->count < 2) {
+        return 0;
+    }
+    check(RadixSort_init(&rs, list->count, key, key_bits, pool,
+                &scratch) == 0, "Failed to set up radix sort.");
+    rs.nodes = 1;
+
+    ListNode *cur = list->first;
+    for(i = 0; i < rs.n; i++, cur = cur->next) {
+        rs.items[i].ptr = cur;
+    }
+
+    RadixItem *sorted = RadixSort_run(&rs, scratch, pool);
+
+    ListNode *prev = NULL;
+    for(i = 0; i < rs.n; i++) {
+        ListNode *node = sorted[i].ptr;
+        node->prev = prev;
+        if(prev == NULL) {
+            list->first = node;
+        } else {
+            prev->next = node;
+        }
+        prev = node;
+    }
+    prev->next = NULL;
+    list->last = prev;
+    List_reset_cursor(list);
+
+    RadixSort_free(&rs);
+    return 0;
+error:
+    return -1;
+}
+
+
+int DArray_radix_sort(DArray *array, Radix_key key, int key_bits,
+        TaskPool *pool)
+{
+    RadixSort rs = {0};
+    RadixItem *scratch = NULL;
+    char *moved = NULL;
+    size_t i = 0;
+
+    check(array != NULL, "Received null pointer for array.");
+    if(array->end < 2) {
+        return 0;
+    }
+    check(RadixSort_init(&rs, array->end, key, key_bits, pool,
+                &scratch) == 0, "Failed to set up radix sort.");
+
+    // inline elements are copied out once, in sorted order, at the end
+    size_t width = array->element_size;
+    if(DArray_is_inline(array)) {
+        moved = malloc(rs.n * width);
+        check_mem(moved);
+    }
+
+    for(i = 0; i < rs.n; i++) {
+        rs.items[i].ptr = DArray_get(array, i);
+    }
+
+    RadixItem *sorted = RadixSort_run(&rs, scratch, pool);
+
+    if(moved == NULL) {
+        for(i = 0; i < rs.n; i++) {
+            array->contents[i] = sorted[i].ptr;
+        }
+    } else {
+        for(i = 0; i < rs.n; i++) {
+            memcpy(moved + i * width, sorted[i].ptr, width);
+        }
+        memcpy(array->data, moved, rs.n * width);
+        free(moved);
+    }
+
+    RadixSort_free(&rs);
+    return 0;
+error:
+    RadixSort_free(&rs);
+    return -1;
+}
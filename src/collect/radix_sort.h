@@ -0,0 +1,55 @@
+#ifndef collect_Radix_sort_h
+#define collect_Radix_sort_h
+
+#include <stdint.h>
+#include <collect/darray.h>
+#include <collect/list.h>
+#include <collect/task_pool.h>
+
+// bits sorted per pass; 256 counters per pass fit comfortably in L1
+#define RADIX_DIGIT_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_DIGIT_BITS)
+// sorts shorter than this never count keys on the pool
+#define RADIX_PARALLEL_CUTOFF 65536
+#define RADIX_MAX_BLOCKS 64
+
+/// Extracts the unsigned integer key a value is sorted by.
+/**
+ * Keys are compared as unsigned.  Signed keys sort correctly once their
+ * sign bit is flipped, e.g. `(uint32_t)x ^ 0x80000000` for an int32_t.
+ */
+typedef uint64_t (*Radix_key)(void *value);
+
+/// A key paired with the node or element it came from.
+typedef struct RadixItem {
+    uint64_t key;
+    void *ptr;
+} RadixItem;
+
+/// Sort a list by integer key with a least significant digit radix sort.
+/**
+ * key is called once per value.  The nodes are gathered into a scratch
+ * array alongside their keys, sorted RADIX_DIGIT_BITS bits at a time from
+ * the lowest, and relinked in the result order, so the cost is linear in
+ * the length of the list and no values are compared.  Only the low
+ * key_bits bits of each key are sorted on (1 to 64); higher bits are
+ * masked off, so keys equal in those bits keep their order.  Passes over
+ * a digit that every key shares are skipped.  The sort is stable.
+ *
+ * Lists of at least RADIX_PARALLEL_CUTOFF values extract keys and count
+ * digits in blocks on pool, which may be NULL to do all the work on the
+ * calling thread.  Returns 0 on success.
+ */
+int List_radix_sort(List *list, Radix_key key, int key_bits, TaskPool *pool);
+
+/// Sort an array by integer key with a least significant digit radix sort.
+/**
+ * key receives element pointers, exactly as DArray_get returns them.  As
+ * in List_radix_sort the keys are sorted alongside a pointer to their
+ * element, and the elements themselves are only moved once, at the end.
+ * Returns 0 on success.
+ */
+int DArray_radix_sort(DArray *array, Radix_key key, int key_bits,
+        TaskPool *pool);
+
+#endif
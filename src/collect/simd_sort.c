@@ -0,0 +1,362 @@
+#include <collect/simd_sort.h>
+#include <collect/darray_algos.h>
+#include <math.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_SORT_X86 1
+#endif
+
+DARRAY_DEFINE_SORT(scalar_sort_i32, int32_t, (a > b) - (a < b))
+DARRAY_DEFINE_SORT(scalar_sort_u64, uint64_t, (a > b) - (a < b))
+DARRAY_DEFINE_SORT(scalar_sort_f32, float, (a > b) - (a < b))
+
+
+#ifdef SIMD_SORT_X86
+
+
+/// Define a vectorized merge sort of T, lanes to a vector, compiled for
+/// isa.  M is the signed integer type as wide as T, which comparisons,
+/// masks and shuffle indexes are made of.  MAX must not be less than any
+/// value of T; it pads runs out to whole vectors.
+#define SIMD_SORT_DEFINE(name, T, M, lanes, log_lanes, MAX, isa) \
+typedef T name##_vec __attribute__((vector_size((lanes) * sizeof(T)))); \
+typedef M name##_mask __attribute__((vector_size((lanes) * sizeof(T)))); \
+\
+/* shuffle indexes and lane masks for every stage of the networks */ \
+typedef struct name##_net { \
+    name##_mask reverse; \
+    name##_mask partner[log_lanes]; \
+    name##_mask low[log_lanes]; \
+    name##_mask keep_min[log_lanes + 1][log_lanes]; \
+} name##_net; \
+\
+__attribute__((target(isa))) \
+static void name##_net_init(name##_net *net) \
+{ \
+    name##_mask lane; \
+    int i, j, k; \
+    for(i = 0; i < (lanes); i++) { \
+        lane[i] = i; \
+    } \
+    net->reverse = (lanes) - 1 - lane; \
+    for(j = 0; j < (log_lanes); j++) { \
+        net->partner[j] = lane ^ (1 << j); \
+        net->low[j] = (lane & (1 << j)) == 0; \
+        for(k = j + 1; k <= (log_lanes); k++) { \
+            /* in a block of 2^k lanes sorting up, or down for odd ones */ \
+            net->keep_min[k][j] = ((lane & (1 << j)) == 0) == \
+                ((lane & (1 << k)) == 0); \
+        } \
+    } \
+} \
+\
+static inline __attribute__((target(isa), always_inline)) \
+name##_vec name##_select(name##_mask m, name##_vec a, name##_vec b) \
+{ \
+    return (name##_vec)(((name##_mask)a & m) | ((name##_mask)b & ~m)); \
+} \
+\
+/* compare every lane with its partner, keeping the min where keep is set */ \
+static inline __attribute__((target(isa), always_inline)) \
+name##_vec name##_exchange(name##_vec v, name##_mask partner, \
+        name##_mask keep) \
+{ \
+    name##_vec p = __builtin_shuffle(v, partner); \
+    name##_mask less = v < p; \
+    name##_vec lo = name##_select(less, v, p); \
+    name##_vec hi = name##_select(less, p, v); \
+    return name##_select(keep, lo, hi); \
+} \
+\
+/* sort one vector with a full bitonic network */ \
+static inline __attribute__((target(isa), always_inline)) \
+name##_vec name##_sort_vec(name##_net *net, name##_vec v) \
+{ \
+    int j, k; \
+    for(k = 1; k <= (log_lanes); k++) { \
+        for(j = k - 1; j >= 0; j--) { \
+            v = name##_exchange(v, net->partner[j], net->keep_min[k][j]); \
+        } \
+    } \
+    return v; \
+} \
+\
+/* sort a bitonic vector */ \
+static inline __attribute__((target(isa), always_inline)) \
+name##_vec name##_clean(name##_net *net, name##_vec v) \
+{ \
+    int j; \
+    for(j = (log_lanes) - 1; j >= 0; j--) { \
+        v = name##_exchange(v, net->partner[j], net->low[j]); \
+    } \
+    return v; \
+} \
+\
+/* merge two sorted vectors into the lanes smallest, in *lo, and the */ \
+/* lanes largest, in *hi */ \
+static inline __attribute__((target(isa), always_inline)) \
+void name##_merge_vec(name##_net *net, name##_vec a, name##_vec b, \
+        name##_vec *lo, name##_vec *hi) \
+{ \
+    b = __builtin_shuffle(b, net->reverse); \
+    name##_mask less = a < b; \
+    *lo = name##_clean(net, name##_select(less, a, b)); \
+    *hi = name##_clean(net, name##_select(less, b, a)); \
+} \
+\
+/* load the next vector of a run, padding past its end with MAX */ \
+static inline __attribute__((target(isa), always_inline)) \
+name##_vec name##_load(T *run, size_t at, size_t len) \
+{ \
+    name##_vec v; \
+    if(at + (lanes) <= len) { \
+        memcpy(&v, run + at, sizeof(v)); \
+    } else { \
+        T padded[lanes]; \
+        size_t i; \
+        for(i = 0; i < (lanes); i++) { \
+            padded[i] = at + i < len ? run[at + i] : (MAX); \
+        } \
+        memcpy(&v, padded, sizeof(v)); \
+    } \
+    return v; \
+} \
+\
+/* store a vector of output, dropping anything past the end */ \
+static inline __attribute__((target(isa), always_inline)) \
+void name##_store(T *out, size_t at, size_t len, name##_vec v) \
+{ \
+    if(at + (lanes) <= len) { \
+        memcpy(out + at, &v, sizeof(v)); \
+    } else if(at < len) { \
+        memcpy(out + at, &v, (len - at) * sizeof(T)); \
+    } \
+} \
+\
+/* merge a[0, na) and b[0, nb) into out.  Each step merges the next */ \
+/* vector from whichever run has the smaller head into the carried top */ \
+/* half of the last step, so every value that leaves is final.  The */ \
+/* padding sorts last and is dropped by the bounded stores. */ \
+__attribute__((target(isa))) \
+static void name##_merge(name##_net *net, T *a, size_t na, T *b, \
+        size_t nb, T *out) \
+{ \
+    size_t total = na + nb; \
+    size_t ia = (lanes); \
+    size_t ib = (lanes); \
+    size_t o = 0; \
+    name##_vec lo, carry; \
+\
+    name##_merge_vec(net, name##_load(a, 0, na), name##_load(b, 0, nb), \
+            &lo, &carry); \
+    name##_store(out, o, total, lo); \
+    o += (lanes); \
+\
+    while(ia < na || ib < nb) { \
+        name##_vec next; \
+        if(ia < na && (ib >= nb || a[ia] <= b[ib])) { \
+            next = name##_load(a, ia, na); \
+            ia += (lanes); \
+        } else { \
+            next = name##_load(b, ib, nb); \
+            ib += (lanes); \
+        } \
+        name##_merge_vec(net, carry, next, &lo, &carry); \
+        name##_store(out, o, total, lo); \
+        o += (lanes); \
+    } \
+    name##_store(out, o, total, carry); \
+} \
+\
+/* sort data[0, n), using scratch as the other half of each merge pass */ \
+__attribute__((target(isa))) \
+static void name(T *data, T *scratch, size_t n) \
+{ \
+    name##_net net; \
+    size_t i, j, width; \
+    T *src = data; \
+    T *dst = scratch; \
+\
+    name##_net_init(&net); \
+\
+    /* sorted runs of one vector, and a short sorted run at the end */ \
+    for(i = 0; i + (lanes) <= n; i += (lanes)) { \
+        name##_vec v; \
+        memcpy(&v, data + i, sizeof(v)); \
+        v = name##_sort_vec(&net, v); \
+        memcpy(data + i, &v, sizeof(v)); \
+    } \
+    for(j = i + 1; j < n; j++) { \
+        T tmp = data[j]; \
+        size_t k = j; \
+        for(; k > i && data[k - 1] > tmp; k--) { \
+            data[k] = data[k - 1]; \
+        } \
+        data[k] = tmp; \
+    } \
+\
+    for(width = (lanes); width < n; width *= 2) { \
+        for(i = 0; i < n; i += 2 * width) { \
+            size_t mid = i + width < n ? i + width : n; \
+            size_t hi = i + 2 * width < n ? i + 2 * width : n; \
+            if(mid == hi) { \
+                memcpy(dst + i, src + i, (hi - i) * sizeof(T)); \
+            } else { \
+                name##_merge(&net, src + i, mid - i, src + mid, hi - mid, \
+                        dst + i); \
+            } \
+        } \
+        T *tmp = src; \
+        src = dst; \
+        dst = tmp; \
+    } \
+\
+    if(src != data) { \
+        memcpy(data, src, n * sizeof(T)); \
+    } \
+}
+
+SIMD_SORT_DEFINE(sse42_sort_i32, int32_t, int32_t, 4, 2, INT32_MAX, "sse4.2")
+SIMD_SORT_DEFINE(avx2_sort_i32, int32_t, int32_t, 8, 3, INT32_MAX, "avx2")
+SIMD_SORT_DEFINE(avx512_sort_i32, int32_t, int32_t, 16, 4, INT32_MAX,
+        "avx512f")
+
+SIMD_SORT_DEFINE(sse42_sort_u64, uint64_t, int64_t, 2, 1, UINT64_MAX,
+        "sse4.2")
+SIMD_SORT_DEFINE(avx2_sort_u64, uint64_t, int64_t, 4, 2, UINT64_MAX, "avx2")
+SIMD_SORT_DEFINE(avx512_sort_u64, uint64_t, int64_t, 8, 3, UINT64_MAX,
+        "avx512f")
+
+SIMD_SORT_DEFINE(sse42_sort_f32, float, int32_t, 4, 2, INFINITY, "sse4.2")
+SIMD_SORT_DEFINE(avx2_sort_f32, float, int32_t, 8, 3, INFINITY, "avx2")
+SIMD_SORT_DEFINE(avx512_sort_f32, float, int32_t, 16, 4, INFINITY,
+        "avx512f")
+
+#endif
+
+
+static int simd_sort_detected = -1;
+static int simd_sort_level = -1;
+
+SimdSortLevel SimdSort_detected_level()
+{
+    int level = __atomic_load_n(&simd_sort_detected, __ATOMIC_RELAXED);
+    if(level >= 0) {
+        return level;
+    }
+
+    level = SIMD_SORT_SCALAR;
+#ifdef SIMD_SORT_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f")) {
+        level = SIMD_SORT_AVX512;
+    } else if(__builtin_cpu_supports("avx2")) {
+        level = SIMD_SORT_AVX2;
+    } else if(__builtin_cpu_supports("sse4.2")) {
+        level = SIMD_SORT_SSE42;
+    }
+#endif
+
+    // every thread detects the same answer, so racing here is harmless
+    __atomic_store_n(&simd_sort_detected, level, __ATOMIC_RELAXED);
+    return level;
+}
+
+SimdSortLevel SimdSort_level()
+{
+    int level = __atomic_load_n(&simd_sort_level, __ATOMIC_RELAXED);
+    return level >= 0 ? (SimdSortLevel)level : SimdSort_detected_level();
+}
+
+SimdSortLevel SimdSort_set_level(SimdSortLevel level)
+{
+    SimdSortLevel detected = SimdSort_detected_level();
+    if(level > detected || level < SIMD_SORT_SCALAR) {
+        level = detected;
+    }
+    __atomic_store_n(&simd_sort_level, level, __ATOMIC_RELAXED);
+    return level;
+}
+
+
+typedef void (*SimdSort_kernel)(void *data, void *scratch, size_t n);
+
+/// Check the array, then run the kernel for the current level on it, or
+/// scalar for short arrays and machines without a usable kernel.
+static int SimdSort_run(DArray *array, size_t element_size,
+        SimdSort_kernel *kernels, int (*scalar)(DArray *))
+{
+    check(array != NULL, "Received null pointer for array.");
+    check(DArray_is_inline(array) && array->element_size == element_size,
+            "Primitive sorts need an inline array of %zu byte keys.",
+            element_size);
+
+    SimdSortLevel level = SimdSort_level();
+    if(array->end < SIMD_SORT_CUTOFF || level == SIMD_SORT_SCALAR ||
+            kernels[level] == NULL) {
+        return scalar(array);
+    }
+
+    void *scratch = malloc((size_t)array->end * element_size);
+    check_mem(scratch);
+    kernels[level](array->data, scratch, array->end);
+    free(scratch);
+    return 0;
+
+error:
+    return -1;
+}
+
+#ifdef SIMD_SORT_X86
+#define SIMD_SORT_KERNELS(T) { NULL, (SimdSort_kernel)sse42_sort_##T, \
+    (SimdSort_kernel)avx2_sort_##T, (SimdSort_kernel)avx512_sort_##T }
+#else
+#define SIMD_SORT_KERNELS(T) { NULL, NULL, NULL, NULL }
+#endif
+
+int DArray_sort_i32(DArray *array)
+{
+    static SimdSort_kernel kernels[] = SIMD_SORT_KERNELS(i32);
+    return SimdSort_run(array, sizeof(int32_t), kernels, scalar_sort_i32);
+}
+
+int DArray_sort_u64(DArray *array)
+{
+    static SimdSort_kernel kernels[] = SIMD_SORT_KERNELS(u64);
+    return SimdSort_run(array, sizeof(uint64_t), kernels, scalar_sort_u64);
+}
+
+int DArray_sort_f32(DArray *array)
+{
+    static SimdSort_kernel kernels[] = SIMD_SORT_KERNELS(f32);
+    float *values = NULL;
+    int count = 0;
+    int i = 0;
+    int j = 0;
+    int rc = 0;
+
+    check(array != NULL, "Received null pointer for array.");
+    check(DArray_is_inline(array) && array->element_size == sizeof(float),
+            "Primitive sorts need an inline array of %zu byte keys.",
+            sizeof(float));
+
+    // NaN compares false both ways, which the networks can't order, so
+    // swap every NaN behind the numbers and sort only those
+    values = (float *)array->data;
+    count = array->end;
+    for(i = 0; i < count; i++) {
+        if(!isnan(values[i])) {
+            float tmp = values[j];
+            values[j++] = values[i];
+            values[i] = tmp;
+        }
+    }
+
+    array->end = j;
+    rc = SimdSort_run(array, sizeof(float), kernels, scalar_sort_f32);
+    array->end = count;
+    return rc;
+
+error:
+    return -1;
+}
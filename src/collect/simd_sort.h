@@ -0,0 +1,49 @@
+#ifndef collect_Simd_sort_h
+#define collect_Simd_sort_h
+
+#include <stdint.h>
+#include <collect/darray.h>
+
+// arrays shorter than this are left to the scalar sort
+#define SIMD_SORT_CUTOFF 64
+
+/// Instruction sets the primitive sorts can run on, weakest first.
+typedef enum {
+    SIMD_SORT_SCALAR,
+    SIMD_SORT_SSE42,
+    SIMD_SORT_AVX2,
+    SIMD_SORT_AVX512
+} SimdSortLevel;
+
+/// The best level this machine supports, detected once on first use.
+SimdSortLevel SimdSort_detected_level();
+
+/// The level the sorts currently dispatch to.
+SimdSortLevel SimdSort_level();
+
+/// Limit the sorts to at most level, for testing and benchmarking.
+/**
+ * Levels the machine doesn't support are lowered to the detected level.
+ * Returns the level that is now in effect.
+ */
+SimdSortLevel SimdSort_set_level(SimdSortLevel level);
+
+/// Sort an inline array of int32_t, uint64_t or float in ascending order.
+/**
+ * Each full vector of the array is first sorted in registers with a
+ * bitonic sorting network, then the sorted runs are merged in passes of
+ * doubling width by a vectorized bitonic merge, which consumes a vector
+ * of input per step without branching on the values.  The widest of
+ * SSE4.2, AVX2 and AVX-512 that the CPU supports is picked at runtime,
+ * with a scalar introsort for other machines and short arrays.  Needs a
+ * scratch buffer the size of the array.
+ *
+ * The array must be inline with element_size equal to the key's size.
+ * NaNs are moved after every other float, in no particular order.
+ * Returns 0 on success.
+ */
+int DArray_sort_i32(DArray *array);
+int DArray_sort_u64(DArray *array);
+int DArray_sort_f32(DArray *array);
+
+#endif
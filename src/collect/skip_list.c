@@ -0,0 +1,394 @@
+/*
+ * Indexable skip list.
+ * Copyright (C) 2014 Axel Magnuson <axelmagn@gmail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <collect/skip_list.h>
+#include <dbg.h>
+
+
+/// The predecessor of a position on every level, and where each one sits.
+typedef struct SkipListPath {
+	SkipListNode *nodes[SKIP_LIST_MAX_LEVEL];
+	int positions[SKIP_LIST_MAX_LEVEL];
+} SkipListPath;
+
+
+static SkipListNode *SkipListNode_create(int level, void *value)
+{
+	SkipListNode *node = calloc(1, sizeof(SkipListNode) +
+			level * sizeof(SkipListLink));
+	check_mem(node);
+	node->level = level;
+	node->value = value;
+	return node;
+error:
+	return NULL;
+}
+
+
+/// Allocate a new skip list.
+SkipList *SkipList_create(List_compare compare)
+{
+	SkipList *list = calloc(1, sizeof(SkipList));
+	check_mem(list);
+	list->head = SkipListNode_create(SKIP_LIST_MAX_LEVEL, NULL);
+	check_mem(list->head);
+	list->compare = compare;
+	// any nonzero seed will do; mixing in the address varies it per list
+	list->seed = (uint64_t)(uintptr_t)list ^ 0x9e3779b97f4a7c15ULL;
+	return list;
+error:
+	if(list) { free(list); }
+	return NULL;
+}
+
+
+/// Free a skip list and its nodes, but not its values.
+void SkipList_destroy(SkipList *list)
+{
+	SkipListNode *cur = list->head;
+	while(cur != NULL) {
+		SkipListNode *next = cur->links[0].next;
+		free(cur);
+		cur = next;
+	}
+	free(list);
+}
+
+
+/// Free all values contained by the list.
+void SkipList_clear(SkipList *list)
+{
+	SKIP_LIST_FOREACH(list, cur) {
+		free(cur->value);
+	}
+}
+
+
+/// Free a list, its nodes, and any values it contains.
+void SkipList_clear_destroy(SkipList *list)
+{
+	SkipList_clear(list);
+	SkipList_destroy(list);
+}
+
+
+/// draw a level for a new node: each extra level has a one in four chance.
+static int SkipList_random_level(SkipList *list)
+{
+	// xorshift64*
+	uint64_t x = list->seed;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	list->seed = x;
+	uint64_t bits = x * 0x2545f4914f6cdd1dULL;
+
+	int level = 1;
+	while(level < SKIP_LIST_MAX_LEVEL && (bits & 3) == 0) {
+		level++;
+		bits >>= 2;
+	}
+	return level;
+}
+
+
+/// find the predecessors of position index.
+static void SkipList_path_to(SkipList *list, int index, SkipListPath *path)
+{
+	SkipListNode *node = list->head;
+	int pos = -1;
+	int i;
+
+	// level 0 is walked even when empty, so the path always has a node
+	for(i = (list->level > 0 ? list->level : 1) - 1; i >= 0; i--) {
+		while(node->links[i].next != NULL &&
+				pos + node->links[i].width < index) {
+			pos += node->links[i].width;
+			node = node->links[i].next;
+		}
+		path->nodes[i] = node;
+		path->positions[i] = pos;
+	}
+}
+
+
+/// find the predecessors of the first value greater than value, or of the
+/// first value not less than it if strict.  Returns that value's index.
+static int SkipList_path_by_value(SkipList *list, void *value, int strict,
+		SkipListPath *path)
+{
+	SkipListNode *node = list->head;
+	int pos = -1;
+	int i;
+
+	for(i = (list->level > 0 ? list->level : 1) - 1; i >= 0; i--) {
+		SkipListNode *next = node->links[i].next;
+		while(next != NULL) {
+			int rc = list->compare(next->value, value);
+			if(rc > 0 || (strict && rc == 0)) {
+				break;
+			}
+			pos += node->links[i].width;
+			node = next;
+			next = node->links[i].next;
+		}
+		path->nodes[i] = node;
+		path->positions[i] = pos;
+	}
+
+	return pos + 1;
+}
+
+
+/// link a new node in at index, after the predecessors in path.
+static int SkipList_link(SkipList *list, SkipListPath *path, int index,
+		void *value)
+{
+	int level = SkipList_random_level(list);
+	SkipListNode *node = SkipListNode_create(level, value);
+	int i;
+	check_mem(node);
+
+	// levels the list hasn't used yet start out as one link off the end
+	for(i = list->level; i < level; i++) {
+		list->head->links[i].next = NULL;
+		list->head->links[i].width = list->count + 1;
+		path->nodes[i] = list->head;
+		path->positions[i] = -1;
+	}
+
+	for(i = 0; i < level; i++) {
+		SkipListLink *link = &path->nodes[i]->links[i];
+		// the node after us moves from end to end + 1
+		int end = path->positions[i] + link->width;
+		node->links[i].next = link->next;
+		node->links[i].width = end + 1 - index;
+		link->next = node;
+		link->width = index - path->positions[i];
+	}
+	// links passing over the new node just got one longer
+	for(i = level; i < list->level; i++) {
+		path->nodes[i]->links[i].width++;
+	}
+
+	if(level > list->level) {
+		list->level = level;
+	}
+	if(node->links[0].next == NULL) {
+		list->last = node;
+	}
+	list->count++;
+	return 0;
+
+error:
+	return -1;
+}
+
+
+/// unlink and free the node at index, after the predecessors in path.
+static void *SkipList_unlink(SkipList *list, SkipListPath *path)
+{
+	SkipListNode *node = path->nodes[0]->links[0].next;
+	void *value = node->value;
+	int i;
+
+	for(i = 0; i < list->level; i++) {
+		SkipListLink *link = &path->nodes[i]->links[i];
+		if(link->next == node) {
+			link->next = node->links[i].next;
+			link->width += node->links[i].width - 1;
+		} else {
+			link->width--;
+		}
+	}
+
+	while(list->level > 0 &&
+			list->head->links[list->level - 1].next == NULL) {
+		list->level--;
+	}
+	if(list->last == node) {
+		list->last = path->nodes[0] != list->head ? path->nodes[0] : NULL;
+	}
+	list->count--;
+
+	free(node);
+	return value;
+}
+
+
+/// retrieve the node at an index, or NULL if it is out of bounds.
+SkipListNode *SkipList_node_at(SkipList *list, int index)
+{
+	SkipListNode *node = list->head;
+	int pos = -1;
+	int i;
+
+	check(index >= 0 && index < list->count,
+			"SkipList size is %d.  Index %d out of bounds.",
+			list->count, index);
+
+	for(i = list->level - 1; i >= 0 && pos != index; i--) {
+		while(node->links[i].next != NULL &&
+				pos + node->links[i].width <= index) {
+			pos += node->links[i].width;
+			node = node->links[i].next;
+		}
+	}
+	return node;
+
+error:
+	return NULL;
+}
+
+
+/// retrieve the value stored at an index.
+void *SkipList_get(SkipList *list, int index)
+{
+	SkipListNode *node = SkipList_node_at(list, index);
+	return node != NULL ? node->value : NULL;
+}
+
+
+/// insert a value so that it ends up at index.
+int SkipList_insert(SkipList *list, int index, void *value)
+{
+	SkipListPath path;
+
+	check(index >= 0 && index <= list->count,
+			"SkipList size is %d.  Index %d out of bounds.",
+			list->count, index);
+
+	SkipList_path_to(list, index, &path);
+	return SkipList_link(list, &path, index, value);
+
+error:
+	return -1;
+}
+
+
+/// remove and return the value at an index.
+void *SkipList_remove(SkipList *list, int index)
+{
+	SkipListPath path;
+
+	check(index >= 0 && index < list->count,
+			"SkipList size is %d.  Index %d out of bounds.",
+			list->count, index);
+
+	SkipList_path_to(list, index, &path);
+	return SkipList_unlink(list, &path);
+
+error:
+	return NULL;
+}
+
+
+/// push a new value onto the end of the list.
+void SkipList_push(SkipList *list, void *value)
+{
+	SkipList_insert(list, list->count, value);
+}
+
+
+/// remove and return the end of the list.
+void *SkipList_pop(SkipList *list)
+{
+	return list->count > 0 ? SkipList_remove(list, list->count - 1) : NULL;
+}
+
+
+/// push a new value onto the beginning of the list.
+void SkipList_unshift(SkipList *list, void *value)
+{
+	SkipList_insert(list, 0, value);
+}
+
+
+/// remove and return the beginning of the list.
+void *SkipList_shift(SkipList *list)
+{
+	return list->count > 0 ? SkipList_remove(list, 0) : NULL;
+}
+
+
+/// insert a value after every value that does not compare greater.
+int SkipList_insert_sorted(SkipList *list, void *value)
+{
+	SkipListPath path;
+
+	check(list->compare != NULL, "SkipList has no comparator.");
+
+	int index = SkipList_path_by_value(list, value, 0, &path);
+	check(SkipList_link(list, &path, index, value) == 0,
+			"Failed to insert into SkipList.");
+	return index;
+
+error:
+	return -1;
+}
+
+
+/// number of values that compare less than value.
+int SkipList_rank(SkipList *list, void *value)
+{
+	SkipListPath path;
+
+	check(list->compare != NULL, "SkipList has no comparator.");
+	return SkipList_path_by_value(list, value, 1, &path);
+
+error:
+	return -1;
+}
+
+
+/// index of the first value equal to value, or -1 if there is none.
+int SkipList_find(SkipList *list, void *value)
+{
+	SkipListPath path;
+
+	check(list->compare != NULL, "SkipList has no comparator.");
+
+	int index = SkipList_path_by_value(list, value, 1, &path);
+	SkipListNode *node = path.nodes[0]->links[0].next;
+	if(node != NULL && list->compare(node->value, value) == 0) {
+		return index;
+	}
+
+error:
+	return -1;
+}
+
+
+/// first node whose value does not compare less than value, or NULL.
+SkipListNode *SkipList_lower_bound(SkipList *list, void *value)
+{
+	SkipListPath path;
+
+	check(list->compare != NULL, "SkipList has no comparator.");
+
+	SkipList_path_by_value(list, value, 1, &path);
+	return path.nodes[0]->links[0].next;
+
+error:
+	return NULL;
+}
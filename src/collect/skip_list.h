@@ -0,0 +1,149 @@
+/*
+ * Indexable skip list.
+ * Copyright (C) 2014 Axel Magnuson <axelmagn@gmail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef collect_Skip_list_h
+#define collect_Skip_list_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <collect/list.h>
+
+#define SKIP_LIST_MAX_LEVEL 32
+
+struct SkipListNode;
+
+/// A forward link that also records how many positions it skips.
+typedef struct SkipListLink {
+	struct SkipListNode *next;
+	int width;
+} SkipListLink;
+
+/// A node of a SkipList, with one link per level it takes part in.
+typedef struct SkipListNode {
+	void *value;
+	int level;
+	SkipListLink links[];
+} SkipListNode;
+
+/// An indexable skip list.
+/**
+ * Each node is linked into a random number of levels, a quarter as many
+ * nodes on each level as on the one below, and every link knows its width:
+ * the number of positions between the two nodes it joins.  Summing widths
+ * on the way down finds a node by index, or the index of a node found by
+ * value, in O(log n) expected steps.  Links running off the end of a level
+ * have the width they would have to a node just past the last one.
+ *
+ * head is a sentinel holding links for every level, and sits before
+ * position 0.  compare is only used by the sorted functions; positional
+ * inserts leave ordering up to the caller.
+ */
+typedef struct SkipList {
+	int count;
+	int level;
+	List_compare compare;
+	SkipListNode *head;
+	SkipListNode *last;
+	uint64_t seed;
+} SkipList;
+
+
+/// Allocate a new skip list.  compare may be NULL if the list is only
+/// accessed by position.
+SkipList *SkipList_create(List_compare compare);
+
+/// Free a skip list and its nodes, but not its values.
+void SkipList_destroy(SkipList *list);
+
+/// Free all values contained by the list.
+void SkipList_clear(SkipList *list);
+
+/// Free a list, its nodes, and any values it contains.
+void SkipList_clear_destroy(SkipList *list);
+
+
+#define SkipList_count(A) ((A)->count)
+#define SkipList_first(A) ((A)->head->links[0].next != NULL ? \
+		(A)->head->links[0].next->value : NULL)
+#define SkipList_last(A) ((A)->last != NULL ? (A)->last->value : NULL)
+
+
+/// retrieve the node at an index, or NULL if it is out of bounds.
+SkipListNode *SkipList_node_at(SkipList *list, int index);
+
+/// retrieve the value stored at an index.
+void *SkipList_get(SkipList *list, int index);
+
+/// insert a value so that it ends up at index, between 0 and count.
+/// Returns 0 on success.
+int SkipList_insert(SkipList *list, int index, void *value);
+
+/// remove and return the value at an index.
+void *SkipList_remove(SkipList *list, int index);
+
+
+/// push a new value onto the end of the list.
+void SkipList_push(SkipList *list, void *value);
+
+/// remove and return the end of the list.
+void *SkipList_pop(SkipList *list);
+
+/// push a new value onto the beginning of the list.
+void SkipList_unshift(SkipList *list, void *value);
+
+/// remove and return the beginning of the list.
+void *SkipList_shift(SkipList *list);
+
+
+/// insert a value after every value that does not compare greater.
+/**
+ * Equal values keep their insertion order.  Returns the index the value
+ * was inserted at, or -1 on failure.
+ */
+int SkipList_insert_sorted(SkipList *list, void *value);
+
+/// number of values that compare less than value.
+int SkipList_rank(SkipList *list, void *value);
+
+/// index of the first value equal to value, or -1 if there is none.
+int SkipList_find(SkipList *list, void *value);
+
+/// first node whose value does not compare less than value, or NULL.
+/**
+ * Iterate a range of values by following links[0] from here until the
+ * values pass the end of the range.
+ */
+SkipListNode *SkipList_lower_bound(SkipList *list, void *value);
+
+
+#define SkipListNode_next(N) ((N)->links[0].next)
+
+/// convenience for loop iterating across a skip list in order.
+/**
+ * @param L the list to iterate on.
+ * @param V the name to use for the pointer to the current node.
+ */
+#define SKIP_LIST_FOREACH(L, V) SkipListNode *V = NULL;\
+	for(V = (L)->head->links[0].next; V != NULL; V = V->links[0].next)
+
+#endif
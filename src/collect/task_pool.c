@@ -0,0 +1,350 @@
+/*
+ * Work-stealing task pool for fork/join parallelism.
+ * Copyright (C) 2014 Axel Magnuson <axelmagn@gmail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <collect/task_pool.h>
+#include <dbg.h>
+#include <sched.h>
+#include <unistd.h>
+
+#define TASK_DEQUE_MIN 64
+// rounds of fruitless stealing before an idle worker goes to sleep
+#define TASK_IDLE_SPINS 64
+
+/// worker index of the current thread, or -1 outside of any pool
+static __thread int current_worker = -1;
+static __thread TaskPool *current_pool = NULL;
+
+static TaskPool *default_pool = NULL;
+static pthread_once_t default_pool_once = PTHREAD_ONCE_INIT;
+
+
+static int TaskDeque_init(TaskDeque *deque)
+{
+	deque->lock = calloc(1, sizeof(pthread_mutex_t));
+	check_mem(deque->lock);
+	int err = pthread_mutex_init(deque->lock, NULL);
+	check(err == 0, "Failed to initialize mutex TaskDeque->lock");
+	deque->tasks = calloc(TASK_DEQUE_MIN, sizeof(Task *));
+	check_mem(deque->tasks);
+	deque->max = TASK_DEQUE_MIN;
+	return 0;
+error:
+	if(deque->lock) { free(deque->lock); }
+	deque->lock = NULL;
+	return -1;
+}
+
+static void TaskDeque_free(TaskDeque *deque)
+{
+	if(deque->lock) {
+		pthread_mutex_destroy(deque->lock);
+		free(deque->lock);
+	}
+	free(deque->tasks);
+}
+
+/// push onto the tail, growing the ring if it is full
+static int TaskDeque_push(TaskDeque *deque, Task *task)
+{
+	int rc = -1;
+	pthread_mutex_lock(deque->lock);
+	if(deque->count == deque->max) {
+		Task **tasks = calloc(deque->max * 2, sizeof(Task *));
+		check_mem(tasks);
+		int i;
+		for(i = 0; i < deque->count; i++) {
+			tasks[i] = deque->tasks[(deque->head + i) % deque->max];
+		}
+		free(deque->tasks);
+		deque->tasks = tasks;
+		deque->head = 0;
+		deque->max *= 2;
+	}
+	deque->tasks[(deque->head + deque->count) % deque->max] = task;
+	deque->count++;
+	rc = 0;
+error:
+	pthread_mutex_unlock(deque->lock);
+	return rc;
+}
+
+/// take the newest task, for the owning worker
+static Task *TaskDeque_pop(TaskDeque *deque)
+{
+	Task *task = NULL;
+	pthread_mutex_lock(deque->lock);
+	if(deque->count > 0) {
+		deque->count--;
+		task = deque->tasks[(deque->head + deque->count) % deque->max];
+	}
+	pthread_mutex_unlock(deque->lock);
+	return task;
+}
+
+/// take the oldest task, for thieves
+static Task *TaskDeque_steal(TaskDeque *deque)
+{
+	Task *task = NULL;
+	// peek without the lock so empty deques stay uncontended
+	if(__atomic_load_n(&deque->count, __ATOMIC_RELAXED) == 0) {
+		return NULL;
+	}
+	pthread_mutex_lock(deque->lock);
+	if(deque->count > 0) {
+		task = deque->tasks[deque->head];
+		deque->head = (deque->head + 1) % deque->max;
+		deque->count--;
+	}
+	pthread_mutex_unlock(deque->lock);
+	return task;
+}
+
+
+static void Task_run(Task *task)
+{
+	task->result = task->func(task->arg);
+	__atomic_store_n(&task->done, 1, __ATOMIC_RELEASE);
+}
+
+/// find a queued task: our own newest first, then steal from the others
+static Task *TaskPool_find(TaskPool *pool, int self)
+{
+	Task *task = NULL;
+	int queues = pool->worker_count + 1;
+	int i;
+
+	if(self >= 0) {
+		task = TaskDeque_pop(&pool->deques[self]);
+	}
+	for(i = 1; task == NULL && i <= queues; i++) {
+		int victim = ((self < 0 ? 0 : self) + i) % queues;
+		if(victim != self) {
+			task = TaskDeque_steal(&pool->deques[victim]);
+		}
+	}
+	if(task != NULL) {
+		__atomic_sub_fetch(&pool->pending, 1, __ATOMIC_SEQ_CST);
+	}
+	return task;
+}
+
+static void *TaskPool_worker(void *args)
+{
+	TaskPool *pool = (TaskPool *)args;
+	int self = -1;
+	int spins = 0;
+
+	// our index is our position in the workers array
+	pthread_mutex_lock(pool->idle_lock);
+	for(self = 0; self < pool->worker_count; self++) {
+		if(pthread_equal(pool->workers[self], pthread_self())) {
+			break;
+		}
+	}
+	pthread_mutex_unlock(pool->idle_lock);
+	current_worker = self;
+	current_pool = pool;
+
+	while(!__atomic_load_n(&pool->shutdown, __ATOMIC_ACQUIRE)) {
+		Task *task = TaskPool_find(pool, self);
+		if(task != NULL) {
+			Task_run(task);
+			spins = 0;
+			continue;
+		}
+		if(++spins < TASK_IDLE_SPINS) {
+			sched_yield();
+			continue;
+		}
+
+		// nothing to steal, sleep until a spawn signals us
+		pthread_mutex_lock(pool->idle_lock);
+		__atomic_add_fetch(&pool->idle, 1, __ATOMIC_SEQ_CST);
+		if(__atomic_load_n(&pool->pending, __ATOMIC_SEQ_CST) == 0 &&
+				!pool->shutdown) {
+			pthread_cond_wait(pool->idle_cond, pool->idle_lock);
+		}
+		__atomic_sub_fetch(&pool->idle, 1, __ATOMIC_SEQ_CST);
+		pthread_mutex_unlock(pool->idle_lock);
+		spins = 0;
+	}
+
+	return NULL;
+}
+
+
+/// Stop any running workers and release everything the pool owns.
+static void TaskPool_free(TaskPool *pool, int deque_count, int started)
+{
+	int i;
+	if(started > 0) {
+		pthread_mutex_lock(pool->idle_lock);
+		__atomic_store_n(&pool->shutdown, 1, __ATOMIC_RELEASE);
+		pthread_cond_broadcast(pool->idle_cond);
+		pthread_mutex_unlock(pool->idle_lock);
+
+		for(i = 0; i < started; i++) {
+			pthread_join(pool->workers[i], NULL);
+		}
+	}
+
+	if(pool->deques) {
+		for(i = 0; i < deque_count; i++) {
+			TaskDeque_free(&pool->deques[i]);
+		}
+	}
+	if(pool->idle_cond) { pthread_cond_destroy(pool->idle_cond); }
+	if(pool->idle_lock) { pthread_mutex_destroy(pool->idle_lock); }
+	free(pool->deques);
+	free(pool->workers);
+	free(pool->idle_cond);
+	free(pool->idle_lock);
+	free(pool);
+}
+
+
+/// Allocate a pool and start its workers.
+TaskPool *TaskPool_create(int worker_count)
+{
+	int i;
+	int started = 0;
+	TaskPool *pool = calloc(1, sizeof(TaskPool));
+	check_mem(pool);
+
+	if(worker_count < 1) {
+		long cores = sysconf(_SC_NPROCESSORS_ONLN);
+		worker_count = cores > 0 ? (int)cores : 1;
+	}
+	pool->worker_count = worker_count;
+
+	pool->idle_lock = calloc(1, sizeof(pthread_mutex_t));
+	check_mem(pool->idle_lock);
+	check(pthread_mutex_init(pool->idle_lock, NULL) == 0,
+			"Failed to initialize mutex TaskPool->idle_lock");
+	pool->idle_cond = calloc(1, sizeof(pthread_cond_t));
+	check_mem(pool->idle_cond);
+	check(pthread_cond_init(pool->idle_cond, NULL) == 0,
+			"Failed to initialize TaskPool->idle_cond");
+
+	// one deque per worker, plus one for threads outside the pool
+	pool->deques = calloc(worker_count + 1, sizeof(TaskDeque));
+	check_mem(pool->deques);
+	for(i = 0; i <= worker_count; i++) {
+		check(TaskDeque_init(&pool->deques[i]) == 0,
+				"Failed to initialize TaskDeque %d", i);
+	}
+
+	pool->workers = calloc(worker_count, sizeof(pthread_t));
+	check_mem(pool->workers);
+	// hold idle_lock so workers can't look up their index early
+	pthread_mutex_lock(pool->idle_lock);
+	for(started = 0; started < worker_count; started++) {
+		int rc = pthread_create(&pool->workers[started], NULL,
+				TaskPool_worker, pool);
+		if(rc != 0) {
+			log_err("Return code from pthread_create() on worker "
+					"is %d", rc);
+			break;
+		}
+	}
+	pthread_mutex_unlock(pool->idle_lock);
+	check(started == worker_count, "Failed to start TaskPool workers");
+
+	return pool;
+error:
+	if(pool != NULL) { TaskPool_free(pool, worker_count + 1, started); }
+	return NULL;
+}
+
+
+/// Stop the workers and free the pool.  No tasks may be outstanding.
+void TaskPool_destroy(TaskPool *pool)
+{
+	TaskPool_free(pool, pool->worker_count + 1, pool->worker_count);
+}
+
+
+static void TaskPool_default_init()
+{
+	default_pool = TaskPool_create(0);
+}
+
+/// The library wide pool, sized to the machine and created on first use.
+TaskPool *TaskPool_default()
+{
+	pthread_once(&default_pool_once, TaskPool_default_init);
+	return default_pool;
+}
+
+
+/// Queue func(arg) to run on the pool, recording it in task.
+void TaskPool_spawn(TaskPool *pool, Task *task, Task_func func, void *arg)
+{
+	task->func = func;
+	task->arg = arg;
+	task->result = NULL;
+	task->done = 0;
+
+	if(pool == NULL) {
+		Task_run(task);
+		return;
+	}
+
+	int self = current_pool == pool ? current_worker : pool->worker_count;
+	if(TaskDeque_push(&pool->deques[self], task) != 0) {
+		// out of memory for the queue; do the work ourselves
+		Task_run(task);
+		return;
+	}
+
+	__atomic_add_fetch(&pool->pending, 1, __ATOMIC_SEQ_CST);
+	if(__atomic_load_n(&pool->idle, __ATOMIC_SEQ_CST) > 0) {
+		pthread_mutex_lock(pool->idle_lock);
+		pthread_cond_signal(pool->idle_cond);
+		pthread_mutex_unlock(pool->idle_lock);
+	}
+}
+
+
+/// Wait for a spawned task and return its result.
+void *TaskPool_join(TaskPool *pool, Task *task)
+{
+	int self = -1;
+
+	if(pool != NULL && current_pool == pool) {
+		self = current_worker;
+	}
+
+	while(!__atomic_load_n(&task->done, __ATOMIC_ACQUIRE)) {
+		// help out rather than block.  When the task is still ours it is
+		// usually the newest one on our deque, so this runs it inline.
+		Task *other = pool != NULL ? TaskPool_find(pool, self) : NULL;
+		if(other != NULL) {
+			Task_run(other);
+		} else {
+			sched_yield();
+		}
+	}
+
+	return task->result;
+}
@@ -0,0 +1,106 @@
+/*
+ * Work-stealing task pool for fork/join parallelism.
+ * Copyright (C) 2014 Axel Magnuson <axelmagn@gmail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef collect_Task_pool_h
+#define collect_Task_pool_h
+
+#include <stdlib.h>
+#include <pthread.h>
+
+typedef void *(*Task_func)(void *arg);
+
+/// A unit of work scheduled on a TaskPool.
+/**
+ * Tasks are owned by the caller, usually on the stack of the function that
+ * spawns them, and must stay alive until TaskPool_join returns.
+ */
+typedef struct Task {
+	Task_func func;
+	void *arg;
+	void *result;
+	int done;
+} Task;
+
+/// A double ended queue of tasks.  The owner works from the tail while
+/// thieves take from the head.
+typedef struct TaskDeque {
+	pthread_mutex_t *lock;
+	Task **tasks;
+	int head;
+	int count;
+	int max;
+} TaskDeque;
+
+/// A fixed set of worker threads that balance fork/join work by stealing.
+/**
+ * Every worker owns a deque.  Tasks spawned from a worker go onto its own
+ * deque, and tasks spawned from any other thread go onto a shared injection
+ * deque.  Idle workers steal from the oldest end of the other deques, and a
+ * thread waiting in TaskPool_join runs queued tasks instead of blocking, so
+ * nested fork/join never deadlocks on a full pool.
+ */
+typedef struct TaskPool {
+	int worker_count;
+	pthread_t *workers;
+	TaskDeque *deques;
+	pthread_mutex_t *idle_lock;
+	pthread_cond_t *idle_cond;
+	int pending;
+	int idle;
+	int shutdown;
+} TaskPool;
+
+
+/// Allocate a pool and start its workers.
+/**
+ * @param worker_count number of worker threads.  Values less than 1 size
+ * the pool to the number of online cores.
+ */
+TaskPool *TaskPool_create(int worker_count);
+
+/// Stop the workers and free the pool.  No tasks may be outstanding.
+void TaskPool_destroy(TaskPool *pool);
+
+/// The library wide pool, sized to the machine and created on first use.
+/**
+ * Returns NULL only if the pool could not be started, in which case
+ * TaskPool_spawn runs tasks inline.
+ */
+TaskPool *TaskPool_default();
+
+#define TaskPool_worker_count(P) ((P) != NULL ? (P)->worker_count : 1)
+
+
+/// Queue func(arg) to run on the pool, recording it in task.
+/**
+ * If pool is NULL the task runs immediately in the calling thread.
+ */
+void TaskPool_spawn(TaskPool *pool, Task *task, Task_func func, void *arg);
+
+/// Wait for a spawned task and return its result.
+/**
+ * The calling thread executes other queued tasks while it waits.
+ */
+void *TaskPool_join(TaskPool *pool, Task *task);
+
+#endif
@@ -0,0 +1,247 @@
+/*
+ * Unrolled linked list.
+ * Copyright (C) 2014 Axel Magnuson <axelmagn@gmail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <collect/unrolled_list.h>
+#include <dbg.h>
+#include <string.h>
+
+
+static UnrolledNode *UnrolledNode_create()
+{
+	UnrolledNode *node = NULL;
+	int rc = posix_memalign((void **)&node, UNROLLED_NODE_ALIGN,
+			sizeof(UnrolledNode));
+	check(rc == 0, "Failed to allocate UnrolledNode.");
+	node->next = NULL;
+	node->prev = NULL;
+	node->count = 0;
+	return node;
+error:
+	return NULL;
+}
+
+
+/// Allocate a new list from the heap.
+UnrolledList *UnrolledList_create()
+{
+	UnrolledList *list = calloc(1, sizeof(UnrolledList));
+	check_mem(list);
+	return list;
+error:
+	return NULL;
+}
+
+
+/// Free a list and its nodes, but not its values.
+void UnrolledList_destroy(UnrolledList *list)
+{
+	UnrolledNode *node = list->first;
+	while(node != NULL) {
+		UnrolledNode *next = node->next;
+		free(node);
+		node = next;
+	}
+	free(list);
+}
+
+
+/// Free all values contained by the list.
+void UnrolledList_clear(UnrolledList *list)
+{
+	UNROLLED_LIST_FOREACH(list, node, i) {
+		free(node->values[i]);
+	}
+}
+
+
+/// Free a list, its nodes, and any values it contains.
+void UnrolledList_clear_destroy(UnrolledList *list)
+{
+	UnrolledList_clear(list);
+	UnrolledList_destroy(list);
+}
+
+
+/// unlink and free an empty node.
+static void UnrolledList_drop_node(UnrolledList *list, UnrolledNode *node)
+{
+	if(node->prev != NULL) {
+		node->prev->next = node->next;
+	} else {
+		list->first = node->next;
+	}
+	if(node->next != NULL) {
+		node->next->prev = node->prev;
+	} else {
+		list->last = node->prev;
+	}
+	free(node);
+}
+
+
+/// find the node holding index, and the index's offset within it.
+static UnrolledNode *UnrolledList_locate(UnrolledList *list, int index,
+		int *offset)
+{
+	UnrolledNode *node = NULL;
+
+	// seek from whichever side is closest
+	if(index <= list->count / 2) {
+		for(node = list->first; index >= node->count; node = node->next) {
+			index -= node->count;
+		}
+	} else {
+		int after = list->count - 1 - index;
+		for(node = list->last; after >= node->count; node = node->prev) {
+			after -= node->count;
+		}
+		index = node->count - 1 - after;
+	}
+
+	*offset = index;
+	return node;
+}
+
+
+/// retrieve the value stored at an index, or NULL if it is out of bounds.
+void *UnrolledList_get(UnrolledList *list, int index)
+{
+	int offset = 0;
+	check(index >= 0 && index < list->count,
+			"UnrolledList size is %d.  Index %d out of bounds.",
+			list->count, index);
+
+	UnrolledNode *node = UnrolledList_locate(list, index, &offset);
+	return node->values[offset];
+error:
+	return NULL;
+}
+
+
+/// remove and return the value stored at an index.
+void *UnrolledList_remove(UnrolledList *list, int index)
+{
+	int offset = 0;
+	check(index >= 0 && index < list->count,
+			"UnrolledList size is %d.  Index %d out of bounds.",
+			list->count, index);
+
+	UnrolledNode *node = UnrolledList_locate(list, index, &offset);
+	void *value = node->values[offset];
+	memmove(node->values + offset, node->values + offset + 1,
+			(node->count - offset - 1) * sizeof(void *));
+	node->count--;
+	list->count--;
+
+	UnrolledNode *next = node->next;
+	if(node->count == 0) {
+		UnrolledList_drop_node(list, node);
+	} else if(next != NULL && node->count + next->count <=
+			UNROLLED_NODE_VALUES / 2) {
+		// fold a sparse neighbour in, so nodes stay reasonably full
+		memcpy(node->values + node->count, next->values,
+				next->count * sizeof(void *));
+		node->count += next->count;
+		UnrolledList_drop_node(list, next);
+	}
+
+	return value;
+error:
+	return NULL;
+}
+
+
+/// push a new value onto the end of the list.
+void UnrolledList_push(UnrolledList *list, void *value)
+{
+	UnrolledNode *node = list->last;
+
+	if(node == NULL || node->count == UNROLLED_NODE_VALUES) {
+		node = UnrolledNode_create();
+		check_mem(node);
+		node->prev = list->last;
+		if(list->last == NULL) {
+			list->first = node;
+		} else {
+			list->last->next = node;
+		}
+		list->last = node;
+	}
+
+	node->values[node->count++] = value;
+	list->count++;
+
+error:
+	return;
+}
+
+
+/// remove and return the end of the list.
+void *UnrolledList_pop(UnrolledList *list)
+{
+	UnrolledNode *node = list->last;
+	if(node == NULL) {
+		return NULL;
+	}
+
+	void *value = node->values[--node->count];
+	list->count--;
+	if(node->count == 0) {
+		UnrolledList_drop_node(list, node);
+	}
+	return value;
+}
+
+
+/// push a new value onto the beginning of the list.
+void UnrolledList_unshift(UnrolledList *list, void *value)
+{
+	UnrolledNode *node = list->first;
+
+	if(node == NULL || node->count == UNROLLED_NODE_VALUES) {
+		node = UnrolledNode_create();
+		check_mem(node);
+		node->next = list->first;
+		if(list->first == NULL) {
+			list->last = node;
+		} else {
+			list->first->prev = node;
+		}
+		list->first = node;
+	}
+
+	memmove(node->values + 1, node->values, node->count * sizeof(void *));
+	node->values[0] = value;
+	node->count++;
+	list->count++;
+
+error:
+	return;
+}
+
+
+/// remove and return the beginning of the list.
+void *UnrolledList_shift(UnrolledList *list)
+{
+	return list->first != NULL ? UnrolledList_remove(list, 0) : NULL;
+}
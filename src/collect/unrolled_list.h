@@ -0,0 +1,110 @@
+/*
+ * Unrolled linked list.
+ * Copyright (C) 2014 Axel Magnuson <axelmagn@gmail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef collect_Unrolled_list_h
+#define collect_Unrolled_list_h
+
+#include <stdlib.h>
+
+// a full node fills two 64 byte cache lines exactly
+#define UNROLLED_NODE_VALUES 13
+#define UNROLLED_NODE_ALIGN 64
+
+/// A node of an UnrolledList, holding up to UNROLLED_NODE_VALUES values
+/// packed at the start of values.
+typedef struct UnrolledNode {
+	struct UnrolledNode *next;
+	struct UnrolledNode *prev;
+	int count;
+	void *values[UNROLLED_NODE_VALUES];
+} UnrolledNode;
+
+/// A doubly linked list that stores a small array of values per node.
+/**
+ * Packing values into cache line aligned nodes means a traversal touches
+ * one line per several values instead of one per value, and the link
+ * overhead is shared by the whole node.  A removal merges a node with the
+ * one after it once the two would only half fill a single node, so
+ * removals never leave long runs of nearly empty nodes behind.
+ */
+typedef struct UnrolledList {
+	int count;
+	UnrolledNode *first;
+	UnrolledNode *last;
+} UnrolledList;
+
+
+/// Allocate a new list from the heap.
+UnrolledList *UnrolledList_create();
+
+/// Free a list and its nodes, but not its values.
+void UnrolledList_destroy(UnrolledList *list);
+
+/// Free all values contained by the list.
+void UnrolledList_clear(UnrolledList *list);
+
+/// Free a list, its nodes, and any values it contains.
+void UnrolledList_clear_destroy(UnrolledList *list);
+
+
+#define UnrolledList_count(A) ((A)->count)
+#define UnrolledList_first(A) ((A)->first != NULL ? \
+		(A)->first->values[0] : NULL)
+#define UnrolledList_last(A) ((A)->last != NULL ? \
+		(A)->last->values[(A)->last->count - 1] : NULL)
+
+
+/// retrieve the value stored at an index, or NULL if it is out of bounds.
+void *UnrolledList_get(UnrolledList *list, int index);
+
+/// remove and return the value stored at an index.
+void *UnrolledList_remove(UnrolledList *list, int index);
+
+
+/// push a new value onto the end of the list.
+void UnrolledList_push(UnrolledList *list, void *value);
+
+/// remove and return the end of the list.
+void *UnrolledList_pop(UnrolledList *list);
+
+/// push a new value onto the beginning of the list.
+void UnrolledList_unshift(UnrolledList *list, void *value);
+
+/// remove and return the beginning of the list.
+void *UnrolledList_shift(UnrolledList *list);
+
+
+/// convenience for loop iterating across an unrolled list.
+/**
+ * UNROLLED_LIST_FOREACH expands to two nested loops, over the nodes and
+ * then over the values of each node, so break only leaves the inner one.
+ * @param L the list to iterate on.
+ * @param N the name to use for the pointer to the current node.
+ * @param I the name to use for the index of the value within N.
+ */
+#define UNROLLED_LIST_FOREACH(L, N, I) UnrolledNode *N = NULL;\
+	int I = 0;\
+	for(N = (L)->first; N != NULL; N = N->next)\
+		for(I = 0; I < N->count; I++)
+
+#endif
@@ -0,0 +1,140 @@
+#include <collect/chashmap.h>
+#include <collect/hashmap.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NUM_KEYS (1 << 16)
+#define OPS_PER_THREAD 2000000
+
+/// Throughput of CHashmap against a Hashmap behind one mutex, from 1 up to
+/// twice the core count threads, on a read heavy and a write heavy mix.
+
+typedef struct Bench {
+    CHashmap *cmap;
+    Hashmap *map;
+    pthread_mutex_t *lock;
+    int write_percent;
+    unsigned int seed;
+} Bench;
+
+static int int_compare(void *a, void *b)
+{
+    return (intptr_t)a == (intptr_t)b ? 0 : 1;
+}
+
+static uint64_t int_hash(void *key)
+{
+    uint64_t hash = (uintptr_t)key;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+static inline unsigned int next_random(unsigned int *state)
+{
+    *state = *state * 1103515245 + 12345;
+    return *state >> 8;
+}
+
+static void *bench_run(void *arg)
+{
+    Bench *bench = arg;
+    unsigned int state = bench->seed;
+    int i = 0;
+
+    for(i = 0; i < OPS_PER_THREAD; i++) {
+        unsigned int r = next_random(&state);
+        void *key = (void *)(intptr_t)(r % NUM_KEYS + 1);
+        int write = (int)((r >> 16) % 100) < bench->write_percent;
+
+        if(bench->cmap) {
+            if(write) {
+                CHashmap_set(bench->cmap, key, key);
+            } else {
+                CHashmap_get(bench->cmap, key);
+            }
+        } else {
+            pthread_mutex_lock(bench->lock);
+            if(write) {
+                Hashmap_set(bench->map, key, key);
+            } else {
+                Hashmap_get(bench->map, key);
+            }
+            pthread_mutex_unlock(bench->lock);
+        }
+    }
+    return NULL;
+}
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/// million operations per second over all threads
+static double run(int threads, int write_percent, int striped)
+{
+    pthread_t ids[threads];
+    Bench benches[threads];
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    CHashmap *cmap = NULL;
+    Hashmap *map = NULL;
+    intptr_t i = 0;
+
+    if(striped) {
+        cmap = CHashmap_create(int_compare, int_hash, 0);
+    } else {
+        map = Hashmap_create(int_compare, int_hash);
+    }
+    for(i = 1; i <= NUM_KEYS; i++) {
+        if(cmap) CHashmap_set(cmap, (void *)i, (void *)i);
+        else Hashmap_set(map, (void *)i, (void *)i);
+    }
+
+    double start = now();
+    for(i = 0; i < threads; i++) {
+        benches[i].cmap = cmap;
+        benches[i].map = map;
+        benches[i].lock = &lock;
+        benches[i].write_percent = write_percent;
+        benches[i].seed = (unsigned int)i * 7919 + 1;
+        pthread_create(&ids[i], NULL, bench_run, &benches[i]);
+    }
+    for(i = 0; i < threads; i++) {
+        pthread_join(ids[i], NULL);
+    }
+    double elapsed = now() - start;
+
+    if(cmap) CHashmap_destroy(cmap);
+    if(map) Hashmap_destroy(map);
+    return (double)threads * OPS_PER_THREAD / elapsed / 1e6;
+}
+
+int main()
+{
+    int mixes[] = {5, 50};
+    int max_threads = 2 * (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int m = 0;
+    int threads = 0;
+
+    if(max_threads < 2) max_threads = 2;
+
+    for(m = 0; m < 2; m++) {
+        printf("%d%% writes, %d keys (Mops/s)\n", mixes[m], NUM_KEYS);
+        printf("%8s %12s %12s\n", "threads", "CHashmap", "Hashmap+lock");
+        for(threads = 1; threads <= max_threads; threads *= 2) {
+            printf("%8d %12.2f %12.2f\n", threads,
+                    run(threads, mixes[m], 1),
+                    run(threads, mixes[m], 0));
+        }
+        printf("\n");
+    }
+
+    return 0;
+}
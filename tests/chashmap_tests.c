@@ -0,0 +1,239 @@
+#include "minunit.h"
+#include <collect/chashmap.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define NUM_KEYS 100000
+#define NUM_THREADS 4
+#define KEYS_PER_THREAD 20000
+
+CHashmap *map = NULL;
+char *test1 = "test data 1";
+char *test2 = "test data 2";
+char *test3 = "xest data 3";
+char *expect1 = "THE VALUE 1";
+char *expect2 = "THE VALUE 2";
+char *expect3 = "THE VALUE 3";
+
+// integer keys stored directly in the pointer
+static int int_compare(void *a, void *b)
+{
+    return (intptr_t)a == (intptr_t)b ? 0 : 1;
+}
+
+static uint64_t int_hash(void *key)
+{
+    uint64_t hash = (uintptr_t)key;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// only four hashes, so keys pile up in long collision clusters
+static uint64_t collide_hash(void *key)
+{
+    return ((uintptr_t)key & 3) + 1;
+}
+
+// a good 32 bit hash widened to 64, leaving the high half zero
+static uint64_t narrow_hash(void *key)
+{
+    return (uint32_t)int_hash(key);
+}
+
+char *test_create()
+{
+    map = CHashmap_create(NULL, NULL, 5);
+    mu_assert(map != NULL, "Failed to create map.");
+    mu_assert(map->stripe_count == 8, "Stripes not rounded to a power of two.");
+    mu_assert(CHashmap_count(map) == 0, "New map isn't empty.");
+
+    return NULL;
+}
+
+char *test_destroy()
+{
+    CHashmap_destroy(map);
+
+    return NULL;
+}
+
+char *test_get_set()
+{
+    mu_assert(CHashmap_set(map, test1, expect1) == 0, "Failed to set test1.");
+    mu_assert(CHashmap_get(map, test1) == expect1, "Wrong value for test1.");
+    mu_assert(CHashmap_set(map, test2, expect2) == 0, "Failed to set test2.");
+    mu_assert(CHashmap_get(map, test2) == expect2, "Wrong value for test2.");
+    mu_assert(CHashmap_set(map, test3, expect3) == 0, "Failed to set test3.");
+    mu_assert(CHashmap_get(map, test3) == expect3, "Wrong value for test3.");
+
+    // setting an existing key replaces its data
+    CHashmap_set(map, test3, expect1);
+    mu_assert(CHashmap_get(map, test3) == expect1, "Wrong replaced value.");
+    CHashmap_set(map, test3, expect3);
+    mu_assert(CHashmap_count(map) == 3, "Wrong count after replace.");
+
+    return NULL;
+}
+
+char *test_delete()
+{
+    mu_assert(CHashmap_delete(map, test1) == expect1, "Should get test1.");
+    mu_assert(CHashmap_get(map, test1) == NULL, "Should delete.");
+    mu_assert(CHashmap_delete(map, test1) == NULL, "Deleted twice.");
+    mu_assert(CHashmap_delete(map, test2) == expect2, "Should get test2.");
+    mu_assert(CHashmap_delete(map, test3) == expect3, "Should get test3.");
+    mu_assert(CHashmap_count(map) == 0, "Map should be empty.");
+
+    return NULL;
+}
+
+char *test_many()
+{
+    intptr_t i = 0;
+    CHashmap *big = CHashmap_create(int_compare, int_hash, 0);
+    mu_assert(big->stripe_count == CHASHMAP_DEFAULT_STRIPES,
+            "Wrong default stripes.");
+
+    for(i = 1; i <= NUM_KEYS; i++) {
+        mu_assert(CHashmap_set(big, (void *)i, (void *)(i * 3)) == 0,
+                "Set failed.");
+    }
+    mu_assert(CHashmap_count(big) == NUM_KEYS, "Wrong count.");
+
+    for(i = 1; i <= NUM_KEYS; i += 2) {
+        mu_assert(CHashmap_delete(big, (void *)i) == (void *)(i * 3),
+                "Bad delete.");
+    }
+    for(i = 1; i <= NUM_KEYS; i++) {
+        void *expect = i % 2 ? NULL : (void *)(i * 3);
+        mu_assert(CHashmap_get(big, (void *)i) == expect, "Bad lookup.");
+    }
+    mu_assert(CHashmap_count(big) == NUM_KEYS / 2, "Wrong count after delete.");
+
+    CHashmap_destroy(big);
+    return NULL;
+}
+
+char *test_collisions()
+{
+    intptr_t i = 0;
+    CHashmap *bad = CHashmap_create(int_compare, collide_hash, 4);
+
+    for(i = 1; i <= 200; i++) {
+        CHashmap_set(bad, (void *)i, (void *)i);
+    }
+    // deleting from the middle of the cluster must shift the rest back
+    for(i = 1; i <= 200; i += 3) {
+        mu_assert(CHashmap_delete(bad, (void *)i) == (void *)i,
+                "Bad colliding delete.");
+    }
+    for(i = 1; i <= 200; i++) {
+        void *expect = (i - 1) % 3 ? (void *)i : NULL;
+        mu_assert(CHashmap_get(bad, (void *)i) == expect,
+                "Lookup failed across a collision cluster.");
+    }
+
+    CHashmap_destroy(bad);
+    return NULL;
+}
+
+char *test_narrow_hash()
+{
+    intptr_t i = 0;
+    int used = 0;
+    CHashmap *narrow = CHashmap_create(int_compare, narrow_hash, 16);
+
+    for(i = 1; i <= 1000; i++) {
+        CHashmap_set(narrow, (void *)i, (void *)i);
+    }
+    // writers only contend within a stripe, so keys must spread over all
+    for(i = 0; i < narrow->stripe_count; i++) {
+        used += narrow->stripes[i].count > 0;
+    }
+    mu_assert(used == narrow->stripe_count,
+            "32 bit hashes should still use every stripe.");
+
+    CHashmap_destroy(narrow);
+    return NULL;
+}
+
+
+typedef struct Worker {
+    CHashmap *map;
+    intptr_t first;
+    int errors;
+} Worker;
+
+static void *worker_run(void *arg)
+{
+    Worker *worker = arg;
+    intptr_t i = 0;
+    intptr_t end = worker->first + KEYS_PER_THREAD;
+
+    for(i = worker->first; i < end; i++) {
+        CHashmap_set(worker->map, (void *)i, (void *)(i + 1));
+        // a key written by another thread is either missing or correct
+        intptr_t other = (i + KEYS_PER_THREAD) %
+            (NUM_THREADS * KEYS_PER_THREAD) + 1;
+        void *seen = CHashmap_get(worker->map, (void *)other);
+        if(seen != NULL && seen != (void *)(other + 1)) {
+            worker->errors++;
+        }
+        if(i % 4 == 0) {
+            CHashmap_delete(worker->map, (void *)i);
+        }
+    }
+    return NULL;
+}
+
+char *test_threads()
+{
+    pthread_t threads[NUM_THREADS];
+    Worker workers[NUM_THREADS];
+    intptr_t i = 0;
+    // few stripes, so the threads really do share them
+    CHashmap *shared = CHashmap_create(int_compare, int_hash, 2);
+
+    for(i = 0; i < NUM_THREADS; i++) {
+        workers[i].map = shared;
+        workers[i].first = i * KEYS_PER_THREAD + 1;
+        workers[i].errors = 0;
+        pthread_create(&threads[i], NULL, worker_run, &workers[i]);
+    }
+    for(i = 0; i < NUM_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        mu_assert(workers[i].errors == 0, "Reader saw a torn value.");
+    }
+
+    for(i = 1; i <= NUM_THREADS * KEYS_PER_THREAD; i++) {
+        void *expect = i % 4 == 0 ? NULL : (void *)(i + 1);
+        mu_assert(CHashmap_get(shared, (void *)i) == expect,
+                "Wrong value after concurrent writes.");
+    }
+    mu_assert(CHashmap_count(shared) ==
+            NUM_THREADS * KEYS_PER_THREAD - NUM_THREADS * KEYS_PER_THREAD / 4,
+            "Wrong count after concurrent writes.");
+
+    CHashmap_destroy(shared);
+    return NULL;
+}
+
+char *all_tests()
+{
+    mu_suite_start();
+
+    mu_run_test(test_create);
+    mu_run_test(test_get_set);
+    mu_run_test(test_delete);
+    mu_run_test(test_destroy);
+    mu_run_test(test_many);
+    mu_run_test(test_collisions);
+    mu_run_test(test_narrow_hash);
+    mu_run_test(test_threads);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests);
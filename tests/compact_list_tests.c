@@ -0,0 +1,135 @@
+#include "minunit.h"
+#include <collect/compact_list.h>
+#include <string.h>
+
+#define NUM_VALUES 2000
+#define NUM_OPS 50000
+#define SEED 42
+
+static CompactList *list = NULL;
+char *test1 = "test1 data";
+char *test2 = "test2 data";
+char *test3 = "test3 data";
+
+
+char *test_create()
+{
+	list = CompactList_create(0);
+	mu_assert(list != NULL, "Failed to create list.");
+	mu_assert(list->capacity == COMPACT_LIST_MIN_CAPACITY,
+			"Wrong initial capacity.");
+	mu_assert(sizeof(CompactNode) == 2 * sizeof(void *),
+			"Nodes should be two words.");
+	mu_assert(CompactList_reserve(list,
+				(uint32_t)COMPACT_LIST_MAX_NODES + 1) == -1,
+			"Reserve past what count can index should fail.");
+
+	return NULL;
+}
+
+
+char *test_destroy()
+{
+	CompactList_destroy(list);
+
+	return NULL;
+}
+
+
+char *test_push_pop()
+{
+	uint32_t second = CompactList_push(list, test2);
+	CompactList_push(list, test3);
+	CompactList_unshift(list, test1);
+	mu_assert(CompactList_first(list) == test1, "Wrong first value.");
+	mu_assert(CompactList_last(list) == test3, "Wrong last value.");
+	mu_assert(CompactList_get(list, 1) == test2, "Wrong value at index 1.");
+	mu_assert(CompactList_get_node(list, 1) == second, "Wrong node index.");
+	mu_assert(CompactList_get(list, 3) == NULL, "Out of bounds get.");
+
+	mu_assert(CompactList_remove(list, second) == test2,
+			"Wrong removed value.");
+	// the freed slot is reused before the array grows
+	mu_assert(CompactList_push(list, test2) == second,
+			"Freed node was not reused.");
+	mu_assert(CompactList_pop(list) == test2, "Wrong value on pop.");
+	mu_assert(CompactList_shift(list) == test1, "Wrong value on shift.");
+	mu_assert(CompactList_shift(list) == test3, "Wrong value on shift.");
+	mu_assert(CompactList_shift(list) == NULL, "Shift from empty list.");
+	mu_assert(CompactList_count(list) == 0, "Wrong count after removal.");
+
+	return NULL;
+}
+
+
+char *test_random_ops()
+{
+	static int values[NUM_VALUES];
+	static int shadow[NUM_VALUES];
+	int count = 0;
+	int i;
+	CompactList *compact = CompactList_create(0);
+
+	for(i = 0; i < NUM_VALUES; i++) {
+		values[i] = i;
+	}
+
+	srand(SEED);
+	for(i = 0; i < NUM_OPS; i++) {
+		int op = rand() % 5;
+		int v = rand() % NUM_VALUES;
+		int at = count > 0 ? rand() % count : 0;
+		if(op == 0 && count < NUM_VALUES) {
+			CompactList_push(compact, &values[v]);
+			shadow[count++] = v;
+		} else if(op == 1 && count < NUM_VALUES) {
+			CompactList_unshift(compact, &values[v]);
+			memmove(shadow + 1, shadow, count * sizeof(int));
+			shadow[0] = v;
+			count++;
+		} else if(op == 2 && count > 0) {
+			mu_assert(CompactList_pop(compact) == &values[shadow[--count]],
+					"Wrong value on pop.");
+		} else if(op == 3 && count > 0) {
+			uint32_t node = CompactList_get_node(compact, at);
+			mu_assert(CompactList_remove(compact, node) == &values[shadow[at]],
+					"Wrong removed value.");
+			memmove(shadow + at, shadow + at + 1,
+					(count - at - 1) * sizeof(int));
+			count--;
+		} else if(count > 0) {
+			mu_assert(CompactList_get(compact, at) == &values[shadow[at]],
+					"Wrong value by index.");
+		}
+	}
+
+	mu_assert(CompactList_count(compact) == count, "Wrong count.");
+	mu_assert(compact->used <= NUM_VALUES, "Freed nodes were not reused.");
+	i = 0;
+	COMPACT_LIST_FOREACH(compact, first, next, cur) {
+		mu_assert(CompactList_value(compact, cur) == &values[shadow[i++]],
+				"Wrong value while iterating.");
+	}
+	mu_assert(i == count, "Iteration missed values.");
+	COMPACT_LIST_FOREACH(compact, last, prev, back) {
+		mu_assert(CompactList_value(compact, back) == &values[shadow[--i]],
+				"Wrong value iterating backwards.");
+	}
+
+	CompactList_destroy(compact);
+	return NULL;
+}
+
+
+char *all_tests() {
+	mu_suite_start();
+
+	mu_run_test(test_create);
+	mu_run_test(test_push_pop);
+	mu_run_test(test_destroy);
+	mu_run_test(test_random_ops);
+
+	return NULL;
+}
+
+RUN_TESTS(all_tests);
@@ -0,0 +1,314 @@
+#include "minunit.h"
+#include <collect/darray_algos.h>
+#include <time.h>
+
+#define NUM_VALUES 100
+#define LARGE_NUM_VALUES 200000
+#define SEED 42
+
+static TaskPool *pool = NULL;
+
+int intcmp(int *a, int *b)
+{
+    return *a < *b ? -1 : *a > *b;
+}
+
+typedef struct Record {
+    int key;
+    char pad[20];
+} Record;
+
+int recordcmp(Record *a, Record *b)
+{
+    return a->key < b->key ? -1 : a->key > b->key;
+}
+
+DArray *create_words()
+{
+    DArray *result = DArray_create(0, 5);
+    char *words[] = {"asdfasfd", "werwar", "13234", "asdfasfd", "oioj"};
+    int i = 0;
+
+    for(i = 0; i < 5; i++) {
+        DArray_push(result, words[i]);
+    }
+
+    return result;
+}
+
+DArray *create_nums(int count, int inline_storage)
+{
+    DArray *result = inline_storage ?
+        DArray_create_inline(sizeof(int), count) :
+        DArray_create(sizeof(int), count);
+    int i = 0;
+
+    for(i = 0; i < count; i++) {
+        int n = rand() % (count / 2 + 1);
+        if(inline_storage) {
+            DArray_push(result, &n);
+        } else {
+            int *el = DArray_new(result);
+            *el = n;
+            DArray_push(result, el);
+        }
+    }
+
+    return result;
+}
+
+int is_sorted(DArray *array, List_compare cmp)
+{
+    int i = 0;
+
+    for(i = 0; i < DArray_count(array) - 1; i++) {
+        if(cmp(DArray_get(array, i), DArray_get(array, i + 1)) > 0) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+long checksum(DArray *array)
+{
+    long sum = 0;
+    int i = 0;
+    for(i = 0; i < DArray_count(array); i++) {
+        sum += *(int *)DArray_get(array, i);
+    }
+    return sum;
+}
+
+char *test_sort_words()
+{
+    DArray *words = create_words();
+    mu_assert(!is_sorted(words, (List_compare)strcmp),
+            "Words should start not sorted.");
+
+    mu_assert(DArray_sort(words, (List_compare)strcmp) == 0, "Sort failed.");
+    mu_assert(is_sorted(words, (List_compare)strcmp), "Words not sorted.");
+
+    DArray_destroy(words);
+    return NULL;
+}
+
+char *test_sort_nums()
+{
+    int inline_storage = 0;
+    for(inline_storage = 0; inline_storage < 2; inline_storage++) {
+        DArray *nums = create_nums(NUM_VALUES, inline_storage);
+        long sum = checksum(nums);
+        mu_assert(DArray_sort(nums, (List_compare)intcmp) == 0,
+                "Sort failed.");
+        mu_assert(is_sorted(nums, (List_compare)intcmp), "Not sorted.");
+        mu_assert(checksum(nums) == sum, "Sort lost elements.");
+        DArray_clear_destroy(nums);
+    }
+
+    return NULL;
+}
+
+char *test_parallel_sort()
+{
+    int inline_storage = 0;
+    for(inline_storage = 0; inline_storage < 2; inline_storage++) {
+        DArray *nums = create_nums(LARGE_NUM_VALUES, inline_storage);
+        long sum = checksum(nums);
+        int rc = DArray_parallel_sort_on(nums, (List_compare)intcmp, pool);
+        mu_assert(rc == 0, "Parallel sort failed.");
+        mu_assert(is_sorted(nums, (List_compare)intcmp), "Not sorted.");
+        mu_assert(checksum(nums) == sum, "Parallel sort lost elements.");
+
+        // sorted and all-equal inputs shouldn't trip up the buckets
+        rc = DArray_parallel_sort(nums, (List_compare)intcmp);
+        mu_assert(rc == 0 && is_sorted(nums, (List_compare)intcmp),
+                "Sorting a sorted array failed.");
+        int i = 0;
+        for(i = 0; i < DArray_count(nums); i++) {
+            *(int *)DArray_get(nums, i) = 7;
+        }
+        rc = DArray_parallel_sort_on(nums, (List_compare)intcmp, pool);
+        mu_assert(rc == 0 && is_sorted(nums, (List_compare)intcmp),
+                "Sorting equal keys failed.");
+        DArray_clear_destroy(nums);
+    }
+
+    // wide inline records move as whole slots
+    DArray *records = DArray_create_inline(sizeof(Record), 16);
+    int i = 0;
+    for(i = 0; i < LARGE_NUM_VALUES; i++) {
+        Record r;
+        r.key = rand();
+        memset(r.pad, r.key & 0xff, sizeof(r.pad));
+        DArray_push(records, &r);
+    }
+    mu_assert(DArray_parallel_sort_on(records, (List_compare)recordcmp,
+                pool) == 0, "Parallel sort of records failed.");
+    mu_assert(is_sorted(records, (List_compare)recordcmp),
+            "Records not sorted.");
+    for(i = 0; i < DArray_count(records); i++) {
+        Record *r = DArray_get(records, i);
+        mu_assert(r->pad[19] == (char)(r->key & 0xff), "Record torn.");
+    }
+    DArray_destroy(records);
+
+    return NULL;
+}
+
+static long compares = 0;
+
+int counting_intcmp(int *a, int *b)
+{
+    __atomic_add_fetch(&compares, 1, __ATOMIC_RELAXED);
+    return intcmp(a, b);
+}
+
+char *test_parallel_sort_few_keys()
+{
+    int ranges[] = { 1, 3, 10 };
+    int r = 0;
+    int i = 0;
+
+    for(r = 0; r < 3; r++) {
+        DArray *nums = DArray_create_inline(sizeof(int), LARGE_NUM_VALUES);
+        for(i = 0; i < LARGE_NUM_VALUES; i++) {
+            int n = rand() % ranges[r];
+            DArray_push(nums, &n);
+        }
+        long sum = checksum(nums);
+
+        // every key is common enough to get an equality bucket, so past
+        // the sample each element costs a bucket search and one equality
+        // check.  Sorting any bucket again would cost log2(n) per element.
+        compares = 0;
+        int rc = DArray_parallel_sort_on(nums,
+                (List_compare)counting_intcmp, pool);
+        mu_assert(rc == 0, "Parallel sort failed.");
+        mu_assert(is_sorted(nums, (List_compare)intcmp), "Not sorted.");
+        mu_assert(checksum(nums) == sum, "Parallel sort lost elements.");
+        mu_assert(compares < 7L * LARGE_NUM_VALUES,
+                "Repeated keys piled into buckets that needed sorting.");
+
+        DArray_destroy(nums);
+    }
+
+    return NULL;
+}
+
+char *test_merge_sort()
+{
+    int inline_storage = 0;
+    int rc = 0;
+    for(inline_storage = 0; inline_storage < 2; inline_storage++) {
+        DArray *nums = create_nums(LARGE_NUM_VALUES, inline_storage);
+        long sum = checksum(nums);
+        rc = DArray_merge_sort_on(nums, (List_compare)intcmp, pool);
+        mu_assert(rc == 0, "Merge sort failed.");
+        mu_assert(is_sorted(nums, (List_compare)intcmp), "Not sorted.");
+        mu_assert(checksum(nums) == sum, "Merge sort lost elements.");
+        DArray_clear_destroy(nums);
+
+        nums = create_nums(NUM_VALUES, inline_storage);
+        rc = DArray_merge_sort(nums, (List_compare)intcmp);
+        mu_assert(rc == 0 && is_sorted(nums, (List_compare)intcmp),
+                "Small merge sort failed.");
+        DArray_clear_destroy(nums);
+    }
+
+    // few distinct keys, with the original position stored in the padding,
+    // so equal keys must come out in their original order
+    DArray *records = DArray_create_inline(sizeof(Record), 16);
+    int i = 0;
+    for(i = 0; i < LARGE_NUM_VALUES; i++) {
+        Record r;
+        r.key = rand() % 10;
+        memcpy(r.pad, &i, sizeof(i));
+        DArray_push(records, &r);
+    }
+    rc = DArray_merge_sort_on(records, (List_compare)recordcmp, pool);
+    mu_assert(rc == 0, "Merge sort of records failed.");
+    for(i = 1; i < DArray_count(records); i++) {
+        Record *prev = DArray_get(records, i - 1);
+        Record *cur = DArray_get(records, i);
+        int prev_at = 0;
+        int cur_at = 0;
+        memcpy(&prev_at, prev->pad, sizeof(int));
+        memcpy(&cur_at, cur->pad, sizeof(int));
+        mu_assert(prev->key < cur->key ||
+                (prev->key == cur->key && prev_at < cur_at),
+                "Merge sort is not stable.");
+    }
+    DArray_destroy(records);
+
+    return NULL;
+}
+
+DARRAY_DEFINE_SORT(sort_ints, int, (a > b) - (a < b))
+DARRAY_DEFINE_SORT(sort_int_ptrs, int *, (*a > *b) - (*a < *b))
+DARRAY_DEFINE_SORT(sort_strings, char *, strcmp(a, b))
+DARRAY_DEFINE_SORT(sort_records, Record, (a.key > b.key) - (a.key < b.key))
+
+char *test_defined_sort()
+{
+    DArray *nums = create_nums(LARGE_NUM_VALUES, 1);
+    long sum = checksum(nums);
+    mu_assert(sort_ints(nums) == 0, "Generated sort failed.");
+    mu_assert(is_sorted(nums, (List_compare)intcmp), "Not sorted.");
+    mu_assert(checksum(nums) == sum, "Generated sort lost elements.");
+    // a sorted array is the worst case for a bad pivot
+    mu_assert(sort_ints(nums) == 0 && is_sorted(nums,
+                (List_compare)intcmp), "Sorting a sorted array failed.");
+
+    // the slot width has to match the type
+    mu_assert(sort_records(nums) == -1, "Width mismatch not caught.");
+    DArray_destroy(nums);
+
+    nums = create_nums(NUM_VALUES, 0);
+    mu_assert(sort_int_ptrs(nums) == 0, "Generated sort failed.");
+    mu_assert(is_sorted(nums, (List_compare)intcmp), "Not sorted.");
+    DArray_clear_destroy(nums);
+
+    DArray *words = create_words();
+    mu_assert(sort_strings(words) == 0, "Generated sort failed.");
+    mu_assert(is_sorted(words, (List_compare)strcmp), "Words not sorted.");
+    DArray_destroy(words);
+
+    DArray *records = DArray_create_inline(sizeof(Record), 16);
+    int i = 0;
+    for(i = 0; i < NUM_VALUES * 10; i++) {
+        Record r;
+        r.key = rand();
+        memset(r.pad, r.key & 0xff, sizeof(r.pad));
+        DArray_push(records, &r);
+    }
+    mu_assert(sort_records(records) == 0, "Generated sort failed.");
+    mu_assert(is_sorted(records, (List_compare)recordcmp),
+            "Records not sorted.");
+    for(i = 0; i < DArray_count(records); i++) {
+        Record *r = DArray_get(records, i);
+        mu_assert(r->pad[19] == (char)(r->key & 0xff), "Record torn.");
+    }
+    DArray_destroy(records);
+
+    return NULL;
+}
+
+char *all_tests()
+{
+    mu_suite_start();
+    srand(SEED);
+    pool = TaskPool_create(4);
+
+    mu_run_test(test_sort_words);
+    mu_run_test(test_sort_nums);
+    mu_run_test(test_parallel_sort);
+    mu_run_test(test_parallel_sort_few_keys);
+    mu_run_test(test_merge_sort);
+    mu_run_test(test_defined_sort);
+
+    TaskPool_destroy(pool);
+    return NULL;
+}
+
+RUN_TESTS(all_tests);
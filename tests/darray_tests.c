@@ -0,0 +1,176 @@
+#include "minunit.h"
+#include <collect/darray.h>
+
+static DArray *array = NULL;
+static int *val1 = NULL;
+static int *val2 = NULL;
+
+char *test_create()
+{
+    array = DArray_create(sizeof(int), 100);
+    mu_assert(array != NULL, "DArray_create failed.");
+    mu_assert(array->contents != NULL, "contents are wrong in darray");
+    mu_assert(array->end == 0, "end isn't at the right spot");
+    mu_assert(array->element_size == sizeof(int), "element size is wrong.");
+    mu_assert(array->max == 100, "wrong max length on initial size");
+    mu_assert(!DArray_is_inline(array), "DArray_create should store pointers.");
+
+    return NULL;
+}
+
+char *test_destroy()
+{
+    DArray_destroy(array);
+
+    return NULL;
+}
+
+char *test_new()
+{
+    val1 = DArray_new(array);
+    mu_assert(val1 != NULL, "failed to make a new element");
+
+    val2 = DArray_new(array);
+    mu_assert(val2 != NULL, "failed to make a new element");
+
+    return NULL;
+}
+
+char *test_set()
+{
+    DArray_set(array, 0, val1);
+    DArray_set(array, 1, val2);
+
+    return NULL;
+}
+
+char *test_get()
+{
+    mu_assert(DArray_get(array, 0) == val1, "Wrong first value.");
+    mu_assert(DArray_get(array, 1) == val2, "Wrong second value.");
+
+    return NULL;
+}
+
+char *test_remove()
+{
+    int *val_check = DArray_remove(array, 0);
+    mu_assert(val_check != NULL, "Should not get NULL.");
+    mu_assert(*val_check == *val1, "Should get the first value.");
+    mu_assert(DArray_get(array, 0) == NULL, "Should be gone.");
+    DArray_free(val_check);
+
+    val_check = DArray_remove(array, 1);
+    mu_assert(val_check != NULL, "Should not get NULL.");
+    mu_assert(*val_check == *val2, "Should get the first value.");
+    mu_assert(DArray_get(array, 1) == NULL, "Should be gone.");
+    DArray_free(val_check);
+
+    return NULL;
+}
+
+char *test_expand_contract()
+{
+    int old_max = array->max;
+    DArray_expand(array);
+    mu_assert((unsigned int)array->max == old_max +
+            old_max * array->expand_rate / 100, "Wrong size after expand.");
+
+    // still over a quarter full, so no shrinking
+    array->end = array->max / 2;
+    DArray_contract(array);
+    mu_assert((unsigned int)array->max == old_max +
+            old_max * array->expand_rate / 100, "Contract shrank too early.");
+
+    array->end = 10;
+    DArray_contract(array);
+    mu_assert(array->max == 100, "Should stay at the initial max.");
+
+    array->end = 0;
+    return NULL;
+}
+
+char *test_push_pop()
+{
+    int i = 0;
+    for(i = 0; i < 1000; i++) {
+        int *val = DArray_new(array);
+        *val = i * 333;
+        DArray_push(array, val);
+    }
+
+    mu_assert(array->max >= 1000, "Wrong max size.");
+    // geometric growth means only a handful of expansions
+    mu_assert(array->max < 2000, "Grew more than doubling would allow.");
+
+    for(i = 999; i >= 0; i--) {
+        int *val = DArray_pop(array);
+        mu_assert(val != NULL, "Shouldn't get a NULL.");
+        mu_assert(*val == i * 333, "Wrong value.");
+        DArray_free(val);
+    }
+
+    DArray_contract(array);
+    mu_assert(array->max == 100, "Should contract back to the initial max.");
+
+    return NULL;
+}
+
+char *test_inline()
+{
+    DArray *nums = DArray_create_inline(sizeof(long), 4);
+    mu_assert(nums != NULL, "DArray_create_inline failed.");
+    mu_assert(DArray_is_inline(nums), "Array should be inline.");
+
+    long i = 0;
+    for(i = 0; i < 1000; i++) {
+        mu_assert(DArray_push(nums, &i) == 0, "Inline push failed.");
+    }
+    mu_assert(DArray_count(nums) == 1000, "Wrong count.");
+
+    // values sit next to each other in memory
+    long *base = DArray_first(nums);
+    for(i = 0; i < 1000; i++) {
+        mu_assert(base[i] == i, "Wrong inline value.");
+        mu_assert(DArray_get(nums, i) == &base[i], "Slots not contiguous.");
+    }
+
+    long v = 42;
+    DArray_set(nums, 10, &v);
+    mu_assert(*(long *)DArray_get(nums, 10) == 42, "Wrong value after set.");
+
+    mu_assert(*(long *)DArray_pop(nums) == 999, "Wrong value on pop.");
+    mu_assert(*(long *)DArray_last(nums) == 998, "Wrong last value.");
+
+    while(DArray_count(nums) > 100) {
+        DArray_pop(nums);
+    }
+    DArray_contract(nums);
+    mu_assert(nums->max == 200, "Should contract to twice the count.");
+    mu_assert(*(long *)DArray_last(nums) == 99, "Contract lost values.");
+
+    mu_assert(DArray_reserve(nums, 5000) == 0, "Reserve failed.");
+    mu_assert(nums->max == 5000, "Reserve didn't grow the array.");
+
+    DArray_clear_destroy(nums);
+    return NULL;
+}
+
+char *all_tests()
+{
+    mu_suite_start();
+
+    mu_run_test(test_create);
+    mu_run_test(test_new);
+    mu_run_test(test_set);
+    mu_run_test(test_get);
+    mu_run_test(test_remove);
+    mu_run_test(test_expand_contract);
+    mu_run_test(test_push_pop);
+    mu_run_test(test_inline);
+    mu_run_test(test_destroy);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests);
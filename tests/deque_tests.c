@@ -0,0 +1,215 @@
+#include "minunit.h"
+#include <collect/deque.h>
+#include <stdint.h>
+
+#define NUM_OPS 50000
+#define SEED 42
+
+static Deque *deque = NULL;
+char *test1 = "test1 data";
+char *test2 = "test2 data";
+char *test3 = "test3 data";
+
+
+char *test_create()
+{
+	deque = Deque_create(0);
+	mu_assert(deque != NULL, "Failed to create deque.");
+	mu_assert(deque->capacity == DEQUE_MIN_CAPACITY, "Wrong capacity.");
+
+	Deque *big = Deque_create(100);
+	mu_assert(big->capacity == 128, "Capacity not a power of two.");
+	Deque_destroy(big);
+
+	return NULL;
+}
+
+
+char *test_push_pop()
+{
+	mu_assert(Deque_pop(deque) == NULL, "Empty deque should pop NULL.");
+	Deque_push(deque, test1);
+	mu_assert(Deque_last(deque) == test1, "Wrong last value.");
+	Deque_push(deque, test2);
+	Deque_push(deque, test3);
+	mu_assert(Deque_count(deque) == 3, "Wrong count on push.");
+
+	mu_assert(Deque_pop(deque) == test3, "Wrong value on pop.");
+	mu_assert(Deque_pop(deque) == test2, "Wrong value on pop.");
+	mu_assert(Deque_pop(deque) == test1, "Wrong value on pop.");
+	mu_assert(Deque_count(deque) == 0, "Wrong count after pop.");
+
+	return NULL;
+}
+
+
+char *test_unshift_shift()
+{
+	mu_assert(Deque_shift(deque) == NULL, "Empty deque should shift NULL.");
+	Deque_unshift(deque, test1);
+	Deque_unshift(deque, test2);
+	Deque_unshift(deque, test3);
+	mu_assert(Deque_first(deque) == test3, "Wrong first value.");
+	mu_assert(Deque_last(deque) == test1, "Wrong last value.");
+
+	mu_assert(Deque_shift(deque) == test3, "Wrong value on shift.");
+	mu_assert(Deque_shift(deque) == test2, "Wrong value on shift.");
+	mu_assert(Deque_shift(deque) == test1, "Wrong value on shift.");
+	mu_assert(Deque_count(deque) == 0, "Wrong count after shift.");
+
+	return NULL;
+}
+
+
+char *test_get_set()
+{
+	intptr_t i = 0;
+
+	// unshift half so the values wrap around the end of the buffer
+	for(i = 0; i < 50; i++) {
+		Deque_push(deque, (void *)(50 + i));
+		Deque_unshift(deque, (void *)(49 - i));
+	}
+	mu_assert(Deque_count(deque) == 100, "Wrong count.");
+
+	for(i = 0; i < 100; i++) {
+		mu_assert(Deque_get(deque, i) == (void *)i, "Wrong value on get.");
+	}
+	mu_assert(Deque_get(deque, 100) == NULL, "Get past the end.");
+	mu_assert(Deque_get(deque, -1) == NULL, "Get before the start.");
+
+	mu_assert(Deque_set(deque, 10, test1) == 0, "Set failed.");
+	mu_assert(Deque_get(deque, 10) == test1, "Wrong value after set.");
+	mu_assert(Deque_set(deque, 100, test1) == -1, "Set out of bounds.");
+	Deque_set(deque, 10, (void *)10);
+
+	int n = 0;
+	DEQUE_FOREACH(deque, j, value) {
+		mu_assert(value == (void *)(intptr_t)j, "Wrong value in foreach.");
+		n++;
+	}
+	mu_assert(n == 100, "Foreach missed values.");
+
+	return NULL;
+}
+
+
+char *test_batch()
+{
+	void *in[300];
+	void *out[300];
+	intptr_t i = 0;
+
+	// start from a wrapped layout, then grow across it in one batch
+	for(i = 0; i < 300; i++) {
+		in[i] = (void *)(100 + i);
+	}
+	mu_assert(Deque_push_batch(deque, in, 300) == 0, "Push batch failed.");
+	mu_assert(Deque_count(deque) == 400, "Wrong count after push batch.");
+	for(i = 0; i < 400; i++) {
+		mu_assert(Deque_get(deque, i) == (void *)i, "Batch out of order.");
+	}
+
+	mu_assert(Deque_copy_out(deque, 390, out, 20) == 10,
+			"Copy out should stop at the end.");
+	mu_assert(out[0] == (void *)390 && out[9] == (void *)399,
+			"Wrong values copied out.");
+	mu_assert(Deque_count(deque) == 400, "Copy out removed values.");
+
+	mu_assert(Deque_shift_batch(deque, out, 250) == 250,
+			"Wrong shift batch count.");
+	for(i = 0; i < 250; i++) {
+		mu_assert(out[i] == (void *)i, "Wrong value on shift batch.");
+	}
+	mu_assert(Deque_shift_batch(deque, out, 300) == 150,
+			"Shift batch should stop when empty.");
+	mu_assert(out[149] == (void *)399, "Wrong last value shifted.");
+	mu_assert(Deque_count(deque) == 0, "Deque should be empty.");
+
+	return NULL;
+}
+
+
+char *test_random_ops()
+{
+	// mirror every operation on a plain array that never wraps
+	static intptr_t model[2 * NUM_OPS + 1];
+	int lo = NUM_OPS;
+	int hi = NUM_OPS;
+	int i = 0;
+	intptr_t v = 0;
+
+	srand(SEED);
+	for(i = 0; i < NUM_OPS; i++) {
+		switch(rand() % 5) {
+		case 0:
+			v = rand();
+			Deque_push(deque, (void *)v);
+			model[hi++] = v;
+			break;
+		case 1:
+			v = rand();
+			Deque_unshift(deque, (void *)v);
+			model[--lo] = v;
+			break;
+		case 2:
+			if(hi > lo) {
+				mu_assert(Deque_pop(deque) == (void *)model[--hi],
+						"Pop disagrees with model.");
+			}
+			break;
+		case 3:
+			if(hi > lo) {
+				mu_assert(Deque_shift(deque) == (void *)model[lo++],
+						"Shift disagrees with model.");
+			}
+			break;
+		case 4:
+			if(hi > lo) {
+				int index = rand() % (hi - lo);
+				mu_assert(Deque_get(deque, index) ==
+						(void *)model[lo + index],
+						"Get disagrees with model.");
+			}
+			break;
+		}
+		mu_assert(Deque_count(deque) == hi - lo, "Count disagrees.");
+	}
+
+	Deque_destroy(deque);
+	return NULL;
+}
+
+
+char *test_clear()
+{
+	Deque *values = Deque_create(0);
+	int i = 0;
+	for(i = 0; i < 40; i++) {
+		Deque_unshift(values, malloc(16));
+	}
+	Deque_clear(values);
+	mu_assert(Deque_count(values) == 0, "Clear left values.");
+	Deque_push(values, malloc(16));
+	Deque_clear_destroy(values);
+
+	return NULL;
+}
+
+
+char *all_tests()
+{
+	mu_suite_start();
+
+	mu_run_test(test_create);
+	mu_run_test(test_push_pop);
+	mu_run_test(test_unshift_shift);
+	mu_run_test(test_get_set);
+	mu_run_test(test_batch);
+	mu_run_test(test_random_ops);
+	mu_run_test(test_clear);
+
+	return NULL;
+}
+
+RUN_TESTS(all_tests);
@@ -0,0 +1,207 @@
+#include "minunit.h"
+#include <collect/hashmap.h>
+#include <stdio.h>
+#include <string.h>
+
+#define NUM_KEYS 100000
+
+Hashmap *map = NULL;
+static int traverse_called = 0;
+char *test1 = "test data 1";
+char *test2 = "test data 2";
+char *test3 = "xest data 3";
+char *expect1 = "THE VALUE 1";
+char *expect2 = "THE VALUE 2";
+char *expect3 = "THE VALUE 3";
+
+static int traverse_good_cb(HashmapEntry *entry)
+{
+    debug("KEY: %s", (char *)entry->key);
+    traverse_called++;
+    return 0;
+}
+
+static int traverse_fail_cb(HashmapEntry *entry)
+{
+    debug("KEY: %s", (char *)entry->key);
+    traverse_called++;
+
+    if(traverse_called == 2) {
+        return 1;
+    } else {
+        return 0;
+    }
+}
+
+// every key lands in the same group, to exercise probing and tombstones
+static uint64_t collide_hash(void *key)
+{
+    return (uint64_t)(strlen(key) & 0x7f);
+}
+
+char *test_create()
+{
+    map = Hashmap_create(NULL, NULL);
+    mu_assert(map != NULL, "Failed to create map.");
+    mu_assert(Hashmap_capacity(map) == DEFAULT_NUMBER_OF_BUCKETS,
+            "Wrong initial capacity.");
+
+    return NULL;
+}
+
+char *test_destroy()
+{
+    Hashmap_destroy(map);
+
+    return NULL;
+}
+
+char *test_get_set()
+{
+    int rc = Hashmap_set(map, test1, expect1);
+    mu_assert(rc == 0, "Failed to set &test1");
+    char *result = Hashmap_get(map, test1);
+    mu_assert(result == expect1, "Wrong value for test1.");
+
+    rc = Hashmap_set(map, test2, expect2);
+    mu_assert(rc == 0, "Failed to set test2");
+    result = Hashmap_get(map, test2);
+    mu_assert(result == expect2, "Wrong value for test2.");
+
+    rc = Hashmap_set(map, test3, expect3);
+    mu_assert(rc == 0, "Failed to set test3");
+    result = Hashmap_get(map, test3);
+    mu_assert(result == expect3, "Wrong value for test3.");
+
+    // setting an existing key replaces its data
+    rc = Hashmap_set(map, test3, expect1);
+    mu_assert(rc == 0, "Failed to reset test3");
+    mu_assert(Hashmap_get(map, test3) == expect1, "Wrong replaced value.");
+    Hashmap_set(map, test3, expect3);
+    mu_assert(Hashmap_count(map) == 3, "Wrong count after replace.");
+
+    return NULL;
+}
+
+char *test_traverse()
+{
+    int rc = Hashmap_traverse(map, traverse_good_cb);
+    mu_assert(rc == 0, "Failed to traverse.");
+    mu_assert(traverse_called == 3, "Wrong count traverse.");
+
+    traverse_called = 0;
+    rc = Hashmap_traverse(map, traverse_fail_cb);
+    mu_assert(rc == 1, "Failed to traverse.");
+    mu_assert(traverse_called == 2, "Wrong count traverse for fail.");
+
+    return NULL;
+}
+
+char *test_delete()
+{
+    char *deleted = (char *)Hashmap_delete(map, test1);
+    mu_assert(deleted != NULL, "Got NULL on delete.");
+    mu_assert(deleted == expect1, "Should get test1");
+    char *result = Hashmap_get(map, test1);
+    mu_assert(result == NULL, "Should delete.");
+
+    deleted = (char *)Hashmap_delete(map, test2);
+    mu_assert(deleted != NULL, "Got NULL on delete.");
+    mu_assert(deleted == expect2, "Should get test2");
+    result = Hashmap_get(map, test2);
+    mu_assert(result == NULL, "Should delete.");
+
+    deleted = (char *)Hashmap_delete(map, test3);
+    mu_assert(deleted != NULL, "Got NULL on delete.");
+    mu_assert(deleted == expect3, "Should get test3");
+    result = Hashmap_get(map, test3);
+    mu_assert(result == NULL, "Should delete.");
+    mu_assert(Hashmap_count(map) == 0, "Map should be empty.");
+
+    return NULL;
+}
+
+char *test_many()
+{
+    static char keys[NUM_KEYS][16];
+    int i = 0;
+    Hashmap *big = Hashmap_create(NULL, NULL);
+
+    for(i = 0; i < NUM_KEYS; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "key%d", i);
+        mu_assert(Hashmap_set(big, keys[i], &keys[i]) == 0, "Set failed.");
+    }
+    mu_assert(Hashmap_count(big) == NUM_KEYS, "Wrong count.");
+    mu_assert(Hashmap_capacity(big) * 7 / 8 >= NUM_KEYS,
+            "Table over its load factor.");
+
+    // remove every other key, then check all of them
+    for(i = 0; i < NUM_KEYS; i += 2) {
+        mu_assert(Hashmap_delete(big, keys[i]) == &keys[i], "Bad delete.");
+    }
+    for(i = 0; i < NUM_KEYS; i++) {
+        void *expect = i % 2 ? &keys[i] : NULL;
+        mu_assert(Hashmap_get(big, keys[i]) == expect, "Bad lookup.");
+    }
+
+    // churn through tombstones without growing forever
+    size_t capacity = Hashmap_capacity(big);
+    int round = 0;
+    for(round = 0; round < 4; round++) {
+        for(i = 0; i < NUM_KEYS; i += 2) {
+            Hashmap_set(big, keys[i], &keys[i]);
+        }
+        for(i = 0; i < NUM_KEYS; i += 2) {
+            Hashmap_delete(big, keys[i]);
+        }
+    }
+    mu_assert(Hashmap_capacity(big) == capacity, "Churn grew the table.");
+    mu_assert(Hashmap_count(big) == NUM_KEYS / 2, "Wrong count after churn.");
+
+    Hashmap_destroy(big);
+    return NULL;
+}
+
+char *test_collisions_reserve()
+{
+    static char keys[200][12];
+    int i = 0;
+    Hashmap *bad = Hashmap_create(NULL, collide_hash);
+
+    mu_assert(Hashmap_reserve(bad, 1000) == 0, "Reserve failed.");
+    mu_assert(Hashmap_capacity(bad) == 2048, "Reserve picked wrong size.");
+
+    for(i = 0; i < 200; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "%03d", i);
+        Hashmap_set(bad, keys[i], &keys[i]);
+    }
+    mu_assert(Hashmap_capacity(bad) == 2048, "Reserved map grew.");
+    for(i = 0; i < 200; i += 3) {
+        Hashmap_delete(bad, keys[i]);
+    }
+    for(i = 0; i < 200; i++) {
+        void *expect = i % 3 ? &keys[i] : NULL;
+        mu_assert(Hashmap_get(bad, keys[i]) == expect,
+                "Lookup failed across colliding groups.");
+    }
+
+    Hashmap_destroy(bad);
+    return NULL;
+}
+
+char *all_tests()
+{
+    mu_suite_start();
+
+    mu_run_test(test_create);
+    mu_run_test(test_get_set);
+    mu_run_test(test_traverse);
+    mu_run_test(test_delete);
+    mu_run_test(test_destroy);
+    mu_run_test(test_many);
+    mu_run_test(test_collisions_reserve);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests);
@@ -0,0 +1,182 @@
+#include "minunit.h"
+#include <collect/heap.h>
+
+#define NUM_VALUES 1000
+
+static int values[NUM_VALUES];
+
+int intcmp(int *a, int *b)
+{
+    return *a < *b ? -1 : *a > *b;
+}
+
+/// pop everything, checking that values come out in ascending order
+static int drains_in_order(Heap *heap, int expected)
+{
+    int popped = 0;
+    int *prev = NULL;
+    int *cur = NULL;
+
+    while((cur = Heap_pop(heap)) != NULL) {
+        if(prev != NULL && *prev > *cur) {
+            return 0;
+        }
+        prev = cur;
+        popped++;
+    }
+    return popped == expected;
+}
+
+char *test_push_pop()
+{
+    int i = 0;
+    Heap *heap = Heap_create((List_compare)intcmp, 0);
+    mu_assert(heap != NULL, "Failed to create heap.");
+    mu_assert(heap->arity == HEAP_DEFAULT_ARITY, "Wrong default arity.");
+    mu_assert(Heap_pop(heap) == NULL, "Empty heap should pop NULL.");
+    mu_assert(Heap_peek(heap) == NULL, "Empty heap should peek NULL.");
+
+    for(i = 0; i < NUM_VALUES; i++) {
+        values[i] = rand() % 500;
+        mu_assert(Heap_push(heap, &values[i]) == i, "Wrong handle.");
+    }
+    mu_assert(Heap_count(heap) == NUM_VALUES, "Wrong count after push.");
+
+    int *min = Heap_peek(heap);
+    for(i = 0; i < NUM_VALUES; i++) {
+        mu_assert(*min <= values[i], "Peek isn't the minimum.");
+    }
+
+    mu_assert(drains_in_order(heap, NUM_VALUES), "Pops out of order.");
+    mu_assert(Heap_is_empty(heap), "Heap should be empty.");
+
+    Heap_destroy(heap);
+    return NULL;
+}
+
+char *test_arity()
+{
+    int arity = 0;
+    int i = 0;
+
+    for(arity = 2; arity <= 8; arity++) {
+        Heap *heap = Heap_create((List_compare)intcmp, arity);
+        for(i = 0; i < NUM_VALUES; i++) {
+            values[i] = rand() % 500;
+            Heap_push(heap, &values[i]);
+            // interleave pops so sifts run on heaps of every shape
+            if(i % 3 == 2) {
+                Heap_pop(heap);
+            }
+        }
+        mu_assert(drains_in_order(heap, NUM_VALUES - NUM_VALUES / 3),
+                "Pops out of order.");
+        Heap_destroy(heap);
+    }
+
+    return NULL;
+}
+
+char *test_create_from()
+{
+    int i = 0;
+    DArray *array = DArray_create(0, NUM_VALUES);
+    for(i = 0; i < NUM_VALUES; i++) {
+        values[i] = NUM_VALUES - i;
+        DArray_push(array, &values[i]);
+    }
+
+    Heap *heap = Heap_create_from((List_compare)intcmp, 3, array);
+    mu_assert(heap != NULL, "Failed to heapify.");
+    mu_assert(Heap_count(heap) == NUM_VALUES, "Wrong count after heapify.");
+    mu_assert(DArray_count(array) == NUM_VALUES, "Source array changed.");
+    mu_assert(*(int *)Heap_peek(heap) == 1, "Wrong minimum.");
+    mu_assert(Heap_value(heap, 10) == &values[10], "Wrong handle value.");
+
+    mu_assert(drains_in_order(heap, NUM_VALUES), "Pops out of order.");
+    Heap_destroy(heap);
+
+    DArray_clear(array);
+    heap = Heap_create_from((List_compare)intcmp, 0, array);
+    mu_assert(heap != NULL && Heap_is_empty(heap),
+            "Heapify an empty array.");
+    Heap_destroy(heap);
+
+    DArray_destroy(array);
+    return NULL;
+}
+
+char *test_handles()
+{
+    int i = 0;
+    int handles[NUM_VALUES];
+    Heap *heap = Heap_create((List_compare)intcmp, 4);
+
+    for(i = 0; i < NUM_VALUES; i++) {
+        values[i] = 1000 + i;
+        handles[i] = Heap_push(heap, &values[i]);
+    }
+
+    values[700] = 5;
+    mu_assert(Heap_decrease_key(heap, handles[700], NULL) == 0,
+            "Decrease key failed.");
+    mu_assert(Heap_peek(heap) == &values[700], "Decreased key isn't min.");
+
+    static int smaller = 1;
+    mu_assert(Heap_decrease_key(heap, handles[900], &smaller) == 0,
+            "Decrease key with a new value failed.");
+    mu_assert(Heap_peek(heap) == &smaller, "Replaced value isn't min.");
+    mu_assert(Heap_value(heap, handles[900]) == &smaller,
+            "Handle lost its value.");
+
+    values[0] = 5000;
+    mu_assert(Heap_update(heap, handles[0]) == 0, "Update failed.");
+
+    mu_assert(Heap_remove(heap, handles[500]) == &values[500],
+            "Remove returned the wrong value.");
+    mu_assert(!Heap_contains(heap, handles[500]), "Removed handle lingers.");
+    mu_assert(Heap_remove(heap, handles[500]) == NULL,
+            "Removed twice.");
+    mu_assert(Heap_decrease_key(heap, handles[500], NULL) == -1,
+            "Decrease key on a removed handle.");
+
+    // the freed handle is recycled
+    values[500] = 3;
+    mu_assert(Heap_push(heap, &values[500]) == handles[500],
+            "Handle wasn't recycled.");
+    mu_assert(Heap_pop(heap) == &smaller, "Wrong first pop.");
+    mu_assert(Heap_pop(heap) == &values[500], "Wrong second pop.");
+    mu_assert(Heap_pop(heap) == &values[700], "Wrong third pop.");
+    mu_assert(!Heap_contains(heap, handles[700]), "Popped handle lingers.");
+
+    int *prev = NULL;
+    int *cur = NULL;
+    while((cur = Heap_pop(heap)) != NULL) {
+        mu_assert(prev == NULL || *prev <= *cur, "Pops out of order.");
+        prev = cur;
+    }
+    mu_assert(prev == &values[0], "Updated key should come out last.");
+
+    Heap_push(heap, &values[1]);
+    Heap_clear(heap);
+    mu_assert(Heap_is_empty(heap), "Clear left values.");
+    mu_assert(!Heap_contains(heap, 0), "Clear left handles.");
+
+    Heap_destroy(heap);
+    return NULL;
+}
+
+char *all_tests()
+{
+    mu_suite_start();
+
+    srand(42);
+    mu_run_test(test_push_pop);
+    mu_run_test(test_arity);
+    mu_run_test(test_create_from);
+    mu_run_test(test_handles);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests);
@@ -0,0 +1,137 @@
+#include "minunit.h"
+#include <collect/intrusive_list.h>
+
+#define NUM_ITEMS 100000
+#define SEED 42
+
+typedef struct Item {
+	int key;
+	IListLink link;
+	int order;
+} Item;
+
+static IList *list = NULL;
+static Item items[3] = {{.key = 1}, {.key = 2}, {.key = 3}};
+
+
+static int item_compare(IListLink *lhs, IListLink *rhs)
+{
+	int l = IList_entry(lhs, Item, link)->key;
+	int r = IList_entry(rhs, Item, link)->key;
+	return l < r ? -1 : l > r;
+}
+
+/// keys ascend, equal keys keep their original order, and links agree
+static int is_sorted(IList *sorted)
+{
+	IListLink *prev = NULL;
+	int count = 0;
+	ILIST_FOREACH(sorted, first, next, cur) {
+		if(cur->prev != prev) {
+			return 0;
+		}
+		if(prev != NULL) {
+			Item *a = IList_entry(prev, Item, link);
+			Item *b = IList_entry(cur, Item, link);
+			if(a->key > b->key || (a->key == b->key && a->order > b->order)) {
+				return 0;
+			}
+		}
+		prev = cur;
+		count++;
+	}
+	return prev == sorted->last && count == sorted->count;
+}
+
+
+char *test_create()
+{
+	list = IList_create();
+	mu_assert(list != NULL, "Failed to create list.");
+	mu_assert(IList_count(list) == 0, "New list isn't empty.");
+
+	return NULL;
+}
+
+
+char *test_destroy()
+{
+	IList_destroy(list);
+
+	return NULL;
+}
+
+
+char *test_push_pop()
+{
+	IList_push(list, &items[1].link);
+	IList_push(list, &items[2].link);
+	IList_unshift(list, &items[0].link);
+	mu_assert(IList_entry(IList_first(list), Item, link) == &items[0],
+			"Wrong first item.");
+	mu_assert(IList_entry(IList_get(list, 1), Item, link) == &items[1],
+			"Wrong item at index 1.");
+	mu_assert(IList_get(list, 3) == NULL, "Out of bounds get.");
+
+	// removing while iterating is allowed
+	ILIST_FOREACH(list, first, next, cur) {
+		if(IList_entry(cur, Item, link)->key == 2) {
+			IList_remove(list, cur);
+		}
+	}
+	mu_assert(IList_count(list) == 2, "Wrong count after remove.");
+	mu_assert(IList_pop(list) == &items[2].link, "Wrong item on pop.");
+	mu_assert(IList_shift(list) == &items[0].link, "Wrong item on shift.");
+	mu_assert(IList_shift(list) == NULL, "Shift from empty list.");
+	mu_assert(list->first == NULL && list->last == NULL,
+			"Empty list has ends.");
+
+	return NULL;
+}
+
+
+char *test_sorts()
+{
+	Item *many = malloc(NUM_ITEMS * sizeof(Item));
+	IList sorted;
+	int i;
+
+	// both sorts, on few distinct keys to exercise stability
+	int (*sorts[])(IList *, IList_compare) = {IList_sort, IList_merge_sort};
+	int s;
+	for(s = 0; s < 2; s++) {
+		IList_init(&sorted);
+		srand(SEED);
+		for(i = 0; i < NUM_ITEMS; i++) {
+			many[i].key = rand() % 1000;
+			many[i].order = i;
+			IList_push(&sorted, &many[i].link);
+		}
+		mu_assert(sorts[s](&sorted, item_compare) == 0, "Sort failed.");
+		mu_assert(is_sorted(&sorted), "Items are not stably sorted.");
+		mu_assert(sorts[s](&sorted, NULL) == -1,
+				"Sort should reject a null comparator.");
+	}
+
+	IList_init(&sorted);
+	mu_assert(IList_merge_sort(&sorted, item_compare) == 0 &&
+			IList_sort(&sorted, item_compare) == 0,
+			"Sorting an empty list failed.");
+
+	free(many);
+	return NULL;
+}
+
+
+char *all_tests() {
+	mu_suite_start();
+
+	mu_run_test(test_create);
+	mu_run_test(test_push_pop);
+	mu_run_test(test_destroy);
+	mu_run_test(test_sorts);
+
+	return NULL;
+}
+
+RUN_TESTS(all_tests);
@@ -96,6 +96,163 @@ char *test_bubble_sort()
 	return NULL;
 }
 
+char *test_sort()
+{
+	List *words = create_words();
+
+	// should work on a list that needs sorting
+	int rc = List_sort(words, (List_compare)strcmp);
+	mu_assert(rc == 0, "List_sort failed.");
+	mu_assert(is_sorted(words), "Words are not sorted after List_sort.");
+	mu_assert(words->last->next == NULL && words->first->prev == NULL,
+			"List ends were not fixed up.");
+	mu_assert(words->last->prev->next == words->last,
+			"prev pointers were not fixed up.");
+
+	List_destroy(words);
+
+	// should work on an empty list
+	words = List_create();
+	rc = List_sort(words, (List_compare)strcmp);
+	mu_assert(rc == 0, "List_sort failed on empty list.");
+	mu_assert(is_sorted(words), "Words should be sorted if empty.");
+	List_destroy(words);
+
+	// equal keys keep their order, which is address order here
+	List *nums = create_large_numlist();
+	int *base = nums->first->value;
+	LIST_FOREACH(nums, first, next, cur) {
+		*(int *)cur->value %= 1000;
+	}
+	rc = List_sort(nums, (List_compare)numcmp);
+	mu_assert(rc == 0, "List_sort failed.");
+	mu_assert(is_numsorted(nums), "Numbers are not sorted after List_sort.");
+	ListNode *node = NULL;
+	for(node = nums->first; node->next != NULL; node = node->next) {
+		mu_assert(node->next->prev == node, "Broken prev pointer.");
+		if(numcmp(node->value, node->next->value) == 0) {
+			mu_assert((int *)node->value < (int *)node->next->value,
+					"List_sort is not stable.");
+		}
+	}
+	mu_assert(node == nums->last, "Wrong last after List_sort.");
+
+	free(base);
+	List_destroy(nums);
+	return NULL;
+}
+
+static int compares = 0;
+
+int counting_numcmp(int *l, int *r) {
+	compares++;
+	return numcmp(l, r);
+}
+
+int is_stable(List *nums)
+{
+	LIST_FOREACH(nums, first, next, cur) {
+		if(cur->next == NULL) {
+			continue;
+		}
+		if(cur->next->prev != cur) {
+			return 0;
+		}
+		if(numcmp(cur->value, cur->next->value) == 0 &&
+				(int *)cur->value > (int *)cur->next->value) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+char *test_tim_sort()
+{
+	int i;
+	List *words = create_words();
+	int rc = List_tim_sort(words, (List_compare)strcmp);
+	mu_assert(rc == 0, "List_tim_sort failed.");
+	mu_assert(is_sorted(words), "Words are not sorted after tim sort.");
+	List_destroy(words);
+
+	words = List_create();
+	rc = List_tim_sort(words, (List_compare)strcmp);
+	mu_assert(rc == 0, "List_tim_sort failed on empty list.");
+	List_destroy(words);
+
+	// random keys with many duplicates
+	List *nums = create_large_numlist();
+	int *base = nums->first->value;
+	for(i = 0; i < LARGE_NUM_VALUES; i++) {
+		base[i] %= 1000;
+	}
+	rc = List_tim_sort(nums, (List_compare)numcmp);
+	mu_assert(rc == 0, "List_tim_sort failed.");
+	mu_assert(is_numsorted(nums), "Numbers are not sorted after tim sort.");
+	mu_assert(is_stable(nums), "List_tim_sort is not stable.");
+	List_destroy(nums);
+
+	// nearly sorted: ascending with a few local swaps and a descending tail
+	nums = List_create();
+	for(i = 0; i < LARGE_NUM_VALUES; i++) {
+		base[i] = i < LARGE_NUM_VALUES - 1000 ? i : LARGE_NUM_VALUES - i;
+		if(i % 1000 == 999) {
+			base[i] = base[i - 1] - 1;
+		}
+		List_push(nums, &base[i]);
+	}
+	compares = 0;
+	rc = List_tim_sort(nums, (List_compare)counting_numcmp);
+	mu_assert(rc == 0, "List_tim_sort failed.");
+	mu_assert(is_numsorted(nums), "Nearly sorted list is not sorted.");
+	mu_assert(is_stable(nums), "List_tim_sort is not stable.");
+	mu_assert(compares < 3 * LARGE_NUM_VALUES, 
+			"Nearly sorted input should take close to n compares.");
+
+	// already sorted input is a single run
+	compares = 0;
+	rc = List_tim_sort(nums, (List_compare)counting_numcmp);
+	mu_assert(compares == LARGE_NUM_VALUES - 1, 
+			"Sorted input should take n - 1 compares.");
+	List_destroy(nums);
+
+	free(base);
+	return NULL;
+}
+
+LIST_DEFINE_SORT(sort_nums, int *, (*a > *b) - (*a < *b))
+LIST_DEFINE_SORT(sort_words, char *, strcmp(a, b))
+
+char *test_defined_sort()
+{
+	List *words = create_words();
+	int rc = sort_words(words);
+	mu_assert(rc == 0, "Generated sort failed.");
+	mu_assert(is_sorted(words), "Words are not sorted after sort_words.");
+	mu_assert(words->last->prev->next == words->last,
+			"prev pointers were not fixed up.");
+	List_destroy(words);
+
+	words = List_create();
+	mu_assert(sort_words(words) == 0, "Generated sort of empty list.");
+	List_destroy(words);
+
+	// same stability guarantee as List_sort
+	List *nums = create_large_numlist();
+	int *base = nums->first->value;
+	LIST_FOREACH(nums, first, next, cur) {
+		*(int *)cur->value %= 1000;
+	}
+	mu_assert(sort_nums(nums) == 0, "Generated sort failed.");
+	mu_assert(is_numsorted(nums), "Numbers are not sorted after sort_nums.");
+	mu_assert(is_stable(nums), "Generated sort is not stable.");
+	mu_assert(nums->last->next == NULL, "Wrong last after sort_nums.");
+
+	free(base);
+	List_destroy(nums);
+	return NULL;
+}
+
 char *test_merge_sort()
 {
 	List *words = create_words();
@@ -136,9 +293,11 @@ char *all_tests()
     mu_suite_start();
 
     mu_run_test(test_bubble_sort);
+    mu_run_test(test_sort);
+    mu_run_test(test_tim_sort);
+    mu_run_test(test_defined_sort);
     mu_run_test(test_merge_sort);
-    // we are going to take a break from this
-    // mu_run_test(test_large_merge_sort);
+    mu_run_test(test_large_merge_sort);
 
     return NULL;
 }
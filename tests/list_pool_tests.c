@@ -0,0 +1,186 @@
+#include "minunit.h"
+#include <collect/list.h>
+#include <collect/list_pool.h>
+#include <assert.h>
+
+#define NUM_NODES 10000
+
+char *test1 = "test1 data";
+char *test2 = "test2 data";
+
+
+char *test_alloc_free()
+{
+	ListNodePool *pool = ListNodePool_create(0);
+	mu_assert(pool != NULL, "Failed to create pool.");
+	mu_assert(pool->chunk_size == LIST_POOL_MIN_CHUNK,
+			"Chunk size should be rounded up to the minimum.");
+
+	ListNode *a = ListNodePool_alloc(pool);
+	ListNode *b = ListNodePool_alloc(pool);
+	mu_assert(a != NULL && b != NULL, "Failed to allocate nodes.");
+	mu_assert(a != b, "Pool handed out the same node twice.");
+	mu_assert(b == a + 1, "Nodes from one chunk should be contiguous.");
+
+	ListNodePool_free(pool, a);
+	ListNode *c = ListNodePool_alloc(pool);
+	mu_assert(c == a, "Freed node should be recycled first.");
+	mu_assert(c->next == NULL && c->prev == NULL && c->value == NULL,
+			"Recycled node should be zeroed.");
+
+	ListNodePool_release(pool);
+	return NULL;
+}
+
+
+char *test_chunk_growth()
+{
+	ListNodePool *pool = ListNodePool_create(LIST_POOL_MIN_CHUNK);
+	int i;
+	for(i = 0; i < NUM_NODES; i++) {
+		mu_assert(ListNodePool_alloc(pool) != NULL,
+				"Failed to allocate node.");
+	}
+
+	int chunks = 0;
+	int capacity = 0;
+	ListNodeChunk *chunk = NULL;
+	for(chunk = pool->chunks; chunk != NULL; chunk = chunk->next) {
+		chunks++;
+		capacity += chunk->capacity;
+		mu_assert(chunk->capacity <= LIST_POOL_MAX_CHUNK,
+				"Chunk exceeds the maximum size.");
+	}
+	mu_assert(capacity >= NUM_NODES, "Chunks can't hold every node.");
+	mu_assert(chunks < 16, "Chunks should grow geometrically.");
+
+	ListNodePool_release(pool);
+	return NULL;
+}
+
+
+char *test_list_recycles()
+{
+	List *list = List_create();
+	mu_assert(ListNodePool_is_private(list->pool),
+			"List_create should give the list a private pool.");
+
+	List_push(list, test1);
+	ListNode *node = list->first;
+	List_pop(list);
+	List_unshift(list, test2);
+	mu_assert(list->first == node, "Popped node was not reused.");
+	mu_assert(List_first(list) == test2, "Wrong value in reused node.");
+
+	int i;
+	for(i = 0; i < NUM_NODES; i++) {
+		List_push(list, test1);
+	}
+	mu_assert(List_count(list) == NUM_NODES + 1, "Wrong count on push.");
+
+	List_destroy(list);
+	return NULL;
+}
+
+
+char *test_shared_pool()
+{
+	ListNodePool *pool = ListNodePool_create(LIST_POOL_MIN_CHUNK);
+	List *a = List_create_pooled(pool);
+	List *b = List_create_pooled(pool);
+	mu_assert(a->pool == pool && b->pool == pool, "Pool not shared.");
+	mu_assert(pool->refs == 3, "Lists should take pool references.");
+	ListNodePool_release(pool);
+
+	List_push(a, test1);
+	List_push(b, test2);
+	ListNode *node = a->first;
+	List_destroy(a);
+	mu_assert(pool->refs == 1, "Destroy should release the pool.");
+
+	// a's node went back to the shared free list
+	List_push(b, test1);
+	mu_assert(b->last == node, "Node from destroyed list not reused.");
+	mu_assert(List_count(b) == 2, "Wrong count on shared pool list.");
+
+	List_destroy(b);
+	return NULL;
+}
+
+
+/// the tail pointers must match the ends of the chains they shortcut
+static int tails_match(ListNodePool *pool, int *chunks, int *free_nodes)
+{
+	ListNodeChunk *chunk = pool->chunks;
+	ListNode *node = pool->free_nodes;
+	*chunks = 0;
+	*free_nodes = 0;
+	for(; chunk != NULL; chunk = chunk->next) {
+		(*chunks)++;
+		if(chunk->next == NULL && chunk != pool->chunks_tail) return 0;
+	}
+	for(; node != NULL; node = node->next) {
+		(*free_nodes)++;
+		if(node->next == NULL && node != pool->free_tail) return 0;
+	}
+	return 1;
+}
+
+
+char *test_adopt()
+{
+	ListNodePool *pool = ListNodePool_create(LIST_POOL_MIN_CHUNK);
+	ListNodePool *donor = ListNodePool_create(LIST_POOL_MIN_CHUNK);
+	int chunks = 0;
+	int free_nodes = 0;
+	ListNode *nodes[100];
+	int i;
+
+	mu_assert(ListNodePool_alloc_run(pool, 4) != NULL, "Run failed.");
+	for(i = 0; i < 100; i++) {
+		nodes[i] = ListNodePool_alloc(donor);
+	}
+	for(i = 0; i < 100; i += 3) {
+		ListNodePool_free(donor, nodes[i]);
+	}
+	mu_assert(ListNodePool_alloc_run(donor, 8) != NULL, "Run failed.");
+	mu_assert(tails_match(donor, &chunks, &free_nodes),
+			"Donor tails out of date.");
+	mu_assert(free_nodes == 34, "Wrong donor free count.");
+	int donor_chunks = chunks;
+
+	ListNodePool_adopt(pool, donor);
+	mu_assert(donor->chunks == NULL && donor->free_nodes == NULL,
+			"Donor should be empty.");
+	mu_assert(tails_match(pool, &chunks, &free_nodes),
+			"Pool tails out of date after adopt.");
+	mu_assert(chunks == donor_chunks + 1, "Chunks lost in adopt.");
+	mu_assert(free_nodes == 34, "Free nodes lost in adopt.");
+
+	// the donor stays usable, and adopting into a non-empty free list
+	// keeps the tail of the receiving list
+	ListNodePool_free(donor, ListNodePool_alloc(donor));
+	ListNodePool_adopt(pool, donor);
+	mu_assert(tails_match(pool, &chunks, &free_nodes),
+			"Pool tails out of date after second adopt.");
+	mu_assert(free_nodes == 35, "Free nodes lost in second adopt.");
+
+	ListNodePool_release(donor);
+	ListNodePool_release(pool);
+	return NULL;
+}
+
+
+char *all_tests() {
+	mu_suite_start();
+
+	mu_run_test(test_alloc_free);
+	mu_run_test(test_chunk_growth);
+	mu_run_test(test_list_recycles);
+	mu_run_test(test_shared_pool);
+	mu_run_test(test_adopt);
+
+	return NULL;
+}
+
+RUN_TESTS(all_tests);
@@ -1,7 +1,18 @@
 #include "minunit.h"
 #include <collect/list.h>
+#include <collect/list_algos.h>
+#include <collect/list_pool.h>
+#include <collect/task_pool.h>
 #include <assert.h>
+#include <string.h>
 
+#define SORT_NUM_VALUES 100000
+#define SEED 42
+#define TS_THREADS 4
+#define TS_VALUES 20000
+#define TS_BATCH 32
+#define CURSOR_VALUES 1000
+#define CURSOR_OPS 20000
 
 static List *list = NULL;
 char *test1 = "test1 data";
@@ -104,6 +115,690 @@ char *test_shift()
 }
 
 
+int numcmp(int *l, int *r) {
+	return *l < *r ? -1 : *l > *r;
+}
+
+int is_numsorted(List *nums, List_compare cmp)
+{
+	int count = 0;
+	ListNode *prev = NULL;
+	LIST_FOREACH(nums, first, next, cur) {
+		if(cur->prev != prev) {
+			return 0;
+		}
+		if(prev && cmp(prev->value, cur->value) > 0) {
+			return 0;
+		}
+		prev = cur;
+		count++;
+	}
+
+	return prev == nums->last && count == nums->count;
+}
+
+char *test_merge_sort()
+{
+	List *words = List_create();
+	List_push(words, test3);
+	List_push(words, test1);
+	List_push(words, test2);
+
+	ListSortResult rc = List_merge_sort(words, (List_compare)strcmp);
+	mu_assert(rc == SUCCESS, "Merge sort failed.");
+	mu_assert(List_get(words, 0) == test1, "Wrong value at index 0.");
+	mu_assert(List_get(words, 1) == test2, "Wrong value at index 1.");
+	mu_assert(List_get(words, 2) == test3, "Wrong value at index 2.");
+	mu_assert(List_last(words) == test3, "Wrong last after sort.");
+	List_destroy(words);
+
+	// should work on an empty list
+	words = List_create();
+	rc = List_merge_sort(words, (List_compare)strcmp);
+	mu_assert(rc == SUCCESS, "Merge sort failed on empty list.");
+	mu_assert(words->first == NULL && words->last == NULL,
+			"Empty list should stay empty.");
+	List_destroy(words);
+
+	return NULL;
+}
+
+char *test_large_merge_sort()
+{
+	int i;
+	List *nums = List_create();
+	int *n = malloc(SORT_NUM_VALUES * sizeof(int));
+	srand(SEED);
+	for(i = 0; i < SORT_NUM_VALUES; i++) {
+		n[i] = rand();
+		List_push(nums, &n[i]);
+	}
+	ListNode *first = nums->first;
+
+	ListSortResult rc = List_merge_sort(nums, (List_compare)numcmp);
+	mu_assert(rc == SUCCESS, "Merge sort failed.");
+	mu_assert(is_numsorted(nums, (List_compare)numcmp),
+			"Numbers are not sorted after merge sort.");
+
+	// nodes are relinked, not reallocated
+	ListNode *cur = NULL;
+	for(cur = nums->first; cur != NULL && cur != first; cur = cur->next);
+	mu_assert(cur == first, "Sort did not reuse the original nodes.");
+
+	// equal keys keep their insertion order, which is address order here
+	for(i = 0; i < SORT_NUM_VALUES; i++) {
+		n[i] = rand() % 64;
+	}
+	List_destroy(nums);
+	nums = List_create();
+	for(i = 0; i < SORT_NUM_VALUES; i++) {
+		List_push(nums, &n[i]);
+	}
+	rc = List_merge_sort(nums, (List_compare)numcmp);
+	mu_assert(rc == SUCCESS, "Merge sort failed.");
+	for(cur = nums->first; cur->next != NULL; cur = cur->next) {
+		if(numcmp(cur->value, cur->next->value) == 0) {
+			mu_assert((int *)cur->value < (int *)cur->next->value,
+					"Merge sort is not stable.");
+		}
+	}
+
+	List_destroy(nums);
+	free(n);
+	return NULL;
+}
+
+
+char *test_parallel_merge_sort()
+{
+	// just over the array sort cutoff, and long enough to split merges
+	int sizes[] = { 4096, 4097, SORT_NUM_VALUES };
+	TaskPool *pool = TaskPool_create(4);
+	int *n = malloc(SORT_NUM_VALUES * sizeof(int));
+	int s, i;
+
+	for(s = 0; s < 3; s++) {
+		List *nums = List_create();
+		List *expect = List_create();
+		for(i = 0; i < sizes[s]; i++) {
+			n[i] = rand() % 64;
+			List_push(nums, &n[i]);
+			List_push(expect, &n[i]);
+		}
+
+		// List_sort is serial and stable, so the two orders must agree
+		// value for value, duplicates included
+		mu_assert(List_sort(expect, (List_compare)numcmp) == 0,
+				"Reference sort failed.");
+		mu_assert(List_merge_sort_on(nums, (List_compare)numcmp, pool) ==
+				SUCCESS, "Parallel merge sort failed.");
+		mu_assert(is_numsorted(nums, (List_compare)numcmp),
+				"Numbers are not sorted after merge sort.");
+
+		ListNode *cur = nums->first;
+		ListNode *ref = expect->first;
+		for(; cur != NULL && ref != NULL; cur = cur->next, ref = ref->next) {
+			mu_assert(cur->value == ref->value,
+					"Parallel merge sort disagrees with serial sort.");
+		}
+		mu_assert(cur == NULL && ref == NULL, "Sorted lengths differ.");
+
+		List_destroy(nums);
+		List_destroy(expect);
+	}
+
+	free(n);
+	TaskPool_destroy(pool);
+	return NULL;
+}
+
+
+char *test_ts()
+{
+	void *values[] = {test1, test2, test3};
+	void *out[4];
+	List *shared = List_create();
+
+	List_push_ts(shared, test2);
+	List_unshift_ts(shared, test1);
+	mu_assert(List_count_ts(shared) == 2, "Wrong count.");
+	mu_assert(List_get_ts(shared, 1) == test2, "Wrong value at index 1.");
+	mu_assert(List_get_ts(shared, 2) == NULL, "Out of bounds get.");
+	mu_assert(List_pop_ts(shared) == test2, "Wrong popped value.");
+	mu_assert(List_shift_ts(shared) == test1, "Wrong shifted value.");
+	mu_assert(List_shift_ts(shared) == NULL, "Shifted from empty list.");
+
+	mu_assert(List_push_batch_ts(shared, values, 3) == 3,
+			"Wrong batch push count.");
+	mu_assert(List_last(shared) == test3, "Batch push out of order.");
+	mu_assert(List_shift_batch_ts(shared, out, 2) == 2,
+			"Wrong batch shift count.");
+	mu_assert(out[0] == test1 && out[1] == test2, "Batch shift out of order.");
+	mu_assert(List_shift_batch_ts(shared, out, 4) == 1,
+			"Batch shift past the end.");
+	mu_assert(out[0] == test3, "Wrong last batch value.");
+	mu_assert(shared->first == NULL && shared->last == NULL,
+			"Drained list should be empty.");
+
+	List_destroy(shared);
+	return NULL;
+}
+
+static void *ts_produce(void *arg)
+{
+	List *shared = arg;
+	void *batch[TS_BATCH];
+	long i;
+	int n = 0;
+
+	for(i = 1; i <= TS_VALUES; i++) {
+		if(i % 2) {
+			List_push_ts(shared, (void *)i);
+			continue;
+		}
+		batch[n++] = (void *)i;
+		if(n == TS_BATCH) {
+			List_push_batch_ts(shared, batch, n);
+			n = 0;
+		}
+	}
+	List_push_batch_ts(shared, batch, n);
+	return NULL;
+}
+
+static void *ts_consume(void *arg)
+{
+	List *shared = arg;
+	void *batch[TS_BATCH];
+	long sum = 0;
+	long taken = 0;
+	int i;
+
+	while(taken < TS_VALUES) {
+		int n = List_shift_batch_ts(shared, batch, TS_BATCH);
+		for(i = 0; i < n; i++) {
+			sum += (long)batch[i];
+		}
+		taken += n;
+	}
+	return (void *)sum;
+}
+
+char *test_ts_threads()
+{
+	pthread_t producers[TS_THREADS];
+	pthread_t consumers[TS_THREADS];
+	List *shared = List_create();
+	long sum = 0;
+	long i;
+
+	for(i = 0; i < TS_THREADS; i++) {
+		pthread_create(&consumers[i], NULL, ts_consume, shared);
+		pthread_create(&producers[i], NULL, ts_produce, shared);
+	}
+	for(i = 0; i < TS_THREADS; i++) {
+		void *part = NULL;
+		pthread_join(producers[i], NULL);
+		pthread_join(consumers[i], &part);
+		sum += (long)part;
+	}
+
+	mu_assert(sum == (long)TS_THREADS * TS_VALUES * (TS_VALUES + 1) / 2,
+			"Values lost or duplicated between threads.");
+	mu_assert(List_count(shared) == 0, "List should be drained.");
+
+	List_destroy(shared);
+	return NULL;
+}
+
+
+static int join_values[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+
+/// push join_values[from] up to, but not including, join_values[to]
+static List *range_list(List *list, int from, int to)
+{
+	for(; from < to; from++) {
+		List_push(list, &join_values[from]);
+	}
+	return list;
+}
+
+/// the list's links are consistent and its values are the digits of expect
+static int list_matches(List *list, const char *expect)
+{
+	int count = 0;
+	ListNode *prev = NULL;
+	ListNode *cur = NULL;
+	for(cur = list->first; cur != NULL; cur = cur->next) {
+		if(cur->prev != prev || expect[count] == '\0' ||
+				*(int *)cur->value != expect[count] - '0') {
+			return 0;
+		}
+		prev = cur;
+		count++;
+	}
+	return prev == list->last && count == list->count &&
+		expect[count] == '\0';
+}
+
+char *test_concat()
+{
+	List *dest = range_list(List_create(), 0, 3);
+	List *src = range_list(List_create(), 3, 7);
+	ListNode *moved = src->first;
+
+	mu_assert(List_concat(dest, src) == 0, "Concat failed.");
+	mu_assert(list_matches(dest, "0123456"), "Wrong list after concat.");
+	mu_assert(dest->first->next->next->next == moved,
+			"Concat should relink, not copy.");
+	mu_assert(list_matches(src, ""), "Source should be empty.");
+	mu_assert(ListNodePool_is_private(src->pool),
+			"Emptied source should keep a private pool.");
+
+	// both lists stay usable, and each frees what it now owns
+	range_list(src, 7, 10);
+	List *empty = List_create();
+	mu_assert(List_concat(dest, empty) == 0, "Empty concat failed.");
+	List_destroy(empty);
+	mu_assert(list_matches(src, "789"), "Source broken after concat.");
+	List_destroy(src);
+	mu_assert(List_shift(dest) == &join_values[0], "Wrong first value.");
+	List_destroy(dest);
+
+	return NULL;
+}
+
+char *test_splice()
+{
+	List *dest = range_list(List_create(), 0, 4);
+	List *src = range_list(List_create(), 4, 10);
+
+	// 6, 7, 8 go between 1 and 2
+	ListNode *first = src->first->next->next;
+	ListNode *last = first->next->next;
+	mu_assert(List_splice(dest, dest->first->next->next, src, first, last,
+				3) == 0, "Splice failed.");
+	mu_assert(list_matches(dest, "0167823"), "Wrong list after splice.");
+	mu_assert(list_matches(src, "459"), "Wrong source after splice.");
+	mu_assert(dest->pool == src->pool, "Spliced lists should share a pool.");
+
+	// counted splice onto the end, then back to the front of src
+	mu_assert(List_splice(dest, NULL, src, src->first, src->last, -1) == 0,
+			"Counted splice failed.");
+	mu_assert(list_matches(dest, "0167823459"), "Wrong appended splice.");
+	mu_assert(List_splice(src, NULL, dest, dest->first, dest->first, 1) == 0,
+			"Single node splice failed.");
+	mu_assert(list_matches(src, "0"), "Wrong single node splice.");
+
+	List_destroy(src);
+	List_destroy(dest);
+
+	return NULL;
+}
+
+char *test_splice_copy()
+{
+	ListNodePool *pool_a = ListNodePool_create(LIST_POOL_MIN_CHUNK);
+	ListNodePool *pool_b = ListNodePool_create(LIST_POOL_MIN_CHUNK);
+	List *a = range_list(List_create_pooled(pool_a), 0, 5);
+	List *b = range_list(List_create_pooled(pool_b), 5, 10);
+	// the pools stay shared, so the lists can't adopt one another's nodes
+	ListNode *moved = b->first;
+
+	mu_assert(List_concat(a, b) == 0, "Copying concat failed.");
+	mu_assert(list_matches(a, "0123456789"), "Wrong copied concat.");
+	mu_assert(a->first->next->next->next->next->next != moved,
+			"Nodes crossed between unrelated pools.");
+	mu_assert(list_matches(b, ""), "Source should be empty.");
+
+	mu_assert(List_splice(b, NULL, a, a->first, a->first->next, 2) == 0,
+			"Copying splice failed.");
+	mu_assert(list_matches(b, "01"), "Wrong copied splice.");
+	mu_assert(a->pool == pool_a && b->pool == pool_b,
+			"Lists changed pools.");
+
+	List_destroy(a);
+	List_destroy(b);
+	ListNodePool_release(pool_a);
+	ListNodePool_release(pool_b);
+
+	return NULL;
+}
+
+char *test_split_at()
+{
+	List *left = range_list(List_create(), 0, 10);
+
+	List *right = List_split_at(left, 6);
+	mu_assert(right != NULL, "Split failed.");
+	mu_assert(list_matches(left, "012345"), "Wrong left half.");
+	mu_assert(list_matches(right, "6789"), "Wrong right half.");
+
+	List *empty = List_split_at(right, 4);
+	mu_assert(empty != NULL && list_matches(empty, ""),
+			"Split at the end should be empty.");
+	List *all = List_split_at(left, 0);
+	mu_assert(list_matches(left, "") && list_matches(all, "012345"),
+			"Split at the start should take everything.");
+	mu_assert(List_split_at(all, 7) == NULL, "Split out of bounds.");
+
+	List_destroy(empty);
+	List_destroy(all);
+	List_destroy(right);
+	List_destroy(left);
+
+	return NULL;
+}
+
+
+char *test_get_cursor()
+{
+	static int values[CURSOR_VALUES];
+	int shadow[CURSOR_VALUES * 2];
+	int count = 0;
+	int i;
+	List *nums = List_create();
+
+	for(i = 0; i < CURSOR_VALUES; i++) {
+		values[i] = i;
+		List_push(nums, &values[i]);
+	}
+
+	// sequential access steps from the cached node
+	for(i = 0; i < CURSOR_VALUES; i++) {
+		mu_assert(List_get(nums, i) == &values[i], "Wrong forward value.");
+		mu_assert(nums->cursor_index == i, "Cursor not cached.");
+	}
+	for(i = CURSOR_VALUES - 1; i >= 0; i--) {
+		mu_assert(List_get(nums, i) == &values[i], "Wrong backward value.");
+	}
+	mu_assert(List_get(nums, CURSOR_VALUES) == NULL, "Out of bounds get.");
+
+	// random edits mixed with lookups must keep the cache honest
+	List_destroy(nums);
+	nums = List_create();
+	srand(SEED);
+	for(i = 0; i < CURSOR_OPS; i++) {
+		int op = rand() % 6;
+		int at = count > 0 ? rand() % count : 0;
+		int value = rand() % CURSOR_VALUES;
+		if(op == 0 && count < CURSOR_VALUES * 2) {
+			List_push(nums, &values[value]);
+			shadow[count++] = value;
+		} else if(op == 1 && count < CURSOR_VALUES * 2) {
+			List_unshift(nums, &values[value]);
+			memmove(shadow + 1, shadow, count * sizeof(int));
+			shadow[0] = value;
+			count++;
+		} else if(op == 2 && count > 0) {
+			List_remove(nums, List_get_node(nums, at));
+			memmove(shadow + at, shadow + at + 1,
+					(count - at - 1) * sizeof(int));
+			count--;
+		} else if(op == 3 && count > 0) {
+			List_shift(nums);
+			memmove(shadow, shadow + 1, (count - 1) * sizeof(int));
+			count--;
+		} else if(count > 0) {
+			mu_assert(List_get(nums, at) == &values[shadow[at]],
+					"Stale cursor after an edit.");
+		}
+	}
+	mu_assert(List_count(nums) == count, "Wrong count after edits.");
+
+	List_destroy(nums);
+	return NULL;
+}
+
+char *test_list_cursor()
+{
+	ListCursor cursor;
+	List *nums = range_list(List_create(), 0, 10);
+
+	ListCursor_init(&cursor, nums);
+	mu_assert(ListCursor_value(&cursor) == &join_values[0],
+			"Cursor should start at the first node.");
+	mu_assert(ListCursor_seek(&cursor, 3) != NULL, "Seek forward failed.");
+	mu_assert(ListCursor_value(&cursor) == &join_values[3],
+			"Wrong value after seek.");
+	mu_assert(ListCursor_seek(&cursor, -2) != NULL, "Seek back failed.");
+	mu_assert(ListCursor_index(&cursor) == 1, "Wrong index after seek.");
+	mu_assert(ListCursor_seek(&cursor, 9) == NULL, "Seek past the end.");
+	mu_assert(ListCursor_index(&cursor) == 1, "Failed seek moved cursor.");
+	mu_assert(ListCursor_seek_to(&cursor, 8) != NULL, "Seek to failed.");
+	mu_assert(ListCursor_value(&cursor) == &join_values[8],
+			"Wrong value after seek to.");
+
+	// drop the even values while walking
+	ListCursor_init(&cursor, nums);
+	while(ListCursor_node(&cursor) != NULL) {
+		if(*(int *)ListCursor_value(&cursor) % 2 == 0) {
+			ListCursor_remove(&cursor);
+		} else if(ListCursor_seek(&cursor, 1) == NULL) {
+			break;
+		}
+	}
+	mu_assert(list_matches(nums, "13579"), "Wrong values after removal.");
+
+	ListCursor_init(&cursor, List_create());
+	mu_assert(ListCursor_node(&cursor) == NULL, "Empty list cursor.");
+	mu_assert(ListCursor_seek(&cursor, 0) == NULL, "Seek in empty list.");
+	List_destroy(cursor.list);
+
+	List_destroy(nums);
+	return NULL;
+}
+
+
+/// the nodes are laid out first to last in one block, and linked properly
+static int is_contiguous(List *nums)
+{
+	ListNode *cur = NULL;
+	for(cur = nums->first; cur != NULL && cur->next != NULL; cur = cur->next) {
+		if(cur->next != cur + 1 || cur->next->prev != cur) {
+			return 0;
+		}
+	}
+	return cur == nums->last;
+}
+
+char *test_compact()
+{
+	int i;
+	int *n = malloc(SORT_NUM_VALUES * sizeof(int));
+	List *nums = List_create();
+
+	mu_assert(List_compact(nums) == 0, "Compacting an empty list failed.");
+
+	// sorting scatters the nodes across the pool
+	srand(SEED);
+	for(i = 0; i < SORT_NUM_VALUES; i++) {
+		n[i] = rand();
+		List_push(nums, &n[i]);
+	}
+	List_merge_sort(nums, (List_compare)numcmp);
+	List_get(nums, 10);
+	ListNodePool *old_pool = nums->pool;
+
+	mu_assert(List_compact(nums) == 0, "Compact failed.");
+	mu_assert(is_contiguous(nums), "Nodes are not contiguous.");
+	mu_assert(is_numsorted(nums, (List_compare)numcmp),
+			"Compact changed the order.");
+	mu_assert(nums->pool != old_pool && ListNodePool_is_private(nums->pool),
+			"A private pool should be replaced.");
+	mu_assert(List_get(nums, 10) == nums->first[10].value,
+			"Stale cursor after compact.");
+
+	// the list keeps working normally afterwards
+	void *first = List_shift(nums);
+	List_push(nums, first);
+	mu_assert(List_count(nums) == SORT_NUM_VALUES, "Wrong count.");
+	List_destroy(nums);
+
+	// a shared pool keeps the old nodes for reuse
+	ListNodePool *shared = ListNodePool_create(LIST_POOL_MIN_CHUNK);
+	nums = List_create_pooled(shared);
+	for(i = 0; i < 1000; i++) {
+		List_unshift(nums, &n[i]);
+	}
+	mu_assert(List_compact(nums) == 0, "Shared compact failed.");
+	mu_assert(nums->pool == shared, "Shared pool was replaced.");
+	mu_assert(is_contiguous(nums), "Shared nodes are not contiguous.");
+	mu_assert(List_first(nums) == &n[999] && List_last(nums) == &n[0],
+			"Compact changed the order.");
+	mu_assert(shared->free_nodes != NULL, "Old nodes were not recycled.");
+
+	List_destroy(nums);
+	ListNodePool_release(shared);
+	free(n);
+	return NULL;
+}
+
+
+char *test_merge_k()
+{
+	int sizes[] = {1, 2, 3, 7, 16};
+	int s = 0;
+	int i = 0;
+	int j = 0;
+
+	for(s = 0; s < 5; s++) {
+		int k = sizes[s];
+		List *lists[16];
+		// lists take consecutive blocks of n, so address order is the
+		// order in which equal values must come out
+		int *n = malloc(k * 200 * sizeof(int));
+		int total = 0;
+
+		srand(SEED + k);
+		for(i = 0; i < k; i++) {
+			lists[i] = List_create();
+			int count = i % 4 == 3 ? 0 : rand() % 200;
+			int v = 0;
+			for(j = 0; j < count; j++) {
+				v += rand() % 3;
+				n[i * 200 + j] = v;
+				List_push(lists[i], &n[i * 200 + j]);
+			}
+			total += count;
+		}
+		ListNode *node = lists[k - 1]->first;
+
+		mu_assert(List_merge_k(lists, k, (List_compare)numcmp) == 0,
+				"Merge failed.");
+		mu_assert(List_count(lists[0]) == total, "Merge lost values.");
+		mu_assert(is_numsorted(lists[0], (List_compare)numcmp),
+				"Merged list not sorted.");
+		LIST_FOREACH(lists[0], first, next, cur) {
+			if(cur->next && numcmp(cur->value, cur->next->value) == 0) {
+				mu_assert((int *)cur->value < (int *)cur->next->value,
+						"Merge is not stable.");
+			}
+		}
+		for(i = 1; i < k; i++) {
+			mu_assert(list_matches(lists[i], ""), "Input not emptied.");
+			mu_assert(ListNodePool_is_private(lists[i]->pool),
+					"Emptied inputs should keep private pools.");
+		}
+		if(node != NULL && k > 1) {
+			int found = 0;
+			ListNode *cur = NULL;
+			for(cur = lists[0]->first; cur != NULL; cur = cur->next) {
+				found |= cur == node;
+			}
+			mu_assert(found, "Merge should relink, not copy.");
+		}
+
+		for(i = 0; i < k; i++) {
+			List_destroy(lists[i]);
+		}
+		free(n);
+	}
+
+	// lists on two unrelated shared pools are merged by copying
+	ListNodePool *pool_a = ListNodePool_create(LIST_POOL_MIN_CHUNK);
+	ListNodePool *pool_b = ListNodePool_create(LIST_POOL_MIN_CHUNK);
+	List *lists[2];
+	lists[0] = List_create_pooled(pool_a);
+	lists[1] = List_create_pooled(pool_b);
+	range_list(lists[0], 0, 3);
+	range_list(lists[1], 1, 6);
+	List_get(lists[0], 2);
+
+	mu_assert(List_merge_k(lists, 2, (List_compare)numcmp) == 0,
+			"Copying merge failed.");
+	mu_assert(list_matches(lists[0], "01122345"), "Wrong copied merge.");
+	mu_assert(list_matches(lists[1], ""), "Copied input not emptied.");
+	mu_assert(*(int *)List_get(lists[0], 2) == 1, "Stale cursor.");
+	mu_assert(lists[1]->pool == pool_b && pool_b->free_nodes != NULL,
+			"Copied nodes should return to their pool.");
+
+	List_destroy(lists[0]);
+	List_destroy(lists[1]);
+	ListNodePool_release(pool_a);
+	ListNodePool_release(pool_b);
+	return NULL;
+}
+
+
+char *test_merge_k_failure()
+{
+	ListNodePool *pool_a = ListNodePool_create(LIST_POOL_MIN_CHUNK);
+	ListNodePool *pool_b = ListNodePool_create(LIST_POOL_MIN_CHUNK);
+	ListNodePool *pool_c = ListNodePool_create(LIST_POOL_MIN_CHUNK);
+	List *lists[4];
+
+	// a private input and a copied one come before the bad input, and
+	// neither may have changed hands when the merge gives up
+	lists[0] = range_list(List_create_pooled(pool_a), 0, 3);
+	lists[1] = range_list(List_create(), 3, 6);
+	lists[2] = range_list(List_create_pooled(pool_b), 6, 9);
+	lists[3] = NULL;
+	ListNodePool *own = lists[1]->pool;
+
+	mu_assert(List_merge_k(lists, 4, (List_compare)numcmp) == -1,
+			"Merge should fail on a null list.");
+	mu_assert(lists[1]->pool == own && own->chunks != NULL,
+			"Failed merge took over a private pool.");
+	mu_assert(pool_a->free_nodes != NULL,
+			"Copied nodes should return to dest's pool.");
+
+	List_destroy(lists[0]);
+	ListNodePool_release(pool_a);
+	mu_assert(list_matches(lists[1], "345"), "Private input changed.");
+	mu_assert(list_matches(lists[2], "678"), "Shared input changed.");
+
+	// a private dest would join the first shared pool, so the copy goes
+	// there, but dest keeps its own pool until the merge can't fail
+	lists[0] = range_list(List_create(), 0, 3);
+	lists[3] = range_list(List_create_pooled(pool_c), 9, 10);
+	own = lists[0]->pool;
+	List *bad[5] = {lists[0], lists[1], lists[2], lists[3], NULL};
+
+	mu_assert(List_merge_k(bad, 5, (List_compare)numcmp) == -1,
+			"Merge should fail on a null list.");
+	mu_assert(lists[0]->pool == own && ListNodePool_is_private(own),
+			"Failed merge moved dest's pool.");
+	mu_assert(pool_b->free_nodes != NULL,
+			"Copied nodes should return to the joined pool.");
+	mu_assert(list_matches(lists[0], "012"), "Dest changed.");
+
+	mu_assert(List_merge_k(lists, 4, (List_compare)numcmp) == 0,
+			"Merge failed.");
+	mu_assert(list_matches(lists[0], "0123456789"), "Wrong merge.");
+	mu_assert(lists[0]->pool == pool_b, "Dest should join the shared pool.");
+	mu_assert(lists[3]->pool == pool_c, "Copied input changed pools.");
+
+	int i = 0;
+	for(i = 0; i < 4; i++) {
+		List_destroy(lists[i]);
+	}
+	ListNodePool_release(pool_b);
+	ListNodePool_release(pool_c);
+	return NULL;
+}
+
+
 char *all_tests() {
 	mu_suite_start();
 
@@ -113,6 +808,20 @@ char *all_tests() {
 	mu_run_test(test_remove);
 	mu_run_test(test_shift);
 	mu_run_test(test_destroy);
+	mu_run_test(test_merge_sort);
+	mu_run_test(test_large_merge_sort);
+	mu_run_test(test_parallel_merge_sort);
+	mu_run_test(test_ts);
+	mu_run_test(test_ts_threads);
+	mu_run_test(test_concat);
+	mu_run_test(test_splice);
+	mu_run_test(test_splice_copy);
+	mu_run_test(test_split_at);
+	mu_run_test(test_get_cursor);
+	mu_run_test(test_list_cursor);
+	mu_run_test(test_compact);
+	mu_run_test(test_merge_k);
+	mu_run_test(test_merge_k_failure);
 
 	return NULL;
 }
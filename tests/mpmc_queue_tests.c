@@ -0,0 +1,206 @@
+#include "minunit.h"
+#include <collect/mpmc_queue.h>
+#include <stdint.h>
+
+#define NUM_PRODUCERS 4
+#define NUM_CONSUMERS 4
+#define ITEMS_PER_PRODUCER 50000
+#define BATCH 16
+
+static MPMCQueue *queue = NULL;
+
+
+char *test_create()
+{
+	queue = MPMCQueue_create(5);
+	mu_assert(queue != NULL, "Failed to create queue.");
+	mu_assert(MPMCQueue_capacity(queue) == 8,
+			"Capacity not rounded to a power of two.");
+	mu_assert(MPMCQueue_count(queue) == 0, "New queue isn't empty.");
+
+	return NULL;
+}
+
+
+char *test_try()
+{
+	void *out = NULL;
+	intptr_t i;
+
+	mu_assert(MPMCQueue_try_dequeue(queue, &out) == -1,
+			"Dequeued from an empty queue.");
+
+	for(i = 1; i <= 8; i++) {
+		mu_assert(MPMCQueue_try_enqueue(queue, (void *)i) == 0,
+				"Failed to enqueue.");
+	}
+	mu_assert(MPMCQueue_try_enqueue(queue, (void *)9) == -1,
+			"Enqueued onto a full queue.");
+	mu_assert(MPMCQueue_count(queue) == 8, "Wrong count when full.");
+
+	// values come out in order, and wrap around the ring
+	for(i = 1; i <= 20; i++) {
+		mu_assert(MPMCQueue_try_dequeue(queue, &out) == 0,
+				"Failed to dequeue.");
+		mu_assert(out == (void *)i, "Values out of order.");
+		MPMCQueue_try_enqueue(queue, (void *)(i + 8));
+	}
+	for(i = 21; i <= 28; i++) {
+		mu_assert(MPMCQueue_dequeue(queue) == (void *)i,
+				"Blocking dequeue out of order.");
+	}
+	mu_assert(MPMCQueue_count(queue) == 0, "Queue should be empty.");
+
+	return NULL;
+}
+
+
+char *test_batch()
+{
+	void *values[12];
+	void *out[12];
+	intptr_t i;
+
+	for(i = 0; i < 12; i++) {
+		values[i] = (void *)(i + 1);
+	}
+
+	// only as many as fit
+	mu_assert(MPMCQueue_try_enqueue_batch(queue, values, 12) == 8,
+			"Batch enqueue overfilled the queue.");
+	mu_assert(MPMCQueue_try_dequeue_batch(queue, out, 3) == 3,
+			"Wrong batch dequeue count.");
+	mu_assert(MPMCQueue_try_enqueue_batch(queue, values + 8, 4) == 3,
+			"Wrong batch enqueue count.");
+	mu_assert(MPMCQueue_dequeue_batch(queue, out + 3, 12) == 8,
+			"Blocking batch should take everything queued.");
+	for(i = 0; i < 11; i++) {
+		mu_assert(out[i] == (void *)(i + 1), "Batch out of order.");
+	}
+	mu_assert(MPMCQueue_try_dequeue_batch(queue, out, 12) == 0,
+			"Batch dequeued from an empty queue.");
+
+	return NULL;
+}
+
+
+char *test_destroy()
+{
+	MPMCQueue_destroy(queue);
+	queue = NULL;
+
+	return NULL;
+}
+
+
+typedef struct Consumer {
+	MPMCQueue *queue;
+	long sum;
+	long count;
+} Consumer;
+
+static void *produce(void *arg)
+{
+	intptr_t first = (intptr_t)arg;
+	void *batch[BATCH];
+	intptr_t i;
+	int n = 0;
+
+	// alternate single and batched enqueues
+	for(i = first; i < first + ITEMS_PER_PRODUCER; i++) {
+		if(i % 2) {
+			MPMCQueue_enqueue(queue, (void *)i);
+			continue;
+		}
+		batch[n++] = (void *)i;
+		if(n == BATCH) {
+			MPMCQueue_enqueue_batch(queue, batch, n);
+			n = 0;
+		}
+	}
+	MPMCQueue_enqueue_batch(queue, batch, n);
+	return NULL;
+}
+
+static void *consume(void *arg)
+{
+	Consumer *consumer = arg;
+	void *batch[BATCH];
+	int i;
+
+	while(1) {
+		int n = MPMCQueue_dequeue_batch(consumer->queue, batch, BATCH);
+		for(i = 0; i < n; i++) {
+			// NULL is the signal to stop.  Only stop signals can follow
+			// one, so hand any extras on to the other consumers.
+			if(batch[i] == NULL) {
+				MPMCQueue_enqueue_batch(consumer->queue, batch + i + 1,
+						n - i - 1);
+				return NULL;
+			}
+			consumer->sum += (intptr_t)batch[i];
+			consumer->count++;
+		}
+	}
+}
+
+char *test_threads()
+{
+	pthread_t producers[NUM_PRODUCERS];
+	pthread_t consumers[NUM_CONSUMERS];
+	Consumer state[NUM_CONSUMERS];
+	long sum = 0;
+	long count = 0;
+	long expect = 0;
+	long i;
+
+	// small, so producers and consumers both have to wait
+	queue = MPMCQueue_create(64);
+	for(i = 0; i < NUM_CONSUMERS; i++) {
+		state[i].queue = queue;
+		state[i].sum = 0;
+		state[i].count = 0;
+		pthread_create(&consumers[i], NULL, consume, &state[i]);
+	}
+	for(i = 0; i < NUM_PRODUCERS; i++) {
+		pthread_create(&producers[i], NULL, produce,
+				(void *)(i * ITEMS_PER_PRODUCER + 1));
+	}
+	for(i = 0; i < NUM_PRODUCERS; i++) {
+		pthread_join(producers[i], NULL);
+	}
+	for(i = 0; i < NUM_CONSUMERS; i++) {
+		MPMCQueue_enqueue(queue, NULL);
+	}
+	for(i = 0; i < NUM_CONSUMERS; i++) {
+		pthread_join(consumers[i], NULL);
+		sum += state[i].sum;
+		count += state[i].count;
+	}
+
+	for(i = 1; i <= NUM_PRODUCERS * ITEMS_PER_PRODUCER; i++) {
+		expect += i;
+	}
+	mu_assert(count == NUM_PRODUCERS * ITEMS_PER_PRODUCER,
+			"Lost or duplicated values.");
+	mu_assert(sum == expect, "Values corrupted in transit.");
+
+	MPMCQueue_destroy(queue);
+	return NULL;
+}
+
+
+char *all_tests()
+{
+	mu_suite_start();
+
+	mu_run_test(test_create);
+	mu_run_test(test_try);
+	mu_run_test(test_batch);
+	mu_run_test(test_destroy);
+	mu_run_test(test_threads);
+
+	return NULL;
+}
+
+RUN_TESTS(all_tests);
@@ -0,0 +1,204 @@
+#include "minunit.h"
+#include <collect/radix_sort.h>
+
+#define NUM_VALUES 1000
+#define LARGE_NUM_VALUES 200000
+#define SEED 42
+
+static TaskPool *pool = NULL;
+
+typedef struct Record {
+    int key;
+    char pad[20];
+} Record;
+
+uint64_t int_key(void *value)
+{
+    return (uint32_t)*(int *)value ^ 0x80000000u;
+}
+
+uint64_t low_byte_key(void *value)
+{
+    return *(int *)value & 0xff;
+}
+
+uint64_t raw_key(void *value)
+{
+    return (uint32_t)*(int *)value;
+}
+
+uint64_t low_12_key(void *value)
+{
+    return *(int *)value & 0xfff;
+}
+
+uint64_t record_key(void *value)
+{
+    return (uint32_t)((Record *)value)->key;
+}
+
+/// sorted by key, with equal keys in address order
+static int list_sorted(List *list, Radix_key key)
+{
+    int count = 0;
+    ListNode *prev = NULL;
+    ListNode *cur = NULL;
+    for(cur = list->first; cur != NULL; cur = cur->next) {
+        if(cur->prev != prev) {
+            return 0;
+        }
+        if(prev != NULL) {
+            uint64_t a = key(prev->value);
+            uint64_t b = key(cur->value);
+            if(a > b || (a == b && prev->value > cur->value)) {
+                return 0;
+            }
+        }
+        prev = cur;
+        count++;
+    }
+    return prev == list->last && count == list->count;
+}
+
+static List *create_nums(int *n, int count, int spread)
+{
+    List *list = List_create();
+    int i = 0;
+    for(i = 0; i < count; i++) {
+        n[i] = rand() % spread - spread / 2;
+        List_push(list, &n[i]);
+    }
+    return list;
+}
+
+char *test_list_radix_sort()
+{
+    int *n = malloc(LARGE_NUM_VALUES * sizeof(int));
+
+    List *list = create_nums(n, NUM_VALUES, 2000);
+    ListNode *node = list->first;
+    mu_assert(List_radix_sort(list, int_key, 32, NULL) == 0,
+            "Radix sort failed.");
+    mu_assert(list_sorted(list, int_key), "List not sorted.");
+    mu_assert(*(int *)List_first(list) < 0, "Negative keys not first.");
+
+    ListNode *cur = NULL;
+    for(cur = list->first; cur != NULL && cur != node; cur = cur->next);
+    mu_assert(cur == node, "Sort did not reuse the original nodes.");
+    mu_assert(*(int *)List_get(list, 10) <= *(int *)List_get(list, 11),
+            "Stale cursor after sort.");
+    List_destroy(list);
+
+    // only the low key_bits take part, and the rest keep their order
+    list = create_nums(n, NUM_VALUES, 1 << 20);
+    mu_assert(List_radix_sort(list, low_byte_key, 8, NULL) == 0,
+            "Radix sort failed.");
+    mu_assert(list_sorted(list, low_byte_key), "Not sorted by low byte.");
+    List_destroy(list);
+
+    // key_bits that aren't a whole number of digits mask off the rest
+    list = create_nums(n, NUM_VALUES, 1 << 20);
+    mu_assert(List_radix_sort(list, raw_key, 12, NULL) == 0,
+            "Radix sort failed.");
+    mu_assert(list_sorted(list, low_12_key), "Not sorted by low 12 bits.");
+    List_destroy(list);
+
+    // large enough to count on the pool
+    list = create_nums(n, LARGE_NUM_VALUES, 1000);
+    mu_assert(List_radix_sort(list, int_key, 32, pool) == 0,
+            "Parallel radix sort failed.");
+    mu_assert(List_count(list) == LARGE_NUM_VALUES, "Sort lost values.");
+    mu_assert(list_sorted(list, int_key), "Large list not sorted.");
+    List_destroy(list);
+
+    list = List_create();
+    mu_assert(List_radix_sort(list, int_key, 32, NULL) == 0,
+            "Radix sort of an empty list failed.");
+    List_push(list, &n[0]);
+    mu_assert(List_radix_sort(list, int_key, 0, NULL) == 0,
+            "Single values need no sorting.");
+    List_push(list, &n[1]);
+    mu_assert(List_radix_sort(list, int_key, 65, NULL) == -1,
+            "Bad key_bits not caught.");
+    mu_assert(List_radix_sort(list, NULL, 32, NULL) == -1,
+            "Missing key function not caught.");
+    List_destroy(list);
+
+    free(n);
+    return NULL;
+}
+
+char *test_darray_radix_sort()
+{
+    int i = 0;
+    int rc = 0;
+
+    DArray *nums = DArray_create_inline(sizeof(int), 16);
+    for(i = 0; i < LARGE_NUM_VALUES; i++) {
+        int v = rand() - RAND_MAX / 2;
+        DArray_push(nums, &v);
+    }
+    rc = DArray_radix_sort(nums, int_key, 32, pool);
+    mu_assert(rc == 0, "Radix sort failed.");
+    for(i = 1; i < DArray_count(nums); i++) {
+        mu_assert(*(int *)DArray_get(nums, i - 1) <=
+                *(int *)DArray_get(nums, i), "Inline ints not sorted.");
+    }
+    DArray_destroy(nums);
+
+    // pointer storage moves the element pointers
+    DArray *ptrs = DArray_create(sizeof(int), 16);
+    for(i = 0; i < NUM_VALUES; i++) {
+        int *el = DArray_new(ptrs);
+        *el = rand() % 100;
+        DArray_push(ptrs, el);
+    }
+    mu_assert(DArray_radix_sort(ptrs, int_key, 32, NULL) == 0,
+            "Radix sort failed.");
+    for(i = 1; i < DArray_count(ptrs); i++) {
+        int *a = DArray_get(ptrs, i - 1);
+        int *b = DArray_get(ptrs, i);
+        mu_assert(*a <= *b, "Pointers not sorted.");
+    }
+    DArray_clear_destroy(ptrs);
+
+    // wide records move whole, and equal keys keep their order
+    DArray *records = DArray_create_inline(sizeof(Record), 16);
+    for(i = 0; i < NUM_VALUES; i++) {
+        Record r;
+        r.key = rand() % 50;
+        memcpy(r.pad, &i, sizeof(i));
+        DArray_push(records, &r);
+    }
+    mu_assert(DArray_radix_sort(records, record_key, 16, NULL) == 0,
+            "Radix sort of records failed.");
+    for(i = 1; i < DArray_count(records); i++) {
+        Record *prev = DArray_get(records, i - 1);
+        Record *cur = DArray_get(records, i);
+        int prev_at = 0;
+        int cur_at = 0;
+        memcpy(&prev_at, prev->pad, sizeof(int));
+        memcpy(&cur_at, cur->pad, sizeof(int));
+        mu_assert(prev->key < cur->key ||
+                (prev->key == cur->key && prev_at < cur_at),
+                "Records not sorted stably.");
+    }
+    DArray_destroy(records);
+
+    return NULL;
+}
+
+char *all_tests()
+{
+    mu_suite_start();
+    srand(SEED);
+    pool = TaskPool_create(4);
+
+    mu_run_test(test_list_radix_sort);
+    mu_run_test(test_darray_radix_sort);
+
+    TaskPool_destroy(pool);
+    return NULL;
+}
+
+RUN_TESTS(all_tests);
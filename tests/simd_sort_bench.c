@@ -0,0 +1,118 @@
+#include <collect/darray_algos.h>
+#include <collect/simd_sort.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NUM_VALUES 1000000
+#define SEED 42
+
+/// Sorting NUM_VALUES random int32 keys with qsort, DArray_sort, a
+/// DARRAY_DEFINE_SORT typed sort, and DArray_sort_i32 at every level the
+/// machine supports.
+
+DARRAY_DEFINE_SORT(typed_sort_i32, int32_t, (a > b) - (a < b))
+
+static int cmp_qsort(const void *a, const void *b)
+{
+    int32_t x = *(const int32_t *)a;
+    int32_t y = *(const int32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int cmp_darray(void *a, void *b)
+{
+    int32_t x = *(int32_t *)a;
+    int32_t y = *(int32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int sort_qsort(DArray *array)
+{
+    qsort(array->data, array->end, sizeof(int32_t), cmp_qsort);
+    return 0;
+}
+
+static int sort_darray(DArray *array)
+{
+    return DArray_sort(array, cmp_darray);
+}
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int32_t *input = NULL;
+static int32_t *expect = NULL;
+static DArray *array = NULL;
+
+/// time one sort of the input, returning -1 if it sorted wrongly
+static double time_sort(int (*sort)(DArray *))
+{
+    memcpy(array->data, input, NUM_VALUES * sizeof(int32_t));
+    array->end = NUM_VALUES;
+
+    double start = now();
+    if(sort(array) != 0) {
+        return -1;
+    }
+    double elapsed = now() - start;
+
+    if(memcmp(array->data, expect, NUM_VALUES * sizeof(int32_t)) != 0) {
+        return -1;
+    }
+    return elapsed;
+}
+
+static int report(const char *name, double elapsed)
+{
+    if(elapsed < 0) {
+        printf("%18s %10s\n", name, "FAILED");
+        return 1;
+    }
+    printf("%18s %10.1f\n", name, NUM_VALUES / elapsed / 1e6);
+    return 0;
+}
+
+int main()
+{
+    static const char *level_names[] = { "scalar", "sse4.2", "avx2",
+        "avx512f" };
+    char name[32];
+    int failed = 0;
+    int i = 0;
+
+    srand(SEED);
+    input = malloc(NUM_VALUES * sizeof(int32_t));
+    expect = malloc(NUM_VALUES * sizeof(int32_t));
+    array = DArray_create_inline(sizeof(int32_t), NUM_VALUES);
+    for(i = 0; i < NUM_VALUES; i++) {
+        input[i] = (int32_t)(((uint32_t)rand() << 16) ^ (uint32_t)rand());
+    }
+    memcpy(expect, input, NUM_VALUES * sizeof(int32_t));
+    qsort(expect, NUM_VALUES, sizeof(int32_t), cmp_qsort);
+
+    printf("%d int32 keys (Mkeys/s)\n", NUM_VALUES);
+    failed += report("qsort", time_sort(sort_qsort));
+    failed += report("DArray_sort", time_sort(sort_darray));
+    failed += report("typed introsort", time_sort(typed_sort_i32));
+
+    SimdSortLevel detected = SimdSort_detected_level();
+    SimdSortLevel level = SIMD_SORT_SCALAR;
+    for(level = SIMD_SORT_SCALAR; level <= detected; level++) {
+        SimdSort_set_level(level);
+        snprintf(name, sizeof(name), "sort_i32 %s", level_names[level]);
+        failed += report(name, time_sort(DArray_sort_i32));
+    }
+    SimdSort_set_level(detected);
+
+    DArray_destroy(array);
+    free(input);
+    free(expect);
+    return failed;
+}
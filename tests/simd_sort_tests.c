@@ -0,0 +1,216 @@
+#include "minunit.h"
+#include <collect/simd_sort.h>
+#include <math.h>
+#include <string.h>
+
+#define SEED 42
+
+// around the cutoff, around vector and merge widths, and a large odd size
+static const int sizes[] = { 0, 1, 2, 17, 63, 64, 65, 100, 129, 1000, 4099,
+    100003 };
+#define NUM_SIZES (int)(sizeof(sizes) / sizeof(sizes[0]))
+
+static int cmp_i32(const void *a, const void *b)
+{
+    int32_t x = *(const int32_t *)a;
+    int32_t y = *(const int32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int cmp_f32(const void *a, const void *b)
+{
+    float x = *(const float *)a;
+    float y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+static uint64_t rand_u64()
+{
+    return ((uint64_t)rand() << 42) ^ ((uint64_t)rand() << 21) ^ rand();
+}
+
+/// fill an inline array with count random values of width bytes, few
+/// distinct ones when dups is set, and keep a qsorted copy in expect
+static DArray *create_values(size_t width, int count, int dups,
+        void *expect, int (*cmp)(const void *, const void *))
+{
+    DArray *array = DArray_create_inline(width, count + 1);
+    int i = 0;
+    for(i = 0; i < count; i++) {
+        uint64_t r = dups ? (uint64_t)(rand() % 8) : rand_u64();
+        int32_t i32 = (int32_t)r;
+        float f32 = dups ? (float)r - 4.0f : (float)(int32_t)r / 1024.0f;
+        if(width == sizeof(uint64_t)) {
+            DArray_push(array, &r);
+        } else if(cmp == cmp_f32) {
+            DArray_push(array, &f32);
+        } else {
+            DArray_push(array, &i32);
+        }
+    }
+    memcpy(expect, array->data, count * width);
+    qsort(expect, count, width, cmp);
+    return array;
+}
+
+static char *check_sort(int (*sort)(DArray *), size_t width,
+        int (*cmp)(const void *, const void *))
+{
+    void *expect = malloc(sizes[NUM_SIZES - 1] * width);
+    int i = 0;
+    int dups = 0;
+
+    for(dups = 0; dups < 2; dups++) {
+        for(i = 0; i < NUM_SIZES; i++) {
+            DArray *array = create_values(width, sizes[i], dups, expect,
+                    cmp);
+            mu_assert(sort(array) == 0, "Sort failed.");
+            mu_assert(DArray_count(array) == sizes[i], "Sort lost values.");
+            mu_assert(memcmp(array->data, expect, sizes[i] * width) == 0,
+                    "Values not sorted.");
+            DArray_destroy(array);
+        }
+    }
+
+    free(expect);
+    return NULL;
+}
+
+char *test_levels()
+{
+    SimdSortLevel detected = SimdSort_detected_level();
+    mu_assert(SimdSort_level() == detected,
+            "Sorts should start at the detected level.");
+    mu_assert(SimdSort_set_level(SIMD_SORT_AVX512 + 1) == detected,
+            "Unknown levels should fall back to the detected level.");
+    mu_assert(SimdSort_set_level(SIMD_SORT_SCALAR) == SIMD_SORT_SCALAR,
+            "Scalar is always available.");
+    mu_assert(SimdSort_level() == SIMD_SORT_SCALAR, "Level not set.");
+    SimdSort_set_level(detected);
+
+    return NULL;
+}
+
+char *test_sort()
+{
+    SimdSortLevel detected = SimdSort_detected_level();
+    SimdSortLevel level = SIMD_SORT_SCALAR;
+    char *message = NULL;
+
+    // every kernel this machine can run, not just the best one
+    for(level = SIMD_SORT_SCALAR; level <= detected; level++) {
+        SimdSort_set_level(level);
+        message = check_sort(DArray_sort_i32, sizeof(int32_t), cmp_i32);
+        if(message) break;
+        message = check_sort(DArray_sort_u64, sizeof(uint64_t), cmp_u64);
+        if(message) break;
+        message = check_sort(DArray_sort_f32, sizeof(float), cmp_f32);
+        if(message) break;
+    }
+
+    SimdSort_set_level(detected);
+    return message;
+}
+
+char *test_extremes()
+{
+    int32_t i32[] = { INT32_MAX, INT32_MIN, 0, -1, INT32_MAX, 1 };
+    uint64_t u64[] = { UINT64_MAX, 0, 1ull << 63, UINT64_MAX, 5, 0 };
+    DArray *ints = DArray_create_inline(sizeof(int32_t), 100);
+    DArray *longs = DArray_create_inline(sizeof(uint64_t), 100);
+    int i = 0;
+
+    // the padding equals the largest key, so the runs are full of ties
+    for(i = 0; i < 100; i++) {
+        DArray_push(ints, &i32[i % 6]);
+        DArray_push(longs, &u64[i % 6]);
+    }
+    mu_assert(DArray_sort_i32(ints) == 0, "Sort failed.");
+    mu_assert(DArray_sort_u64(longs) == 0, "Sort failed.");
+    for(i = 1; i < 100; i++) {
+        mu_assert(((int32_t *)ints->data)[i - 1] <=
+                ((int32_t *)ints->data)[i], "Ints not sorted.");
+        mu_assert(((uint64_t *)longs->data)[i - 1] <=
+                ((uint64_t *)longs->data)[i], "Longs not sorted.");
+    }
+    mu_assert(((int32_t *)ints->data)[0] == INT32_MIN, "Lost INT32_MIN.");
+    mu_assert(((int32_t *)ints->data)[99] == INT32_MAX, "Lost INT32_MAX.");
+    mu_assert(((uint64_t *)longs->data)[99] == UINT64_MAX,
+            "Lost UINT64_MAX.");
+
+    DArray_destroy(ints);
+    DArray_destroy(longs);
+    return NULL;
+}
+
+char *test_nan()
+{
+    DArray *floats = DArray_create_inline(sizeof(float), 1000);
+    float value = 0;
+    int i = 0;
+    int nans = 0;
+    double sum = 0;
+
+    for(i = 0; i < 1000; i++) {
+        value = i % 7 == 0 ? NAN : (float)(rand() % 1000);
+        DArray_push(floats, &value);
+        if(!isnan(value)) sum += value;
+    }
+
+    mu_assert(DArray_sort_f32(floats) == 0, "Sort failed.");
+    for(i = 0; i < 1000; i++) {
+        value = ((float *)floats->data)[i];
+        if(isnan(value)) {
+            nans++;
+        } else {
+            mu_assert(nans == 0, "NaNs should sort last.");
+            mu_assert(i == 0 || ((float *)floats->data)[i - 1] <= value,
+                    "Floats not sorted.");
+            sum -= value;
+        }
+    }
+    mu_assert(nans == 143, "NaNs were lost.");
+    mu_assert(sum == 0, "Values were lost.");
+
+    DArray_destroy(floats);
+    return NULL;
+}
+
+char *test_bad_arrays()
+{
+    DArray *pointers = DArray_create(sizeof(void *), 10);
+    DArray *wide = DArray_create_inline(sizeof(uint64_t), 10);
+
+    mu_assert(DArray_sort_i32(NULL) == -1, "Should reject NULL.");
+    mu_assert(DArray_sort_u64(pointers) == -1,
+            "Should reject pointer mode arrays.");
+    mu_assert(DArray_sort_i32(wide) == -1, "Should reject the wrong width.");
+    mu_assert(DArray_sort_f32(wide) == -1, "Should reject the wrong width.");
+
+    DArray_destroy(pointers);
+    DArray_destroy(wide);
+    return NULL;
+}
+
+char *all_tests()
+{
+    mu_suite_start();
+    srand(SEED);
+
+    mu_run_test(test_levels);
+    mu_run_test(test_sort);
+    mu_run_test(test_extremes);
+    mu_run_test(test_nan);
+    mu_run_test(test_bad_arrays);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests);
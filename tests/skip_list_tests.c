@@ -0,0 +1,210 @@
+#include "minunit.h"
+#include <collect/skip_list.h>
+#include <string.h>
+
+#define NUM_VALUES 2000
+#define NUM_OPS 20000
+#define SEED 42
+
+static SkipList *list = NULL;
+static int values[NUM_VALUES];
+char *test1 = "test1 data";
+char *test2 = "test2 data";
+char *test3 = "test3 data";
+
+
+int numcmp(int *l, int *r) {
+	return *l < *r ? -1 : *l > *r;
+}
+
+/// the widths of every level add up to the positions of the nodes they
+/// join, and the last node is where it should be
+static int widths_consistent(SkipList *skip)
+{
+	int i;
+	for(i = 0; i < skip->level; i++) {
+		SkipListNode *node = skip->head;
+		int pos = -1;
+		while(node->links[i].next != NULL) {
+			SkipListNode *next = node->links[i].next;
+			pos += node->links[i].width;
+			if(SkipList_node_at(skip, pos) != next) {
+				return 0;
+			}
+			node = next;
+		}
+		if(pos + node->links[i].width != skip->count) {
+			return 0;
+		}
+	}
+	return skip->count == 0 ? skip->last == NULL :
+		skip->last == SkipList_node_at(skip, skip->count - 1);
+}
+
+
+char *test_create()
+{
+	list = SkipList_create(NULL);
+	mu_assert(list != NULL, "Failed to create list.");
+	mu_assert(SkipList_count(list) == 0, "New list isn't empty.");
+
+	return NULL;
+}
+
+
+char *test_destroy()
+{
+	SkipList_destroy(list);
+
+	return NULL;
+}
+
+
+char *test_push_pop()
+{
+	SkipList_push(list, test1);
+	SkipList_push(list, test2);
+	SkipList_unshift(list, test3);
+	mu_assert(SkipList_first(list) == test3, "Wrong first value.");
+	mu_assert(SkipList_last(list) == test2, "Wrong last value.");
+	mu_assert(SkipList_get(list, 1) == test1, "Wrong value at index 1.");
+	mu_assert(SkipList_get(list, 3) == NULL, "Out of bounds get.");
+
+	mu_assert(SkipList_pop(list) == test2, "Wrong value on pop.");
+	mu_assert(SkipList_shift(list) == test3, "Wrong value on shift.");
+	mu_assert(SkipList_shift(list) == test1, "Wrong value on shift.");
+	mu_assert(SkipList_shift(list) == NULL, "Shift from empty list.");
+	mu_assert(SkipList_count(list) == 0, "Wrong count after removal.");
+	mu_assert(SkipList_last(list) == NULL, "Empty list has a last value.");
+
+	return NULL;
+}
+
+
+char *test_positional()
+{
+	static int shadow[NUM_VALUES];
+	int count = 0;
+	int i;
+	SkipList *skip = SkipList_create(NULL);
+
+	for(i = 0; i < NUM_VALUES; i++) {
+		values[i] = i;
+	}
+
+	// random inserts and removals, checked against a plain array
+	srand(SEED);
+	for(i = 0; i < NUM_OPS; i++) {
+		int at = rand() % (count + 1);
+		if(count < NUM_VALUES && (count == 0 || rand() % 3 != 0)) {
+			int v = rand() % NUM_VALUES;
+			mu_assert(SkipList_insert(skip, at, &values[v]) == 0,
+					"Insert failed.");
+			memmove(shadow + at + 1, shadow + at,
+					(count - at) * sizeof(int));
+			shadow[at] = v;
+			count++;
+		} else {
+			at = at % count;
+			mu_assert(SkipList_remove(skip, at) == &values[shadow[at]],
+					"Removed the wrong value.");
+			memmove(shadow + at, shadow + at + 1,
+					(count - at - 1) * sizeof(int));
+			count--;
+		}
+	}
+
+	mu_assert(SkipList_count(skip) == count, "Wrong count.");
+	mu_assert(widths_consistent(skip), "Link widths are inconsistent.");
+	for(i = 0; i < count; i++) {
+		mu_assert(SkipList_get(skip, i) == &values[shadow[i]],
+				"Wrong value by index.");
+	}
+	i = 0;
+	SKIP_LIST_FOREACH(skip, cur) {
+		mu_assert(cur->value == &values[shadow[i++]],
+				"Wrong value while iterating.");
+	}
+
+	SkipList_destroy(skip);
+	return NULL;
+}
+
+
+char *test_sorted()
+{
+	static int keys[NUM_VALUES];
+	int i;
+	SkipList *skip = SkipList_create((List_compare)numcmp);
+
+	srand(SEED);
+	for(i = 0; i < NUM_VALUES; i++) {
+		keys[i] = rand() % 100;
+		mu_assert(SkipList_insert_sorted(skip, &keys[i]) >= 0,
+				"Sorted insert failed.");
+	}
+	mu_assert(widths_consistent(skip), "Link widths are inconsistent.");
+
+	// sorted, and equal keys keep insertion order, which is address order
+	int *prev = NULL;
+	SKIP_LIST_FOREACH(skip, cur) {
+		int *value = cur->value;
+		if(prev != NULL) {
+			mu_assert(*prev <= *value, "Values are not sorted.");
+			mu_assert(*prev != *value || prev < value,
+					"Sorted insert is not stable.");
+		}
+		prev = value;
+	}
+
+	// rank agrees with a count of smaller keys
+	int key;
+	for(key = -1; key <= 100; key++) {
+		int smaller = 0;
+		for(i = 0; i < NUM_VALUES; i++) {
+			smaller += keys[i] < key;
+		}
+		mu_assert(SkipList_rank(skip, &key) == smaller, "Wrong rank.");
+
+		int found = SkipList_find(skip, &key);
+		SkipListNode *node = SkipList_lower_bound(skip, &key);
+		if(node != NULL && *(int *)node->value == key) {
+			mu_assert(found == smaller, "Wrong find index.");
+		} else {
+			mu_assert(found == -1, "Found a missing key.");
+		}
+	}
+
+	// iterate the values in [10, 20)
+	int lo = 10;
+	int in_range = 0;
+	SkipListNode *node = NULL;
+	for(node = SkipList_lower_bound(skip, &lo);
+			node != NULL && *(int *)node->value < 20;
+			node = SkipListNode_next(node)) {
+		in_range++;
+	}
+	int expect = 0;
+	for(i = 0; i < NUM_VALUES; i++) {
+		expect += keys[i] >= 10 && keys[i] < 20;
+	}
+	mu_assert(in_range == expect, "Wrong number of values in range.");
+
+	SkipList_destroy(skip);
+	return NULL;
+}
+
+
+char *all_tests() {
+	mu_suite_start();
+
+	mu_run_test(test_create);
+	mu_run_test(test_push_pop);
+	mu_run_test(test_destroy);
+	mu_run_test(test_positional);
+	mu_run_test(test_sorted);
+
+	return NULL;
+}
+
+RUN_TESTS(all_tests);
@@ -0,0 +1,116 @@
+#include "minunit.h"
+#include <collect/task_pool.h>
+#include <assert.h>
+
+#define NUM_TASKS 1000
+#define FIB_N 20
+#define FIB_CUTOFF 8
+
+static TaskPool *pool = NULL;
+
+
+void *square(void *arg)
+{
+	long n = (long)arg;
+	return (void *)(n * n);
+}
+
+long fib_serial(long n)
+{
+	return n < 2 ? n : fib_serial(n - 1) + fib_serial(n - 2);
+}
+
+// nested fork/join, with every level joining on the pool
+void *fib(void *arg)
+{
+	long n = (long)arg;
+	if(n < FIB_CUTOFF) {
+		return (void *)fib_serial(n);
+	}
+
+	Task left;
+	TaskPool_spawn(pool, &left, fib, (void *)(n - 1));
+	long right = (long)fib((void *)(n - 2));
+	return (void *)((long)TaskPool_join(pool, &left) + right);
+}
+
+
+char *test_create()
+{
+	pool = TaskPool_create(4);
+	mu_assert(pool != NULL, "Failed to create pool.");
+	mu_assert(TaskPool_worker_count(pool) == 4, "Wrong worker count.");
+
+	return NULL;
+}
+
+
+char *test_spawn_join()
+{
+	static Task tasks[NUM_TASKS];
+	long i;
+	for(i = 0; i < NUM_TASKS; i++) {
+		TaskPool_spawn(pool, &tasks[i], square, (void *)i);
+	}
+	for(i = 0; i < NUM_TASKS; i++) {
+		long result = (long)TaskPool_join(pool, &tasks[i]);
+		mu_assert(result == i * i, "Wrong task result.");
+	}
+
+	return NULL;
+}
+
+
+char *test_nested()
+{
+	long result = (long)fib((void *)FIB_N);
+	mu_assert(result == fib_serial(FIB_N), "Wrong result from nested tasks.");
+
+	return NULL;
+}
+
+
+char *test_inline()
+{
+	Task task;
+	TaskPool_spawn(NULL, &task, square, (void *)7);
+	mu_assert(task.done, "Task should run inline without a pool.");
+	mu_assert((long)TaskPool_join(NULL, &task) == 49, "Wrong inline result.");
+
+	return NULL;
+}
+
+
+char *test_default()
+{
+	TaskPool *def = TaskPool_default();
+	mu_assert(def != NULL, "Failed to start the default pool.");
+	mu_assert(def == TaskPool_default(), "Default pool should be shared.");
+	mu_assert(TaskPool_worker_count(def) >= 1, "Default pool has no workers.");
+
+	return NULL;
+}
+
+
+char *test_destroy()
+{
+	TaskPool_destroy(pool);
+
+	return NULL;
+}
+
+
+char *all_tests() {
+	mu_suite_start();
+
+	mu_run_test(test_create);
+	mu_run_test(test_spawn_join);
+	mu_run_test(test_nested);
+	mu_run_test(test_inline);
+	mu_run_test(test_default);
+	mu_run_test(test_destroy);
+
+	return NULL;
+}
+
+RUN_TESTS(all_tests);
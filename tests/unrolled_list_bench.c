@@ -0,0 +1,60 @@
+#include <collect/list.h>
+#include <collect/unrolled_list.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#define NUM_VALUES 4000000
+#define ROUNDS 10
+
+/// Traversal throughput of List against UnrolledList holding the same
+/// values.
+
+static double now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main()
+{
+	List *list = List_create();
+	UnrolledList *unrolled = UnrolledList_create();
+	intptr_t i;
+	int round;
+	intptr_t list_sum = 0;
+	intptr_t unrolled_sum = 0;
+
+	// interleave the pushes, so both lists' nodes are scattered alike
+	for(i = 0; i < NUM_VALUES; i++) {
+		List_push(list, (void *)i);
+		UnrolledList_push(unrolled, (void *)i);
+	}
+
+	double start = now();
+	for(round = 0; round < ROUNDS; round++) {
+		LIST_FOREACH(list, first, next, cur) {
+			list_sum += (intptr_t)cur->value;
+		}
+	}
+	double list_time = now() - start;
+
+	start = now();
+	for(round = 0; round < ROUNDS; round++) {
+		UNROLLED_LIST_FOREACH(unrolled, node, j) {
+			unrolled_sum += (intptr_t)node->values[j];
+		}
+	}
+	double unrolled_time = now() - start;
+
+	printf("%d values x %d traversals (Mvalues/s)\n", NUM_VALUES, ROUNDS);
+	printf("%14s %10.1f\n", "List", NUM_VALUES * (double)ROUNDS /
+			list_time / 1e6);
+	printf("%14s %10.1f\n", "UnrolledList", NUM_VALUES * (double)ROUNDS /
+			unrolled_time / 1e6);
+
+	List_destroy(list);
+	UnrolledList_destroy(unrolled);
+	return list_sum == unrolled_sum ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+#include "minunit.h"
+#include <collect/unrolled_list.h>
+#include <stdint.h>
+#include <string.h>
+
+#define NUM_VALUES 2000
+#define NUM_OPS 50000
+#define SEED 42
+
+static UnrolledList *list = NULL;
+char *test1 = "test1 data";
+char *test2 = "test2 data";
+char *test3 = "test3 data";
+
+
+/// counts, links and alignment of every node agree with the list
+static int nodes_consistent(UnrolledList *unrolled)
+{
+	UnrolledNode *prev = NULL;
+	UnrolledNode *node = NULL;
+	int count = 0;
+	for(node = unrolled->first; node != NULL; node = node->next) {
+		if(node->prev != prev || node->count < 1 ||
+				node->count > UNROLLED_NODE_VALUES ||
+				(uintptr_t)node % UNROLLED_NODE_ALIGN != 0) {
+			return 0;
+		}
+		count += node->count;
+		prev = node;
+	}
+	return prev == unrolled->last && count == unrolled->count;
+}
+
+
+char *test_create()
+{
+	list = UnrolledList_create();
+	mu_assert(list != NULL, "Failed to create list.");
+
+	return NULL;
+}
+
+
+char *test_destroy()
+{
+	UnrolledList_destroy(list);
+
+	return NULL;
+}
+
+
+char *test_push_pop()
+{
+	UnrolledList_push(list, test1);
+	UnrolledList_push(list, test2);
+	UnrolledList_unshift(list, test3);
+	mu_assert(UnrolledList_first(list) == test3, "Wrong first value.");
+	mu_assert(UnrolledList_last(list) == test2, "Wrong last value.");
+	mu_assert(UnrolledList_get(list, 1) == test1, "Wrong value at index 1.");
+	mu_assert(UnrolledList_get(list, 3) == NULL, "Out of bounds get.");
+
+	mu_assert(UnrolledList_pop(list) == test2, "Wrong value on pop.");
+	mu_assert(UnrolledList_shift(list) == test3, "Wrong value on shift.");
+	mu_assert(UnrolledList_remove(list, 0) == test1, "Wrong removed value.");
+	mu_assert(UnrolledList_pop(list) == NULL, "Pop from empty list.");
+	mu_assert(UnrolledList_count(list) == 0, "Wrong count after removal.");
+	mu_assert(list->first == NULL && list->last == NULL,
+			"Empty list still has nodes.");
+
+	return NULL;
+}
+
+
+char *test_random_ops()
+{
+	static int values[NUM_VALUES];
+	static int shadow[NUM_VALUES];
+	int count = 0;
+	int i;
+	UnrolledList *unrolled = UnrolledList_create();
+
+	for(i = 0; i < NUM_VALUES; i++) {
+		values[i] = i;
+	}
+
+	srand(SEED);
+	for(i = 0; i < NUM_OPS; i++) {
+		int op = rand() % 5;
+		int v = rand() % NUM_VALUES;
+		int at = count > 0 ? rand() % count : 0;
+		if(op == 0 && count < NUM_VALUES) {
+			UnrolledList_push(unrolled, &values[v]);
+			shadow[count++] = v;
+		} else if(op == 1 && count < NUM_VALUES) {
+			UnrolledList_unshift(unrolled, &values[v]);
+			memmove(shadow + 1, shadow, count * sizeof(int));
+			shadow[0] = v;
+			count++;
+		} else if(op == 2 && count > 0) {
+			mu_assert(UnrolledList_pop(unrolled) == &values[shadow[--count]],
+					"Wrong value on pop.");
+		} else if(op == 3 && count > 0) {
+			mu_assert(UnrolledList_remove(unrolled, at) ==
+					&values[shadow[at]], "Wrong removed value.");
+			memmove(shadow + at, shadow + at + 1,
+					(count - at - 1) * sizeof(int));
+			count--;
+		} else if(count > 0) {
+			mu_assert(UnrolledList_get(unrolled, at) == &values[shadow[at]],
+					"Wrong value by index.");
+		}
+	}
+
+	mu_assert(UnrolledList_count(unrolled) == count, "Wrong count.");
+	mu_assert(nodes_consistent(unrolled), "Nodes are inconsistent.");
+	i = 0;
+	UNROLLED_LIST_FOREACH(unrolled, node, j) {
+		mu_assert(node->values[j] == &values[shadow[i++]],
+				"Wrong value while iterating.");
+	}
+	mu_assert(i == count, "Iteration missed values.");
+
+	UnrolledList_destroy(unrolled);
+	return NULL;
+}
+
+
+char *test_clear_destroy()
+{
+	int i;
+	UnrolledList *owned = UnrolledList_create();
+	for(i = 0; i < 100; i++) {
+		UnrolledList_push(owned, malloc(sizeof(int)));
+	}
+	UnrolledList_clear_destroy(owned);
+
+	return NULL;
+}
+
+
+char *all_tests() {
+	mu_suite_start();
+
+	mu_run_test(test_create);
+	mu_run_test(test_push_pop);
+	mu_run_test(test_destroy);
+	mu_run_test(test_random_ops);
+	mu_run_test(test_clear_destroy);
+
+	return NULL;
+}
+
+RUN_TESTS(all_tests);